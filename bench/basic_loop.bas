@@ -0,0 +1,6 @@
+10 REM BASIC INTERPRETER LOOP
+20 DIM A(100)
+30 FOR I=0 TO 100:A(I)=I*3.5:NEXT
+40 S=0:FOR I=0 TO 100:S=S+A(I)/7:NEXT
+50 A$="":FOR I=1 TO 20:A$=A$+CHR$(65+I):NEXT
+60 GOTO 30
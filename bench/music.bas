@@ -0,0 +1,6 @@
+10 REM YM2151 AND PSG PLAYBACK
+20 FMINIT:PSGINIT
+30 FMINST 0,11:PSGWAV 0,2
+40 FMPLAY 0,"T200O4CDEFGABO5C"
+50 PSGPLAY 0,"T200O3CEGCEGCEG"
+60 GOTO 40
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Runs every workload in this directory through "x16emu -bench" and prints
+# the reports. Usage: ./run.sh [<path to x16emu> [<frames>]]
+
+cd "$(dirname "$0")"
+EMU=${1:-../x16emu}
+FRAMES=${2:-600}
+
+SDCARD=$(mktemp -d)
+trap 'rm -rf "$SDCARD"' EXIT
+unzip -q -d "$SDCARD" ../sdcard.img.zip
+
+for bas in *.bas; do
+	echo "== $bas"
+	case $bas in
+		sdcard_*) extra="-sdcard $SDCARD/sdcard.img" ;;
+		*)        extra="" ;;
+	esac
+	"$EMU" -bench "$FRAMES" -bas "$bas" -run $extra
+done
@@ -0,0 +1,4 @@
+10 REM SD CARD FILE LOAD
+20 BSAVE "BENCH.BIN",8,1,$A000,$BFFF
+30 BLOAD "BENCH.BIN",8,1,$A000
+40 GOTO 30
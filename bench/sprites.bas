@@ -0,0 +1,16 @@
+10 REM 128 MOVING SPRITES
+20 FOR I=0 TO 511:VPOKE 1,I,I AND 255:NEXT
+30 FOR N=0 TO 127
+40 A=$FC00+8*N
+50 VPOKE 1,A+0,0:VPOKE 1,A+1,$80
+60 VPOKE 1,A+6,$0C:VPOKE 1,A+7,$50
+70 NEXT
+80 POKE $9F29,PEEK($9F29) OR $40
+90 T=T+1
+100 FOR N=0 TO 127
+110 A=$FC00+8*N
+120 X=(N*5+T)AND 511:Y=(N*3+T)AND 255
+130 VPOKE 1,A+2,X AND 255:VPOKE 1,A+3,X/256
+140 VPOKE 1,A+4,Y:VPOKE 1,A+5,0
+150 NEXT
+160 GOTO 90
@@ -0,0 +1,12 @@
+10 REM VERA FX AFFINE READS AND CACHE WRITES
+20 POKE $9F25,2*2:POKE $9F29,3:REM FX_CTRL: AFFINE ADDR1
+30 POKE $9F2A,0:POKE $9F2B,$40:REM TILE BASE, MAP BASE
+40 POKE $9F25,3*2:POKE $9F29,$80:POKE $9F2A,0:POKE $9F2B,$80:POKE $9F2C,0
+50 POKE $9F25,1:POKE $9F20,0:POKE $9F21,0:POKE $9F22,$10
+60 FOR I=0 TO 255:X=PEEK($9F24):NEXT
+70 POKE $9F25,2*2:POKE $9F29,$40:REM FX_CTRL: CACHE WRITE
+80 POKE $9F25,6*2:POKE $9F29,$55:POKE $9F2A,$AA:POKE $9F2B,$55:POKE $9F2C,$AA
+90 POKE $9F25,0:POKE $9F20,0:POKE $9F21,$40:POKE $9F22,$30
+100 FOR I=0 TO 255:POKE $9F23,0:NEXT
+110 POKE $9F25,2*2:POKE $9F29,0:POKE $9F25,0
+120 GOTO 20
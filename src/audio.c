@@ -13,6 +13,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUDIO_SSE2
+#endif
 
 #ifdef __EMSCRIPTEN__
 	#define SAMPLES_PER_BUFFER (1024)
@@ -28,6 +34,7 @@
 #define SAMPLE_BYTES (2 * sizeof(int16_t))
 #define SAMP_POS_MASK (SAMPLES_PER_BUFFER - 1)
 #define SAMP_POS_MASK_FRAC (((uint32_t)SAMPLES_PER_BUFFER << SAMP_POS_FRAC_BITS) - 1)
+#define MAX_TAPS 8
 
 // windowed sinc
 static const int16_t filter[512] = {
@@ -66,11 +73,23 @@ static const int16_t filter[512] = {
 };
 
 static SDL_AudioDeviceID audio_dev;
+// Set when rendering without an output device, for the WAV recorder only,
+// as fast as the emulation runs
+static bool audio_offline = false;
+
+// The buffer between audio_render() and the audio callback. Each side
+// only ever advances its own position, and publishes it after it is done
+// with the samples, so they never need to lock each other out. Positions
+// count stereo samples modulo twice the buffer size, which tells a full
+// buffer from an empty one. If the buffer is full, audio_render()
+// drops the new samples (an overrun); if it runs dry, the callback plays
+// silence (an underrun).
 static int16_t * buffer;
-static uint32_t buffer_size = 0;
-static uint32_t rdidx = 0;
-static uint32_t wridx = 0;
-static uint32_t buffer_written = 0;
+static uint32_t buffer_size = 0; // in stereo samples
+static SDL_atomic_t buffer_rdpos;
+static SDL_atomic_t buffer_wrpos;
+static SDL_atomic_t underruns;
+static SDL_atomic_t overruns;
 static uint32_t vera_samp_pos_rd = 0;
 static uint32_t vera_samp_pos_wr = 0;
 static uint32_t vera_samp_pos_hd = 0;
@@ -85,13 +104,28 @@ static uint32_t ym_samps_per_host_samps = 0;
 static uint32_t fs_samps_per_host_samps = 0;
 static uint32_t limiter_amp = 0;
 
-static int16_t psg_buf[2 * SAMPLES_PER_BUFFER];
-static int16_t pcm_buf[2 * SAMPLES_PER_BUFFER];
-static int16_t ym_buf[2 * SAMPLES_PER_BUFFER];
-static int16_t fs_buf[2 * SAMPLES_PER_BUFFER];
+// The source buffers repeat their first MAX_TAPS - 1 samples past the end,
+// so the resampler never has to wrap around within its window
+static int16_t psg_buf[2 * (SAMPLES_PER_BUFFER + MAX_TAPS - 1)];
+static int16_t pcm_buf[2 * (SAMPLES_PER_BUFFER + MAX_TAPS - 1)];
+static int16_t ym_buf[2 * (SAMPLES_PER_BUFFER + MAX_TAPS - 1)];
+static int16_t fs_buf[2 * (SAMPLES_PER_BUFFER + MAX_TAPS - 1)];
+
+enum audio_resampler audio_resampler = AUDIO_RESAMPLER_SINC4;
+
+// Filter taps for each of the 256 fractional positions between two source
+// samples. The output sample lies between taps (n / 2 - 1) and (n / 2).
+static int resampler_taps = 4;
+static int16_t resampler_coeffs[256][MAX_TAPS];
 
 uint32_t host_sample_rate = 0;
 
+static uint32_t
+buffer_distance(uint32_t from, uint32_t to)
+{
+	return (to + 2 * buffer_size - from) % (2 * buffer_size);
+}
+
 static void
 audio_callback(void *userdata, Uint8 *stream, int len)
 {
@@ -105,87 +139,337 @@ audio_callback(void *userdata, Uint8 *stream, int len)
 		return;
 	}
 
-	uint32_t spos = 0;
-	if (rdidx > wridx) {
-		uint32_t actual_len = SDL_min(len / SAMPLE_BYTES, (buffer_size - rdidx) / 2);
-		if (actual_len > 0) {
-			memcpy(&stream[spos], &buffer[rdidx], actual_len * SAMPLE_BYTES);
-			spos += actual_len * SAMPLE_BYTES;
-			len -= actual_len * SAMPLE_BYTES;
-			rdidx = (rdidx + actual_len * 2) % buffer_size;
-			buffer_written -= actual_len * 2;
-		}
+	// The acquire barrier makes the samples behind buffer_wrpos visible
+	// before they are read, the release barrier keeps those reads ahead of
+	// handing the space back to buffer_write().
+	const uint32_t rdpos = SDL_AtomicGet(&buffer_rdpos);
+	const uint32_t available = buffer_distance(rdpos, SDL_AtomicGet(&buffer_wrpos));
+	SDL_MemoryBarrierAcquire();
+	const uint32_t count = SDL_min(SAMPLES_PER_BUFFER, available);
+	const uint32_t idx = rdpos % buffer_size;
+	const uint32_t first = SDL_min(count, buffer_size - idx);
+	memcpy(stream, &buffer[idx * 2], first * SAMPLE_BYTES);
+	memcpy(stream + first * SAMPLE_BYTES, buffer, (count - first) * SAMPLE_BYTES);
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&buffer_rdpos, (rdpos + count) % (2 * buffer_size));
+
+	if (count < SAMPLES_PER_BUFFER) {
+		memset(stream + count * SAMPLE_BYTES, 0, (SAMPLES_PER_BUFFER - count) * SAMPLE_BYTES);
+		SDL_AtomicAdd(&underruns, 1);
 	}
-	uint32_t actual_len = SDL_min(len / SAMPLE_BYTES, (wridx - rdidx) / 2);
-	if (actual_len > 0) {
-		memcpy(&stream[spos], &buffer[rdidx], actual_len * SAMPLE_BYTES);
-		spos += actual_len * SAMPLE_BYTES;
-		len -= actual_len * SAMPLE_BYTES;
-		rdidx = (rdidx + actual_len * 2) % buffer_size;
-		buffer_written -= actual_len * 2;
+}
+
+// Queues samples for the audio callback
+static void
+buffer_write(const int16_t *samples, uint32_t count)
+{
+	const uint32_t wrpos = SDL_AtomicGet(&buffer_wrpos);
+	const uint32_t space = buffer_size - buffer_distance(SDL_AtomicGet(&buffer_rdpos), wrpos);
+	SDL_MemoryBarrierAcquire();
+	if (count > space) {
+		count = space;
+		SDL_AtomicAdd(&overruns, 1);
 	}
-	if (len > 0) memset(&stream[spos], 0, len);
+	const uint32_t idx = wrpos % buffer_size;
+	const uint32_t first = SDL_min(count, buffer_size - idx);
+	memcpy(&buffer[idx * 2], samples, first * SAMPLE_BYTES);
+	memcpy(buffer, samples + first * 2, (count - first) * SAMPLE_BYTES);
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&buffer_wrpos, (wrpos + count) % (2 * buffer_size));
 }
 
+// Number of times the audio callback ran out of samples, and the number of
+// times samples had to be dropped because the buffer was full
 void
-audio_init(const char *dev_name, int num_audio_buffers)
+audio_get_xruns(uint32_t *underrun_count, uint32_t *overrun_count)
 {
-	if (audio_dev > 0) {
-		audio_close();
+	*underrun_count = SDL_AtomicGet(&underruns);
+	*overrun_count = SDL_AtomicGet(&overruns);
+}
+
+static void
+resampler_init(void)
+{
+	memset(resampler_coeffs, 0, sizeof(resampler_coeffs));
+	switch (audio_resampler) {
+		case AUDIO_RESAMPLER_LINEAR:
+			resampler_taps = 4;
+			for (int i = 0; i < 256; i++) {
+				resampler_coeffs[i][2] = (32767 * i + 128) >> 8;
+				resampler_coeffs[i][1] = 32767 - resampler_coeffs[i][2];
+			}
+			break;
+		case AUDIO_RESAMPLER_SINC4:
+			resampler_taps = 4;
+			for (int i = 0; i < 256; i++) {
+				resampler_coeffs[i][0] = filter[256 + i];
+				resampler_coeffs[i][1] = filter[i];
+				resampler_coeffs[i][2] = filter[255 - i];
+				resampler_coeffs[i][3] = filter[511 - i];
+			}
+			break;
+		case AUDIO_RESAMPLER_SINC8:
+			// Blackman windowed sinc, normalized to unity gain at every position
+			resampler_taps = 8;
+			for (int i = 0; i < 256; i++) {
+				double taps[MAX_TAPS];
+				double sum = 0;
+				for (int j = 0; j < 8; j++) {
+					double x = (j - 3) - i / 256.0;
+					double window = 0.42 + 0.5 * cos(M_PI * x / 4) + 0.08 * cos(M_PI * x / 2);
+					taps[j] = (x == 0 ? 1 : sin(M_PI * x) / (M_PI * x)) * window;
+					sum += taps[j];
+				}
+				for (int j = 0; j < 8; j++) {
+					resampler_coeffs[i][j] = (int16_t)lround(taps[j] * 32767 / sum);
+				}
+			}
+			break;
 	}
+}
 
-	if (dev_name) {
-		if (!strcmp("none", dev_name)) {
-			return;
+static void
+mirror_buffer_start(int16_t *buf)
+{
+	memcpy(&buf[2 * SAMPLES_PER_BUFFER], buf, 2 * (MAX_TAPS - 1) * sizeof(int16_t));
+}
+
+#ifdef AUDIO_SSE2
+// Multiplies four stereo samples with four taps given as c0 c1 c2 c3 c0 c1 c2 c3,
+// giving the partial sums L01 L23 R01 R23
+static inline __m128i
+madd4(const int16_t *src, __m128i c)
+{
+	__m128i s = _mm_loadu_si128((const __m128i *)src);
+	// L0 R0 L1 R1 L2 R2 L3 R3 -> L0 L1 L2 L3 R0 R1 R2 R3
+	s = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 1, 2, 0));
+	s = _mm_shufflehi_epi16(s, _MM_SHUFFLE(3, 1, 2, 0));
+	s = _mm_shuffle_epi32(s, _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm_madd_epi16(s, c);
+}
+
+static inline __m128i
+resample_madd(const int16_t *a, const int16_t *b, uint32_t pos)
+{
+	const uint32_t idx = (pos >> SAMP_POS_FRAC_BITS) * 2;
+	const int16_t *coeffs = resampler_coeffs[(pos >> (SAMP_POS_FRAC_BITS - 8)) & 0xff];
+	__m128i c = _mm_loadl_epi64((const __m128i *)coeffs);
+	c = _mm_unpacklo_epi64(c, c);
+	__m128i sum = madd4(&a[idx], c);
+	if (b) {
+		sum = _mm_add_epi32(sum, madd4(&b[idx], c));
+	}
+	if (resampler_taps > 4) {
+		c = _mm_loadl_epi64((const __m128i *)&coeffs[4]);
+		c = _mm_unpacklo_epi64(c, c);
+		sum = _mm_add_epi32(sum, madd4(&a[idx + 8], c));
+		if (b) {
+			sum = _mm_add_epi32(sum, madd4(&b[idx + 8], c));
 		}
 	}
+	return sum;
+}
+#endif
 
-	// Set number of buffers
-	int num_bufs = num_audio_buffers;
-	if (num_bufs < 3) {
-		num_bufs = 3;
+// Filters len stereo samples out of the source buffer a, summed with b if
+// given, starting at pos and advancing by step. Returns the new position.
+static uint32_t
+resample(const int16_t *a, const int16_t *b, uint32_t pos, uint32_t step, uint32_t len, int32_t *out)
+{
+	uint32_t i = 0;
+#ifdef AUDIO_SSE2
+	for (; i + 2 <= len; i += 2) {
+		__m128 v = _mm_castsi128_ps(resample_madd(a, b, pos));
+		pos = (pos + step) & SAMP_POS_MASK_FRAC;
+		__m128 w = _mm_castsi128_ps(resample_madd(a, b, pos));
+		pos = (pos + step) & SAMP_POS_MASK_FRAC;
+		__m128i even = _mm_castps_si128(_mm_shuffle_ps(v, w, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i odd = _mm_castps_si128(_mm_shuffle_ps(v, w, _MM_SHUFFLE(3, 1, 3, 1)));
+		_mm_storeu_si128((__m128i *)&out[i * 2], _mm_add_epi32(even, odd));
 	}
-	if (num_bufs > 1024) {
-		num_bufs = 1024;
+#endif
+	for (; i < len; i++) {
+		const uint32_t idx = (pos >> SAMP_POS_FRAC_BITS) * 2;
+		const int16_t *coeffs = resampler_coeffs[(pos >> (SAMP_POS_FRAC_BITS - 8)) & 0xff];
+		int32_t out_l = 0;
+		int32_t out_r = 0;
+		for (int j = 0; j < resampler_taps; j++) {
+			int32_t samp_l = a[idx + j * 2];
+			int32_t samp_r = a[idx + j * 2 + 1];
+			if (b) {
+				samp_l += b[idx + j * 2];
+				samp_r += b[idx + j * 2 + 1];
+			}
+			out_l += samp_l * coeffs[j];
+			out_r += samp_r * coeffs[j];
+		}
+		out[i * 2] = out_l;
+		out[i * 2 + 1] = out_r;
+		pos = (pos + step) & SAMP_POS_MASK_FRAC;
 	}
-	buffer_size = SAMPLES_PER_BUFFER * num_bufs * 2;
+	return pos;
+}
 
-	// Allocate audio buffer
-	buffer = malloc(buffer_size * sizeof(int16_t));
-	rdidx = 0;
-	wridx = 0;
-	buffer_written = 0;
+// Same as resample(), but takes the nearest sample without filtering
+static uint32_t
+resample_direct(const int16_t *a, const int16_t *b, uint32_t pos, uint32_t step, uint32_t len, int32_t *out)
+{
+	for (uint32_t i = 0; i < len; i++) {
+		const uint32_t idx = (pos >> SAMP_POS_FRAC_BITS) * 2;
+		uint32_t out_l = (uint32_t)a[idx];
+		uint32_t out_r = (uint32_t)a[idx + 1];
+		if (b) {
+			out_l += b[idx];
+			out_r += b[idx + 1];
+		}
+		out[i * 2] = out_l << 14;
+		out[i * 2 + 1] = out_r << 14;
+		pos = (pos + step) & SAMP_POS_MASK_FRAC;
+	}
+	return pos;
+}
 
-	SDL_AudioSpec desired;
-	SDL_AudioSpec obtained;
+static inline void
+mix_sample(int32_t vera_l, int32_t vera_r, int32_t ym_l, int32_t ym_r, int32_t fs_l, int32_t fs_r, int16_t *out)
+{
+	// VERA+YM mixing is according to the Developer Board
+	// Loudest single PSG channel is 1/8 times the max output
+	// mix = (psg + pcm) * 2 + ym + fs * 4
+	int32_t mix_l = (vera_l >> 13) + (ym_l >> 15) + (fs_l >> 12);
+	int32_t mix_r = (vera_r >> 13) + (ym_r >> 15) + (fs_r >> 12);
+	uint32_t amp = SDL_max(SDL_abs(mix_l), SDL_abs(mix_r));
+	if (amp > 32767) {
+		uint32_t limiter_amp_new = (32767 << 16) / amp;
+		limiter_amp = SDL_min(limiter_amp_new, limiter_amp);
+	}
+	out[0] = (int16_t)((mix_l * limiter_amp) >> 16);
+	out[1] = (int16_t)((mix_r * limiter_amp) >> 16);
+	if (limiter_amp < (1 << 16)) limiter_amp++;
+}
 
-	// Setup SDL audio
-	memset(&desired, 0, sizeof(desired));
-	desired.freq     = AUDIO_SAMPLERATE;
-	desired.format   = AUDIO_S16SYS;
-	desired.samples  = SAMPLES_PER_BUFFER;
-	desired.channels = 2;
-	desired.callback = audio_callback;
+#ifdef AUDIO_SSE2
+// (mix * amp) >> 16 for products that fit in 32 bits
+static inline __m128i
+mul_shift16(__m128i mix, __m128i amp)
+{
+	__m128i even = _mm_mul_epu32(mix, amp);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(mix, 32), _mm_srli_epi64(amp, 32));
+	even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));
+	odd = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm_srai_epi32(_mm_unpacklo_epi32(even, odd), 16);
+}
+#endif
 
-	audio_dev = SDL_OpenAudioDevice(dev_name, 0, &desired, &obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
-	if (audio_dev <= 0) {
-		fprintf(stderr, "SDL_OpenAudioDevice failed: %s\n", SDL_GetError());
-		if (dev_name != NULL) {
-			audio_usage();
+// Mixes the resampled sources and applies the limiter
+static void
+mix(const int32_t *vera, const int32_t *ym, const int32_t *fs, uint32_t len, int16_t *out)
+{
+	uint32_t i = 0;
+#ifdef AUDIO_SSE2
+	// Four samples at a time, unless one of them needs to be limited
+	const __m128i max = _mm_set1_epi32(32767);
+	const __m128i min = _mm_set1_epi32(-32767);
+	for (; i + 4 <= len; i += 4) {
+		__m128i mix[2];
+		__m128i clip = _mm_setzero_si128();
+		for (int j = 0; j < 2; j++) {
+			const uint32_t k = i * 2 + j * 4;
+			mix[j] = _mm_add_epi32(
+				_mm_add_epi32(
+					_mm_srai_epi32(_mm_loadu_si128((const __m128i *)&vera[k]), 13),
+					_mm_srai_epi32(_mm_loadu_si128((const __m128i *)&ym[k]), 15)),
+				_mm_srai_epi32(_mm_loadu_si128((const __m128i *)&fs[k]), 12));
+			clip = _mm_or_si128(clip, _mm_cmpgt_epi32(mix[j], max));
+			clip = _mm_or_si128(clip, _mm_cmplt_epi32(mix[j], min));
+		}
+		if (_mm_movemask_epi8(clip)) {
+			for (uint32_t k = i * 2; k < (i + 4) * 2; k += 2) {
+				mix_sample(vera[k], vera[k + 1], ym[k], ym[k + 1], fs[k], fs[k + 1], &out[k]);
+			}
+			continue;
 		}
-		exit(-1);
+		if (limiter_amp < (1 << 16)) {
+			uint32_t amp[4];
+			for (int j = 0; j < 4; j++) {
+				amp[j] = SDL_min(limiter_amp + j, 1 << 16);
+			}
+			mix[0] = mul_shift16(mix[0], _mm_set_epi32(amp[1], amp[1], amp[0], amp[0]));
+			mix[1] = mul_shift16(mix[1], _mm_set_epi32(amp[3], amp[3], amp[2], amp[2]));
+			limiter_amp = SDL_min(limiter_amp + 4, 1 << 16);
+		}
+		_mm_storeu_si128((__m128i *)&out[i * 2], _mm_packs_epi32(mix[0], mix[1]));
 	}
-	if (obtained.freq <= 0 || (AUDIO_SAMPLERATE / obtained.freq) > SAMPLES_PER_BUFFER) {
-		fprintf(stderr, "Obtained sample rate is too low");
+#endif
+	for (uint32_t k = i * 2; k < len * 2; k += 2) {
+		mix_sample(vera[k], vera[k + 1], ym[k], ym[k + 1], fs[k], fs[k + 1], &out[k]);
+	}
+}
+
+void
+audio_init(const char *dev_name, int num_audio_buffers)
+{
+	if (audio_dev > 0 || audio_offline) {
 		audio_close();
-		return;
+	}
+
+	if (dev_name) {
+		if (!strcmp("none", dev_name)) {
+			return;
+		}
+		audio_offline = !strcmp("offline", dev_name);
+	}
+
+	if (audio_offline) {
+		host_sample_rate = AUDIO_SAMPLERATE;
+	} else {
+		// Set number of buffers
+		int num_bufs = num_audio_buffers;
+		if (num_bufs < 3) {
+			num_bufs = 3;
+		}
+		if (num_bufs > 1024) {
+			num_bufs = 1024;
+		}
+		buffer_size = SAMPLES_PER_BUFFER * num_bufs;
+
+		// Allocate audio buffer
+		buffer = malloc(buffer_size * SAMPLE_BYTES);
+		SDL_AtomicSet(&buffer_rdpos, 0);
+		SDL_AtomicSet(&buffer_wrpos, 0);
+		SDL_AtomicSet(&underruns, 0);
+		SDL_AtomicSet(&overruns, 0);
+
+		SDL_AudioSpec desired;
+		SDL_AudioSpec obtained;
+
+		// Setup SDL audio
+		memset(&desired, 0, sizeof(desired));
+		desired.freq     = AUDIO_SAMPLERATE;
+		desired.format   = AUDIO_S16SYS;
+		desired.samples  = SAMPLES_PER_BUFFER;
+		desired.channels = 2;
+		desired.callback = audio_callback;
+
+		audio_dev = SDL_OpenAudioDevice(dev_name, 0, &desired, &obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+		if (audio_dev <= 0) {
+			fprintf(stderr, "SDL_OpenAudioDevice failed: %s\n", SDL_GetError());
+			if (dev_name != NULL) {
+				audio_usage();
+			}
+			exit(-1);
+		}
+		if (obtained.freq <= 0 || (AUDIO_SAMPLERATE / obtained.freq) > SAMPLES_PER_BUFFER) {
+			fprintf(stderr, "Obtained sample rate is too low");
+			audio_close();
+			return;
+		}
+		host_sample_rate = obtained.freq;
 	}
 
 	// Init YM2151 emulation. 3.579545 MHz clock
 	YM_Create(3579545);
 	YM_init(3579545/64, 60);
 
-	host_sample_rate = obtained.freq;
 	vera_samps_per_host_samps = ((25000000ULL << SAMP_POS_FRAC_BITS) / 512 / host_sample_rate);
 	ym_samps_per_host_samps = ((3579545ULL << SAMP_POS_FRAC_BITS) / 64 / host_sample_rate);
 	fs_samps_per_host_samps = vera_samps_per_host_samps;
@@ -204,14 +488,18 @@ audio_init(const char *dev_name, int num_audio_buffers)
 	pcm_buf[0] = pcm_buf[1] = 0;
 	ym_buf[0] = ym_buf[1] = 0;
 	fs_buf[0] = fs_buf[1] = 0;
+	resampler_init();
 
 	// Start playback
-	SDL_PauseAudioDevice(audio_dev, 0);
+	if (audio_dev > 0) {
+		SDL_PauseAudioDevice(audio_dev, 0);
+	}
 }
 
 void
 audio_close(void)
 {
+	audio_offline = false;
 	if (audio_dev == 0) {
 		return;
 	}
@@ -230,7 +518,7 @@ void
 audio_step(int cpu_clocks)
 {
 	// Accumulate how many samples each source have to render
-	if (audio_dev == 0) {
+	if (audio_dev == 0 && !audio_offline) {
 		return;
 	}
 
@@ -246,13 +534,33 @@ audio_step(int cpu_clocks)
 	}
 }
 
+// number of CPU clocks until enough YM2151 samples are pending for the
+// next audio_render() to expire one of the YM2151 timers
+uint32_t
+audio_ym_timer_next_event()
+{
+	if (audio_dev == 0 && !audio_offline) {
+		return UINT32_MAX;
+	}
+	uint32_t samples = YM_samples_until_timer();
+	if (samples == UINT32_MAX) {
+		return UINT32_MAX;
+	}
+	uint32_t pending = ((ym_samp_pos_hd >> SAMP_POS_FRAC_BITS) - ym_samp_pos_wr) & SAMP_POS_MASK;
+	if (pending >= samples) {
+		return 1;
+	}
+	uint64_t target = ((uint64_t)(samples - pending) << SAMP_POS_FRAC_BITS) - (ym_samp_pos_hd & ((1 << SAMP_POS_FRAC_BITS) - 1));
+	return (uint32_t)SDL_min(target / YM_SAMP_CLKS_PER_CPU_CLK + 1, UINT32_MAX);
+}
+
 void
 audio_render()
 {
 	// Render all audio sources until read and write positions catch up
 	// This happens when there's a change to sound registers or one of the
 	// sources' sample buffer head position is too far
-	if (audio_dev == 0) {
+	if (audio_dev == 0 && !audio_offline) {
 		return;
 	}
 
@@ -296,121 +604,45 @@ audio_render()
 		midi_synth_render(&fs_buf[pos * 2], len);
 	}
 
-	uint32_t wridx_old = wridx;
+	mirror_buffer_start(psg_buf);
+	mirror_buffer_start(pcm_buf);
+	mirror_buffer_start(ym_buf);
+	mirror_buffer_start(fs_buf);
+
 	uint32_t len_vera = (vera_samp_pos_hd - vera_samp_pos_rd) & SAMP_POS_MASK_FRAC;
 	uint32_t len_ym = (ym_samp_pos_hd - ym_samp_pos_rd) & SAMP_POS_MASK_FRAC;
 	uint32_t len_fs = (fs_samp_pos_hd - fs_samp_pos_rd) & SAMP_POS_MASK_FRAC;
-	if (len_vera < (4 << SAMP_POS_FRAC_BITS) || len_ym < (4 << SAMP_POS_FRAC_BITS) || len_fs < (4 << SAMP_POS_FRAC_BITS)) {
-		// not enough samples yet, at least 4 are needed for the filter
+	const uint32_t taps_len = (uint32_t)resampler_taps << SAMP_POS_FRAC_BITS;
+	if (len_vera < taps_len || len_ym < taps_len || len_fs < taps_len) {
+		// not enough samples yet for the filter
 		return;
 	}
-	len_vera = (len_vera - (4 << SAMP_POS_FRAC_BITS)) / vera_samps_per_host_samps;
-	len_ym = (len_ym - (4 << SAMP_POS_FRAC_BITS)) / ym_samps_per_host_samps;
-	len_fs = (len_fs - (4 << SAMP_POS_FRAC_BITS)) / fs_samps_per_host_samps;
+	len_vera = (len_vera - taps_len) / vera_samps_per_host_samps;
+	len_ym = (len_ym - taps_len) / ym_samps_per_host_samps;
+	len_fs = (len_fs - taps_len) / fs_samps_per_host_samps;
 	len = SDL_min(len_vera, len_ym);
 	len = SDL_min(len, len_fs);
-	SDL_LockAudioDevice(audio_dev);
-	for (int i = 0; i < len; i++) {
-		int32_t samp[8];
-		int32_t filter_idx = 0;
-		int32_t vera_out_l = 0;
-		int32_t vera_out_r = 0;
-		int32_t ym_out_l = 0;
-		int32_t ym_out_r = 0;
-		int32_t fs_out_l = 0;
-		int32_t fs_out_r = 0;
-		// Don't resample VERA outputs if the host sample rate is as desired
+	for (uint32_t done = 0; done < len; done += SAMPLES_PER_BUFFER) {
+		const uint32_t n = SDL_min(len - done, SAMPLES_PER_BUFFER);
+		int32_t vera_out[2 * SAMPLES_PER_BUFFER];
+		int32_t ym_out[2 * SAMPLES_PER_BUFFER];
+		int32_t fs_out[2 * SAMPLES_PER_BUFFER];
+		int16_t out[2 * SAMPLES_PER_BUFFER];
+		// Don't resample VERA and MIDI synth outputs if the host sample rate is as desired
 		if (host_sample_rate == AUDIO_SAMPLERATE) {
-			pos = (vera_samp_pos_rd >> SAMP_POS_FRAC_BITS) * 2;
-			vera_out_l = ((uint32_t)psg_buf[pos] + pcm_buf[pos]) << 14;
-			vera_out_r = ((uint32_t)psg_buf[pos + 1] + pcm_buf[pos + 1]) << 14;
+			vera_samp_pos_rd = resample_direct(psg_buf, pcm_buf, vera_samp_pos_rd, vera_samps_per_host_samps, n, vera_out);
+			fs_samp_pos_rd = resample_direct(fs_buf, NULL, fs_samp_pos_rd, fs_samps_per_host_samps, n, fs_out);
 		} else {
-			filter_idx = (vera_samp_pos_rd >> (SAMP_POS_FRAC_BITS - 8)) & 0xff;
-			pos = (vera_samp_pos_rd >> SAMP_POS_FRAC_BITS) * 2;
-			for (int j = 0; j < 8; j += 2) {
-				samp[j] = (int32_t)psg_buf[pos] + pcm_buf[pos];
-				samp[j + 1] = (int32_t)psg_buf[pos + 1] + pcm_buf[pos + 1];
-				pos = (pos + 2) & (SAMP_POS_MASK * 2);
-			}
-			vera_out_l += samp[0] * filter[256 + filter_idx];
-			vera_out_r += samp[1] * filter[256 + filter_idx];
-			vera_out_l += samp[2] * filter[  0 + filter_idx];
-			vera_out_r += samp[3] * filter[  0 + filter_idx];
-			vera_out_l += samp[4] * filter[255 - filter_idx];
-			vera_out_r += samp[5] * filter[255 - filter_idx];
-			vera_out_l += samp[6] * filter[511 - filter_idx];
-			vera_out_r += samp[7] * filter[511 - filter_idx];
-		}
-		filter_idx = (ym_samp_pos_rd >> (SAMP_POS_FRAC_BITS - 8)) & 0xff;
-		pos = (ym_samp_pos_rd >> SAMP_POS_FRAC_BITS) * 2;
-		for (int j = 0; j < 8; j += 2) {
-			samp[j] = ym_buf[pos];
-			samp[j + 1] = ym_buf[pos + 1];
-			pos = (pos + 2) & (SAMP_POS_MASK * 2);
-		}
-		ym_out_l += samp[0] * filter[256 + filter_idx];
-		ym_out_r += samp[1] * filter[256 + filter_idx];
-		ym_out_l += samp[2] * filter[  0 + filter_idx];
-		ym_out_r += samp[3] * filter[  0 + filter_idx];
-		ym_out_l += samp[4] * filter[255 - filter_idx];
-		ym_out_r += samp[5] * filter[255 - filter_idx];
-		ym_out_l += samp[6] * filter[511 - filter_idx];
-		ym_out_r += samp[7] * filter[511 - filter_idx];
-		// Don't resample MIDI synth outputs if the host sample rate matches it
-		if (host_sample_rate == AUDIO_SAMPLERATE) {
-			pos = (fs_samp_pos_rd >> SAMP_POS_FRAC_BITS) * 2;
-			fs_out_l = (uint32_t)fs_buf[pos] << 14;
-			fs_out_r = (uint32_t)fs_buf[pos + 1] << 14;
-		} else {
-			filter_idx = (fs_samp_pos_rd >> (SAMP_POS_FRAC_BITS - 8)) & 0xff;
-			pos = (fs_samp_pos_rd >> SAMP_POS_FRAC_BITS) * 2;
-			for (int j = 0; j < 8; j += 2) {
-				samp[j] = fs_buf[pos];
-				samp[j + 1] = fs_buf[pos + 1];
-				pos = (pos + 2) & (SAMP_POS_MASK * 2);
-			}
-			fs_out_l += samp[0] * filter[256 + filter_idx];
-			fs_out_r += samp[1] * filter[256 + filter_idx];
-			fs_out_l += samp[2] * filter[  0 + filter_idx];
-			fs_out_r += samp[3] * filter[  0 + filter_idx];
-			fs_out_l += samp[4] * filter[255 - filter_idx];
-			fs_out_r += samp[5] * filter[255 - filter_idx];
-			fs_out_l += samp[6] * filter[511 - filter_idx];
-			fs_out_r += samp[7] * filter[511 - filter_idx];
+			vera_samp_pos_rd = resample(psg_buf, pcm_buf, vera_samp_pos_rd, vera_samps_per_host_samps, n, vera_out);
+			fs_samp_pos_rd = resample(fs_buf, NULL, fs_samp_pos_rd, fs_samps_per_host_samps, n, fs_out);
 		}
-		// VERA+YM mixing is according to the Developer Board
-		// Loudest single PSG channel is 1/8 times the max output
-		// mix = (psg + pcm) * 2 + ym + fs * 4
-		int32_t mix_l = (vera_out_l >> 13) + (ym_out_l >> 15) + (fs_out_l >> 12);
-		int32_t mix_r = (vera_out_r >> 13) + (ym_out_r >> 15) + (fs_out_r >> 12);
-		uint32_t amp = SDL_max(SDL_abs(mix_l), SDL_abs(mix_r));
-		if (amp > 32767) {
-			uint32_t limiter_amp_new = (32767 << 16) / amp;
-			limiter_amp = SDL_min(limiter_amp_new, limiter_amp);
+		ym_samp_pos_rd = resample(ym_buf, NULL, ym_samp_pos_rd, ym_samps_per_host_samps, n, ym_out);
+		mix(vera_out, ym_out, fs_out, n, out);
+		wav_recorder_process(out, n);
+		if (audio_dev > 0) {
+			buffer_write(out, n);
 		}
-		buffer[wridx++] = (int16_t)((mix_l * limiter_amp) >> 16);
-		buffer[wridx++] = (int16_t)((mix_r * limiter_amp) >> 16);
-		if (limiter_amp < (1 << 16)) limiter_amp++;
-		vera_samp_pos_rd = (vera_samp_pos_rd + vera_samps_per_host_samps) & SAMP_POS_MASK_FRAC;
-		ym_samp_pos_rd = (ym_samp_pos_rd + ym_samps_per_host_samps) & SAMP_POS_MASK_FRAC;
-		fs_samp_pos_rd = (fs_samp_pos_rd + fs_samps_per_host_samps) & SAMP_POS_MASK_FRAC;
-		if (wridx == buffer_size) {
-			wav_recorder_process(&buffer[wridx_old], (buffer_size - wridx_old) / 2);
-			wridx = 0;
-			wridx_old = 0;
-		}
-	}
-	if ((wridx - wridx_old) > 0) {
-		wav_recorder_process(&buffer[wridx_old], (wridx - wridx_old) / 2);
-	}
-	buffer_written += len * 2;
-	if (buffer_written > buffer_size) {
-		// Prevent the buffer from overflowing by skipping the read pointer ahead.
-		uint32_t buffer_skip_amount = (buffer_written / buffer_size) * SAMPLES_PER_BUFFER * 2;
-		rdidx = (rdidx + buffer_skip_amount) % buffer_size;
-		buffer_written -= buffer_skip_amount;
 	}
-	SDL_UnlockAudioDevice(audio_dev);
 
 	// catch up all buffers if they are too far behind
 	uint32_t skip = len_vera - len;
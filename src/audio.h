@@ -8,9 +8,19 @@
 
 #define AUDIO_SAMPLERATE (25000000 / 512)
 
+enum audio_resampler {
+	AUDIO_RESAMPLER_LINEAR,
+	AUDIO_RESAMPLER_SINC4,
+	AUDIO_RESAMPLER_SINC8,
+};
+
+extern enum audio_resampler audio_resampler;
+
 void audio_init(const char *dev_name, int num_audio_buffers);
 void audio_close(void);
 void audio_step(int cpu_clocks);
 void audio_render();
+uint32_t audio_ym_timer_next_event(void);
+void audio_get_xruns(uint32_t *underrun_count, uint32_t *overrun_count);
 
 void audio_usage(void);
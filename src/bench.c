@@ -0,0 +1,86 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+// Benchmark mode (-bench)
+//
+// Runs a fixed number of frames or CPU cycles without throttling, then
+// reports the host time, the emulated instruction rate and clock speed,
+// and how the host time was split between the subsystems.
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "bench.h"
+#include "glue.h"
+#include "cpu/fake6502.h"
+
+bool bench_enabled = false;
+uint64_t bench_ticks[BENCH_NUM];
+
+static uint32_t frames_total;
+static uint32_t frames_done;
+static uint64_t cycles_total;
+static uint64_t start_time;
+static uint64_t cycles;
+static uint32_t last_clockticks;
+static int start_instructions;
+
+// A budget of 0 frames or cycles means no limit
+void
+bench_init(uint32_t frames, uint64_t cycles_budget)
+{
+	bench_enabled = true;
+	frames_total = frames;
+	frames_done = 0;
+	cycles_total = cycles_budget;
+	for (int i = 0; i < BENCH_NUM; i++) {
+		bench_ticks[i] = 0;
+	}
+	cycles = 0;
+	last_clockticks = clockticks6502;
+	start_instructions = instruction_counter;
+	start_time = SDL_GetPerformanceCounter();
+}
+
+// Count the cycles run since the last call, and a completed frame.
+// Returns true once the benchmark is done. The cycle budget is checked
+// after each batch of instructions, so it can be overrun by up to one
+// batch.
+bool
+bench_step(bool new_frame)
+{
+	cycles += (uint32_t)(clockticks6502 - last_clockticks);
+	last_clockticks = clockticks6502;
+	if (new_frame) {
+		frames_done++;
+	}
+	return (frames_total && frames_done >= frames_total) || (cycles_total && cycles >= cycles_total);
+}
+
+void
+bench_report()
+{
+	uint64_t total = SDL_GetPerformanceCounter() - start_time;
+	if (!total) {
+		total = 1;
+	}
+	double freq = (double)SDL_GetPerformanceFrequency();
+	double host_seconds = total / freq;
+	double emulated_seconds = (double)cycles / (MHZ * 1000000.0);
+	uint32_t instructions = (uint32_t)(instruction_counter - start_instructions);
+
+	uint64_t cpu = total;
+	for (int i = 0; i < BENCH_NUM; i++) {
+		cpu -= SDL_min(cpu, bench_ticks[i]);
+	}
+
+	printf("Benchmark: %u frames, %" PRIu64 " cycles, %.3f s emulated at %d MHz\n", frames_done, cycles, emulated_seconds, MHZ);
+	printf("Host time: %.3f s (%.1f%% of real time)\n", host_seconds, emulated_seconds / host_seconds * 100);
+	printf("Instructions: %u (%.2f MIPS)\n", instructions, instructions / host_seconds / 1000000);
+	printf("Effective speed: %.2f MHz\n", cycles / host_seconds / 1000000);
+	printf("Time split: CPU %.1f%%, video %.1f%%, audio %.1f%%, I/O %.1f%%\n",
+		cpu * 100.0 / total,
+		bench_ticks[BENCH_VIDEO] * 100.0 / total,
+		bench_ticks[BENCH_AUDIO] * 100.0 / total,
+		bench_ticks[BENCH_IO] * 100.0 / total);
+	fflush(stdout);
+}
@@ -0,0 +1,43 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <SDL.h>
+
+#define BENCH_DEFAULT_FRAMES 600
+
+typedef enum {
+	BENCH_VIDEO,
+	BENCH_AUDIO,
+	BENCH_IO,
+	BENCH_NUM
+} bench_subsystem_t;
+
+extern bool bench_enabled;
+extern uint64_t bench_ticks[BENCH_NUM];
+
+void bench_init(uint32_t frames, uint64_t cycles);
+bool bench_step(bool new_frame);
+void bench_report(void);
+
+// Account the host time since bench_start() to a subsystem. Everything
+// that is not accounted to one of them counts as CPU time.
+static inline uint64_t
+bench_start(void)
+{
+	return bench_enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+static inline void
+bench_stop(bench_subsystem_t subsystem, uint64_t start)
+{
+	if (bench_enabled) {
+		bench_ticks[subsystem] += SDL_GetPerformanceCounter() - start;
+	}
+}
+
+#endif
@@ -54,7 +54,7 @@ static void stz() {
 static void bra() {
     oldpc = regs.pc;
     regs.pc += reladdr;
-    if (regs.e && (oldpc & 0xFF00) != (regs.pc & 0xFF00)) clockticks6502++; //check if jump crossed a page boundary
+    if (emulation_mode() && (oldpc & 0xFF00) != (regs.pc & 0xFF00)) clockticks6502++; //check if jump crossed a page boundary
 }
 
 // *******************************************************************************************
@@ -4,6 +4,7 @@
 #		File:			buildtables.py
 #		Date:			3rd September 2019
 #		Purpose:		Creates files tables.h from the .opcodes descriptors
+#						Creates the fused opcode handlers in tables.h
 #						Creates disassembly include file.
 #		Author:			Paul Robson (paul@robson.org.uk)
 #		Formatted By: 	Jeries Abedrabbo (jabedrabbo@asaltech.com)
@@ -33,12 +34,10 @@ OPCODE_REGEX_STR = "^(?P<{actnCode}>\\w+)\\s+(?P<{addrMode}>\\w+)\\s+(?P<{mchnCy
 #####################################
 ########## HEADER CONSTANTS #########
 ADDR_MODE_HEADER_C02 = "static void (*addrtable_c02[256])() = {"
-ACTN_CODE_HEADER_C02 = "static void (*optable_c02[256])() = {"
-MCHN_CYCLES_HEADER_C02 = "static const uint32_t ticktable_c02[256] = {"
+EXECUTE_HEADER_C02 = "static void execute_c02() {"
 MNEMONICS_DISASSEM_HEADER_C02 = "static const char *mnemonics_c02[256] = {"
 ADDR_MODE_HEADER_C816 = "static void (*addrtable_c816[256])() = {"
-ACTN_CODE_HEADER_C816 = "static void (*optable_c816[256])() = {"
-MCHN_CYCLES_HEADER_C816 = "static const uint32_t ticktable_c816[256] = {"
+EXECUTE_HEADER_C816 = "static void execute_c816() {"
 MNEMONICS_DISASSEM_HEADER_C816 = "static const char *mnemonics_c816[256] = {"
 TABLE_MAP = "/*{0:8}|  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |{0:5}*/\n"
 
@@ -50,6 +49,19 @@ EMPTY_NOP_MOD = "imp"
 OPCODE_ROW_LEN = 16
 TOTAL_NUMBER_OPCODES = 2 ** 8
 
+#####################################
+######### PENALTY CONSTANTS #########
+# Addressing modes that set penaltyaddr on a page crossing
+PAGE_CROSSING_MODES = ("absx", "abslx", "absy", "indy", "sridy")
+# Operations that set penaltyop, i.e. take an extra cycle on a page crossing
+PAGE_CROSSING_ACTNS = ("adc", "and", "cmp", "eor", "lda", "ldx", "ldy", "ora", "sbc")
+# Operations that set penaltye, i.e. take an extra cycle on a page crossing in emulation mode
+BRANCH_ACTNS = ("bcc", "bcs", "beq", "bmi", "bne", "bpl", "bvc", "bvs")
+# 65C816 only: operations that set penaltym, penaltyx and penaltyn
+MEMORY_WIDTH_ACTNS = ("lda", "phx", "phy", "plx", "ply")
+INDEX_WIDTH_ACTNS = ("ldx", "ldy")
+NATIVE_MODE_ACTNS = ("brk", "cop")
+
 #####################################
 ############# FILENAMES #############
 TABLES_HEADER_FNAME = "tables.h"
@@ -124,6 +136,46 @@ def generateTable(hFileName, header, element, opcodesList):
 
 
 
+#######################################################################################################################
+############################################  Output the fused opcode handlers  #######################################
+#######################################################################################################################
+#
+#   Every opcode gets its own case with the addressing mode and the operation called directly, so that both get
+#   inlined, and with the base cycle count as a constant. Only the penalty flags an opcode can actually raise are
+#   cleared and checked. The M/X width and native mode penalties can't occur on a 65C02, so they are left out there.
+#
+def generateExecute(hFileName, header, opcodesList, is65c816):
+    hFileName.write("{}{}{}".format("\n", header, "\n"))
+    hFileName.write("    switch (opcode) {\n")
+    for opInfo in opcodesList:
+        action = opInfo[ACTN_KEY_STR]
+        mode = opInfo[MODE_KEY_STR]
+        before = []
+        after = []
+        if mode in PAGE_CROSSING_MODES and action in PAGE_CROSSING_ACTNS:
+            before.append("penaltyaddr = 0;")
+            after.append("if (penaltyaddr) clockticks6502++;")
+        if action in BRANCH_ACTNS:
+            before.append("penaltye = 0;")
+            after.append("if (penaltye && emulation_mode()) clockticks6502++;")
+        if is65c816:
+            if action in MEMORY_WIDTH_ACTNS:
+                after.append("if (memory_16bit()) clockticks6502++;")
+            if action in INDEX_WIDTH_ACTNS:
+                after.append("if (index_16bit()) clockticks6502++;")
+            if action in NATIVE_MODE_ACTNS:
+                after.append("if (!emulation_mode()) clockticks6502++;")
+        body = before + ["{}();".format(mode), "{}();".format(action),
+                         "clockticks6502 += {};".format(opInfo[CYCLES_KEY_STR])] + after + ["break;"]
+
+        hFileName.write("        case 0x{0:02X}: /* {1} {2} */\n".format(opInfo[OPCODE_KEY_STR], action, mode))
+        for line in body:
+            hFileName.write("            {}\n".format(line))
+    hFileName.write("    }\n")
+    hFileName.write("}\n")
+
+
+
 #######################################################################################################################
 ###################################################  Output a list   ##################################################
 #######################################################################################################################
@@ -206,10 +258,8 @@ if __name__ == '__main__':
         output_h_file.write("/* Generated by buildtables.py */\n")
         generateTable(output_h_file, ADDR_MODE_HEADER_C02, MODE_KEY_STR, opcodesList_c02)
         generateTable(output_h_file, ADDR_MODE_HEADER_C816, MODE_KEY_STR, opcodesList_c816)
-        generateTable(output_h_file, ACTN_CODE_HEADER_C02, ACTN_KEY_STR, opcodesList_c02)
-        generateTable(output_h_file, ACTN_CODE_HEADER_C816, ACTN_KEY_STR, opcodesList_c816)
-        generateTable(output_h_file, MCHN_CYCLES_HEADER_C02, CYCLES_KEY_STR, opcodesList_c02)
-        generateTable(output_h_file, MCHN_CYCLES_HEADER_C816, CYCLES_KEY_STR, opcodesList_c816)
+        generateExecute(output_h_file, EXECUTE_HEADER_C02, opcodesList_c02, False)
+        generateExecute(output_h_file, EXECUTE_HEADER_C816, opcodesList_c816, True)
 
     # Create disassembly "MNEMONICS_DISASSEM_HEADER_FNAME" header file.
     mnemonics_c02 = [convertMnemonic(opcodesList_c02[x]) for x in range(0, TOTAL_NUMBER_OPCODES)]
@@ -92,28 +92,57 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// This file is compiled twice: as is, it is the full 65C816 core that
+// also owns the CPU state and the public API. fake6502_c02.c includes it
+// with FAKE6502_65C02_ONLY defined to build a second instance of the
+// interpreter with all 65C816 paths constant-folded out, which exports
+// only step6502_c02() and exec6502_c02().
+#ifdef FAKE6502_65C02_ONLY
+#define step6502 step6502_c02
+#define exec6502 exec6502_c02
+
+extern struct regs regs;
+
+extern uint32_t instructions;
+extern uint32_t clockticks6502, clockgoal6502;
+extern uint16_t opcode_addr;
+
+extern bool warn_rockwell;
+
+extern uint8_t waiting;
+
+extern uint8_t callexternal;
+extern void (*loopexternal)();
+#else
 // 6502 / 65816 registers
 
 struct regs regs;
 
-//helper variables
 uint32_t instructions = 0; //keep track of total instructions executed
 uint32_t clockticks6502 = 0, clockgoal6502 = 0;
-uint16_t opcode_addr, oldpc, reladdr, value;
-uint32_t ea;
-uint32_t result;
-uint8_t opcode, oldstatus;
+uint16_t opcode_addr;
 
 bool warn_rockwell = true;
 
-uint8_t penaltyop, penaltyaddr;
-uint8_t penaltym = 0;
-uint8_t penaltye = 0;
-uint8_t penaltyn = 0;
-uint8_t penaltyx = 0;
-uint8_t penaltyd = 0;
 uint8_t waiting = 0;
 
+uint8_t callexternal = 0;
+void (*loopexternal)();
+#endif
+
+//helper variables
+static uint16_t oldpc, reladdr, value;
+static uint32_t ea;
+static uint32_t result;
+static uint8_t opcode;
+
+static uint8_t penaltyop, penaltyaddr;
+static uint8_t penaltym = 0;
+static uint8_t penaltye = 0;
+static uint8_t penaltyn = 0;
+static uint8_t penaltyx = 0;
+static uint8_t penaltyd = 0;
+
 //externally supplied functions
 extern uint8_t read6502(uint16_t address, uint8_t bank);
 extern void write6502(uint16_t address, uint8_t bank, uint8_t value);
@@ -124,20 +153,17 @@ extern uint8_t memory_get_rom_bank();
 
 static void (*addrtable_c02[256])();
 static void (*addrtable_c816[256])();
-static void (*optable_c02[256])();
-static void (*optable_c816[256])();
-
-static const uint32_t ticktable_c02[256];
-static const uint32_t ticktable_c816[256];
 
+#ifdef FAKE6502_65C02_ONLY
+#define addrtable addrtable_c02
+#else
 static void (**addrtable)();
-static void (**optable)();
-static const uint32_t *ticktable;
+#endif
 
 #include "support.h"
 #include "modes.h"
 
-void rockwell_warning(const char *instruction) {
+static void rockwell_warning(const char *instruction) {
     uint8_t pc_bank;
 
     if (opcode_addr < 0xa000) {
@@ -199,6 +225,7 @@ static void putvalue(uint16_t saveval, bool use16Bit) {
 #include "65c02.h"
 #include "tables.h"
 
+#ifndef FAKE6502_65C02_ONLY
 void nmi6502() {
     interrupt6502(INT_NMI);
     waiting = 0;
@@ -210,9 +237,30 @@ void irq6502() {
     }
     waiting = 0;
 }
+#endif
 
-uint8_t callexternal = 0;
-void (*loopexternal)();
+// Execute the instruction at PC through the fused per-opcode handlers
+// generated into tables.h. They add the cycle count of the instruction,
+// including any penalties, to clockticks6502.
+static inline void execute_instruction() {
+    opcode = read6502(regs.pc++, regs.k);
+
+    if (emulation_mode()) {
+        regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
+    }
+
+    if (is_65c816()) {
+        execute_c816();
+    } else {
+        execute_c02();
+    }
+
+    if (penaltyd) clockticks6502 ++;
+
+    instructions++;
+
+    if (callexternal) (*loopexternal)();
+}
 
 void exec6502(uint32_t tickcount) {
 	if (waiting) {
@@ -226,32 +274,7 @@ void exec6502(uint32_t tickcount) {
     clockgoal6502 += tickcount;
 
     while (clockticks6502 < clockgoal6502) {
-        opcode = read6502(regs.pc++, regs.k);
-
-        if (regs.e) {
-            regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
-        }
-
-        penaltyop = 0;
-        penaltyaddr = 0;
-        penaltym = 0;
-        penaltye = 0;
-        penaltyn = 0;
-        penaltyx = 0;
-
-        (*addrtable[opcode])();
-        (*optable[opcode])();
-        clockticks6502 += ticktable[opcode];
-
-        if (!regs.e && penaltyop && penaltyaddr) clockticks6502++;
-        if (memory_16bit()) clockticks6502 += penaltym;
-        if (index_16bit()) clockticks6502 += penaltyx;
-        if (penaltyn && !regs.e) clockticks6502++;
-        if (penaltye && regs.e) clockticks6502++;
-
-        instructions++;
-
-        if (callexternal) (*loopexternal)();
+        execute_instruction();
     }
 }
 
@@ -264,42 +287,19 @@ void step6502() {
 
     opcode_addr = regs.pc;
 
-    opcode = read6502(regs.pc++, regs.k);
-
-    if (regs.e) {
-        regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
-    }
+    execute_instruction();
 
-    penaltyop = 0;
-    penaltyaddr = 0;
-    penaltym = 0;
-    penaltye = 0;
-    penaltyn = 0;
-    penaltyx = 0;
-
-    (*addrtable[opcode])();
-    (*optable[opcode])();
-    clockticks6502 += ticktable[opcode];
-
-    if (penaltyop && penaltyaddr) clockticks6502++;
-    if (memory_16bit()) clockticks6502 += penaltym;
-    if (index_16bit()) clockticks6502 += penaltyx;
-    if (penaltyn && !regs.e) clockticks6502++;
-    if (penaltye && regs.e) clockticks6502++;
-    if (penaltyd) clockticks6502 ++;
     clockgoal6502 = clockticks6502;
-
-    instructions++;
-
-    if (callexternal) (*loopexternal)();
 }
 
+#ifndef FAKE6502_65C02_ONLY
 void hookexternal(void *funcptr) {
     if (funcptr != (void *)NULL) {
         loopexternal = funcptr;
         callexternal = 1;
     } else callexternal = 0;
 }
+#endif
 
 //  Fixes from http://6502.org/tutorials/65c02opcodes.html
 //
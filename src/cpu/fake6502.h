@@ -10,6 +10,8 @@
 extern void reset6502(bool c816);
 extern void step6502();
 extern void exec6502(uint32_t tickcount);
+extern void step6502_c02();
+extern void exec6502_c02(uint32_t tickcount);
 extern void irq6502();
 extern void nmi6502();
 extern uint32_t clockticks6502;
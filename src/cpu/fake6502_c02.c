@@ -0,0 +1,12 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+// The 65C02-only instance of the fake6502 core, built from the same
+// sources as the full 65C816 core. Handlers for 65C816-only opcodes and
+// addressing modes end up unused here.
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+#define FAKE6502_65C02_ONLY
+#include "fake6502.c"
@@ -71,7 +71,7 @@ static void adc() {
             uint8_t ovresult = (tmp & 0x0F) | (tmpov & 0xF0);
             overflowcalc8((uint16_t)ovresult, (uint16_t)regs.a, value);
         }
-        clockticks6502 += (uint32_t)(!regs.is65c816);
+        clockticks6502 += (uint32_t)(!is_65c816());
     } else {
         if (memory_16bit()) {
             value = getvalue(1);
@@ -477,7 +477,7 @@ static void phk() {
 }
 
 static void php() {
-    push8(regs.e ? regs.status | FLAG_BREAK : regs.status);
+    push8(emulation_mode() ? regs.status | FLAG_BREAK : regs.status);
 }
 
 static void pla() {
@@ -504,7 +504,7 @@ static void pld() {
 
 static void plp() {
     regs.status = pull8();
-    if (regs.e) {
+    if (emulation_mode()) {
         regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
     } else if (regs.status & FLAG_INDEX_WIDTH) {
         regs.xh = 0;
@@ -516,7 +516,7 @@ static void rep() {
     value = getvalue(0);
     regs.status &= ~(value & 0xFF);
 
-    if (regs.e) {
+    if (emulation_mode()) {
         regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
     }
 }
@@ -549,7 +549,7 @@ static void rti() {
     value = pull16();
     regs.pc = value;
 
-    if (regs.e) {
+    if (emulation_mode()) {
         regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
     } else {
         if (regs.status & FLAG_INDEX_WIDTH) {
@@ -643,7 +643,7 @@ static void sbc() {
             overflowcalc8((uint16_t)ovresult, (uint16_t)regs.a, value ^ 0xFF);
         }
 
-        clockticks6502 += (uint32_t)(!regs.is65c816);
+        clockticks6502 += (uint32_t)(!is_65c816());
     } else {
         if (memory_16bit()) {
             value = getvalue(1) ^ 0xFFFF;
@@ -678,7 +678,7 @@ static void sei() {
 
 static void sep() {
     regs.status |= getvalue(0) & 0xFF;
-    if (regs.e) {
+    if (emulation_mode()) {
         regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
     }
     if (regs.status & FLAG_INDEX_WIDTH) {
@@ -768,7 +768,7 @@ static void txa() {
 }
 
 static void txs() {
-    if (regs.e) {
+    if (emulation_mode()) {
         regs.sp = 0x100 | regs.xl;
     } else {
         regs.sp = regs.x;
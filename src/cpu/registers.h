@@ -40,8 +40,10 @@ struct regs
     bool is65c816;
 };
 
+#ifndef FAKE6502_65C02_ONLY
 void increment_wrap_at_page_boundary(uint16_t *value);
 void decrement_wrap_at_page_boundary(uint16_t *value);
 uint16_t direct_page_add(uint16_t offset);
+#endif
 
 #endif
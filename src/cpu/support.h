@@ -55,8 +55,22 @@
         else clearoverflow();\
 }
 
+#ifdef FAKE6502_65C02_ONLY
+// The 65C02 core never leaves emulation mode and has no 16 bit registers,
+// so all of the 65C816 checks fold into constants.
+#define is_65c816() false
+#define emulation_mode() true
+#define index_16bit() false
+#define memory_16bit() false
+// Helpers are private to each core instance.
+#define CORE_HELPER static
+#else
+#define is_65c816() (regs.is65c816)
+#define emulation_mode() (regs.e)
 #define index_16bit() (regs.is65c816 && !(regs.status & FLAG_INDEX_WIDTH))
 #define memory_16bit() (regs.is65c816 && !(regs.status & FLAG_MEMORY_WIDTH))
+#define CORE_HELPER
+#endif
 #define acc_for_mode() (memory_16bit() ? regs.c : ((uint16_t) regs.a))
 
 
@@ -68,40 +82,40 @@
 
 //a few general functions used by various other functions
 
-uint16_t add_wrap_at_page_boundary(uint16_t value, uint8_t add) {
-    if (regs.e) {
+CORE_HELPER uint16_t add_wrap_at_page_boundary(uint16_t value, uint8_t add) {
+    if (emulation_mode()) {
         return (value & 0xFF00) | ((uint16_t) (((uint8_t) (value & 0x00FF)) + add) & 0x00FF);
     } else {
         return value + add;
     }
 }
 
-uint16_t subtract_wrap_at_page_boundary(uint16_t value, uint8_t subtract) {
-    if (regs.e) {
+CORE_HELPER uint16_t subtract_wrap_at_page_boundary(uint16_t value, uint8_t subtract) {
+    if (emulation_mode()) {
         return (value & 0xFF00) | ((uint16_t) (((uint8_t) (value & 0x00FF)) - subtract) & 0x00FF);
     } else {
         return value - subtract;
     }
 }
 
-void increment_wrap_at_page_boundary(uint16_t *value) {
-    if (regs.e) {
+CORE_HELPER void increment_wrap_at_page_boundary(uint16_t *value) {
+    if (emulation_mode()) {
         *value = (*value & 0xFF00) | ((uint16_t) (((uint8_t) (*value & 0x00FF)) + 1) & 0x00FF);
     } else {
         (*value)++;
     }
 }
 
-void decrement_wrap_at_page_boundary(uint16_t *value) {
-    if (regs.e) {
+CORE_HELPER void decrement_wrap_at_page_boundary(uint16_t *value) {
+    if (emulation_mode()) {
         *value = (*value & 0xFF00) | ((uint16_t) (((uint8_t) (*value & 0x00FF)) - 1) & 0x00FF);
     } else {
         (*value)--;
     }
 }
 
-uint16_t direct_page_add(uint16_t offset) {
-    if (regs.e && (regs.dp & 0x00FF) == 0) {
+CORE_HELPER uint16_t direct_page_add(uint16_t offset) {
+    if (emulation_mode() && (regs.dp & 0x00FF) == 0) {
         return (regs.dp & 0xFF00) | ((uint16_t) ((uint8_t) (regs.dp & 0x00FF)) + (offset & 0xFF));
     } else {
         return regs.dp + offset;
@@ -111,19 +125,19 @@ uint16_t direct_page_add(uint16_t offset) {
 #define incsp() increment_wrap_at_page_boundary(&regs.sp)
 #define decsp() decrement_wrap_at_page_boundary(&regs.sp)
 
-void push16(uint16_t pushval) {
+CORE_HELPER void push16(uint16_t pushval) {
     write6502(regs.sp, 0, (pushval >> 8) & 0xFF);
     decsp();
     write6502(regs.sp, 0, pushval & 0xFF);
     decsp();
 }
 
-void push8(uint8_t pushval) {
+CORE_HELPER void push8(uint8_t pushval) {
     write6502(regs.sp, 0, pushval);
     decsp();
 }
 
-uint16_t pull16() {
+CORE_HELPER uint16_t pull16() {
     incsp();
     uint16_t temp16 = read6502(regs.sp, 0);
     incsp();
@@ -131,12 +145,13 @@ uint16_t pull16() {
     return temp16;
 }
 
-uint8_t pull8() {
+CORE_HELPER uint8_t pull8() {
     incsp();
     uint8_t value = read6502(regs.sp, 0);
     return value;
 }
 
+#ifndef FAKE6502_65C02_ONLY
 void reset6502(bool c816) {
     regs.pc = (uint16_t)read6502(0xFFFC, 0) | ((uint16_t)read6502(0xFFFD, 0) << 8);
     regs.c = 0;
@@ -150,20 +165,17 @@ void reset6502(bool c816) {
     if (c816) {
         regs.status |= FLAG_INDEX_WIDTH | FLAG_MEMORY_WIDTH;
         regs.is65c816 = true;
-        ticktable = ticktable_c816;
-        optable = optable_c816;
         addrtable = addrtable_c816;
     } else {
         regs.status |= FLAG_CONSTANT;
         regs.is65c816 = false;
-        ticktable = ticktable_c02;
-        optable = optable_c02;
         addrtable = addrtable_c02;
     }
     setinterrupt();
     cleardecimal();
     waiting = 0;
 }
+#endif
 
 enum InterruptType {
     INT_COP = 0x4,
@@ -172,8 +184,8 @@ enum InterruptType {
     INT_IRQ = 0xE
 };
 
-void interrupt6502(enum InterruptType vector) {
-    if (!regs.e) {
+CORE_HELPER void interrupt6502(enum InterruptType vector) {
+    if (!emulation_mode()) {
         push8(regs.k);
     }
 
@@ -181,7 +193,7 @@ void interrupt6502(enum InterruptType vector) {
 
     push16(regs.pc);
 
-    if (regs.e) {
+    if (emulation_mode()) {
         if (vector == INT_BRK) {
             push8(regs.status | FLAG_BREAK);
             vector = INT_IRQ;
@@ -196,7 +208,7 @@ void interrupt6502(enum InterruptType vector) {
     cleardecimal();
     vp6502();
 
-    uint16_t vector_address = (regs.e ? 0xFFF0 : 0xFFE0) + (uint8_t) vector;
+    uint16_t vector_address = (emulation_mode() ? 0xFFF0 : 0xFFE0) + (uint8_t) vector;
     regs.pc = (uint16_t) read6502(vector_address, 0) | ((uint16_t) read6502(vector_address + 1, 0) << 8);
 
     clockticks6502 += 7; // consumed by CPU to process interrupt
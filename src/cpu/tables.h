@@ -40,82 +40,2755 @@ static void (*addrtable_c816[256])() = {
 /* F */     rel, indy, ind0,sridy,imm16,  zpx,  zpx,indly,  imp, absy,  imp,  imp, ainx, absx, absx,abslx  /* F */
 };
 
-static void (*optable_c02[256])() = {
-/*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
-/* 0 */      brk,  ora,  nop,  nop,  tsb,  ora,  asl, rmb0,  php,  ora,  asl,  nop,  tsb,  ora,  asl, bbr0, /* 0 */
-/* 1 */      bpl,  ora,  ora,  nop,  trb,  ora,  asl, rmb1,  clc,  ora,  inc,  nop,  trb,  ora,  asl, bbr1, /* 1 */
-/* 2 */      jsr,  and,  nop,  nop,  bit,  and,  rol, rmb2,  plp,  and,  rol,  nop,  bit,  and,  rol, bbr2, /* 2 */
-/* 3 */      bmi,  and,  and,  nop,  bit,  and,  rol, rmb3,  sec,  and,  dec,  nop,  bit,  and,  rol, bbr3, /* 3 */
-/* 4 */      rti,  eor,  nop,  nop,  nop,  eor,  lsr, rmb4,  pha,  eor,  lsr,  nop,  jmp,  eor,  lsr, bbr4, /* 4 */
-/* 5 */      bvc,  eor,  eor,  nop,  nop,  eor,  lsr, rmb5,  cli,  eor,  phy,  nop,  nop,  eor,  lsr, bbr5, /* 5 */
-/* 6 */      rts,  adc,  nop,  nop,  stz,  adc,  ror, rmb6,  pla,  adc,  ror,  nop,  jmp,  adc,  ror, bbr6, /* 6 */
-/* 7 */      bvs,  adc,  adc,  nop,  stz,  adc,  ror, rmb7,  sei,  adc,  ply,  nop,  jmp,  adc,  ror, bbr7, /* 7 */
-/* 8 */      bra,  sta,  nop,  nop,  sty,  sta,  stx, smb0,  dey,  bit,  txa,  nop,  sty,  sta,  stx, bbs0, /* 8 */
-/* 9 */      bcc,  sta,  sta,  nop,  sty,  sta,  stx, smb1,  tya,  sta,  txs,  nop,  stz,  sta,  stz, bbs1, /* 9 */
-/* A */      ldy,  lda,  ldx,  nop,  ldy,  lda,  ldx, smb2,  tay,  lda,  tax,  nop,  ldy,  lda,  ldx, bbs2, /* A */
-/* B */      bcs,  lda,  lda,  nop,  ldy,  lda,  ldx, smb3,  clv,  lda,  tsx,  nop,  ldy,  lda,  ldx, bbs3, /* B */
-/* C */      cpy,  cmp,  nop,  nop,  cpy,  cmp,  dec, smb4,  iny,  cmp,  dex,  wai,  cpy,  cmp,  dec, bbs4, /* C */
-/* D */      bne,  cmp,  cmp,  nop,  nop,  cmp,  dec, smb5,  cld,  cmp,  phx,  dbg,  nop,  cmp,  dec, bbs5, /* D */
-/* E */      cpx,  sbc,  nop,  nop,  cpx,  sbc,  inc, smb6,  inx,  sbc,  nop,  nop,  cpx,  sbc,  inc, bbs6, /* E */
-/* F */      beq,  sbc,  sbc,  nop,  nop,  sbc,  inc, smb7,  sed,  sbc,  plx,  nop,  nop,  sbc,  inc, bbs7  /* F */
-};
-
-static void (*optable_c816[256])() = {
-/*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
-/* 0 */      brk,  ora,  cop,  ora,  tsb,  ora,  asl,  ora,  php,  ora,  asl,  phd,  tsb,  ora,  asl,  ora, /* 0 */
-/* 1 */      bpl,  ora,  ora,  ora,  trb,  ora,  asl,  ora,  clc,  ora,  inc,  tcs,  trb,  ora,  asl,  ora, /* 1 */
-/* 2 */      jsr,  and,  jsl,  and,  bit,  and,  rol,  and,  plp,  and,  rol,  pld,  bit,  and,  rol,  and, /* 2 */
-/* 3 */      bmi,  and,  and,  and,  bit,  and,  rol,  and,  sec,  and,  dec,  tsc,  bit,  and,  rol,  and, /* 3 */
-/* 4 */      rti,  eor,  wdm,  eor,  mvp,  eor,  lsr,  eor,  pha,  eor,  lsr,  phk,  jmp,  eor,  lsr,  eor, /* 4 */
-/* 5 */      bvc,  eor,  eor,  eor,  mvn,  eor,  lsr,  eor,  cli,  eor,  phy,  tcd,  jml,  eor,  lsr,  eor, /* 5 */
-/* 6 */      rts,  adc,  per,  adc,  stz,  adc,  ror,  adc,  pla,  adc,  ror,  rtl,  jmp,  adc,  ror,  adc, /* 6 */
-/* 7 */      bvs,  adc,  adc,  adc,  stz,  adc,  ror,  adc,  sei,  adc,  ply,  tdc,  jmp,  adc,  ror,  adc, /* 7 */
-/* 8 */      bra,  sta,  brl,  sta,  sty,  sta,  stx,  sta,  dey,  bit,  txa,  phb,  sty,  sta,  stx,  sta, /* 8 */
-/* 9 */      bcc,  sta,  sta,  sta,  sty,  sta,  stx,  sta,  tya,  sta,  txs,  txy,  stz,  sta,  stz,  sta, /* 9 */
-/* A */      ldy,  lda,  ldx,  lda,  ldy,  lda,  ldx,  lda,  tay,  lda,  tax,  plb,  ldy,  lda,  ldx,  lda, /* A */
-/* B */      bcs,  lda,  lda,  lda,  ldy,  lda,  ldx,  lda,  clv,  lda,  tsx,  tyx,  ldy,  lda,  ldx,  lda, /* B */
-/* C */      cpy,  cmp,  rep,  cmp,  cpy,  cmp,  dec,  cmp,  iny,  cmp,  dex,  wai,  cpy,  cmp,  dec,  cmp, /* C */
-/* D */      bne,  cmp,  cmp,  cmp,  pei,  cmp,  dec,  cmp,  cld,  cmp,  phx,  dbg,  jml,  cmp,  dec,  cmp, /* D */
-/* E */      cpx,  sbc,  sep,  sbc,  cpx,  sbc,  inc,  sbc,  inx,  sbc,  nop,  xba,  cpx,  sbc,  inc,  sbc, /* E */
-/* F */      beq,  sbc,  sbc,  sbc,  pea,  sbc,  inc,  sbc,  sed,  sbc,  plx,  xce,  jsr,  sbc,  inc,  sbc  /* F */
-};
+static void execute_c02() {
+    switch (opcode) {
+        case 0x00: /* brk imp8 */
+            imp8();
+            brk();
+            clockticks6502 += 7;
+            break;
+        case 0x01: /* ora indx */
+            indx();
+            ora();
+            clockticks6502 += 6;
+            break;
+        case 0x02: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0x03: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x04: /* tsb zp */
+            zp();
+            tsb();
+            clockticks6502 += 5;
+            break;
+        case 0x05: /* ora zp */
+            zp();
+            ora();
+            clockticks6502 += 3;
+            break;
+        case 0x06: /* asl zp */
+            zp();
+            asl();
+            clockticks6502 += 5;
+            break;
+        case 0x07: /* rmb0 zp */
+            zp();
+            rmb0();
+            clockticks6502 += 5;
+            break;
+        case 0x08: /* php imp */
+            imp();
+            php();
+            clockticks6502 += 3;
+            break;
+        case 0x09: /* ora immm */
+            immm();
+            ora();
+            clockticks6502 += 2;
+            break;
+        case 0x0A: /* asl acc */
+            acc();
+            asl();
+            clockticks6502 += 2;
+            break;
+        case 0x0B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x0C: /* tsb abso */
+            abso();
+            tsb();
+            clockticks6502 += 6;
+            break;
+        case 0x0D: /* ora abso */
+            abso();
+            ora();
+            clockticks6502 += 4;
+            break;
+        case 0x0E: /* asl abso */
+            abso();
+            asl();
+            clockticks6502 += 6;
+            break;
+        case 0x0F: /* bbr0 zprel */
+            zprel();
+            bbr0();
+            clockticks6502 += 5;
+            break;
+        case 0x10: /* bpl rel */
+            penaltye = 0;
+            rel();
+            bpl();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x11: /* ora indy */
+            penaltyaddr = 0;
+            indy();
+            ora();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x12: /* ora ind0 */
+            ind0();
+            ora();
+            clockticks6502 += 5;
+            break;
+        case 0x13: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x14: /* trb zp */
+            zp();
+            trb();
+            clockticks6502 += 5;
+            break;
+        case 0x15: /* ora zpx */
+            zpx();
+            ora();
+            clockticks6502 += 4;
+            break;
+        case 0x16: /* asl zpx */
+            zpx();
+            asl();
+            clockticks6502 += 6;
+            break;
+        case 0x17: /* rmb1 zp */
+            zp();
+            rmb1();
+            clockticks6502 += 5;
+            break;
+        case 0x18: /* clc imp */
+            imp();
+            clc();
+            clockticks6502 += 2;
+            break;
+        case 0x19: /* ora absy */
+            penaltyaddr = 0;
+            absy();
+            ora();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x1A: /* inc acc */
+            acc();
+            inc();
+            clockticks6502 += 2;
+            break;
+        case 0x1B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x1C: /* trb abso */
+            abso();
+            trb();
+            clockticks6502 += 6;
+            break;
+        case 0x1D: /* ora absx */
+            penaltyaddr = 0;
+            absx();
+            ora();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x1E: /* asl absx */
+            absx();
+            asl();
+            clockticks6502 += 7;
+            break;
+        case 0x1F: /* bbr1 zprel */
+            zprel();
+            bbr1();
+            clockticks6502 += 5;
+            break;
+        case 0x20: /* jsr abso */
+            abso();
+            jsr();
+            clockticks6502 += 6;
+            break;
+        case 0x21: /* and indx */
+            indx();
+            and();
+            clockticks6502 += 6;
+            break;
+        case 0x22: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0x23: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x24: /* bit zp */
+            zp();
+            bit();
+            clockticks6502 += 3;
+            break;
+        case 0x25: /* and zp */
+            zp();
+            and();
+            clockticks6502 += 3;
+            break;
+        case 0x26: /* rol zp */
+            zp();
+            rol();
+            clockticks6502 += 5;
+            break;
+        case 0x27: /* rmb2 zp */
+            zp();
+            rmb2();
+            clockticks6502 += 5;
+            break;
+        case 0x28: /* plp imp */
+            imp();
+            plp();
+            clockticks6502 += 4;
+            break;
+        case 0x29: /* and immm */
+            immm();
+            and();
+            clockticks6502 += 2;
+            break;
+        case 0x2A: /* rol acc */
+            acc();
+            rol();
+            clockticks6502 += 2;
+            break;
+        case 0x2B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x2C: /* bit abso */
+            abso();
+            bit();
+            clockticks6502 += 4;
+            break;
+        case 0x2D: /* and abso */
+            abso();
+            and();
+            clockticks6502 += 4;
+            break;
+        case 0x2E: /* rol abso */
+            abso();
+            rol();
+            clockticks6502 += 6;
+            break;
+        case 0x2F: /* bbr2 zprel */
+            zprel();
+            bbr2();
+            clockticks6502 += 5;
+            break;
+        case 0x30: /* bmi rel */
+            penaltye = 0;
+            rel();
+            bmi();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x31: /* and indy */
+            penaltyaddr = 0;
+            indy();
+            and();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x32: /* and ind0 */
+            ind0();
+            and();
+            clockticks6502 += 5;
+            break;
+        case 0x33: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x34: /* bit zpx */
+            zpx();
+            bit();
+            clockticks6502 += 4;
+            break;
+        case 0x35: /* and zpx */
+            zpx();
+            and();
+            clockticks6502 += 4;
+            break;
+        case 0x36: /* rol zpx */
+            zpx();
+            rol();
+            clockticks6502 += 6;
+            break;
+        case 0x37: /* rmb3 zp */
+            zp();
+            rmb3();
+            clockticks6502 += 5;
+            break;
+        case 0x38: /* sec imp */
+            imp();
+            sec();
+            clockticks6502 += 2;
+            break;
+        case 0x39: /* and absy */
+            penaltyaddr = 0;
+            absy();
+            and();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x3A: /* dec acc */
+            acc();
+            dec();
+            clockticks6502 += 2;
+            break;
+        case 0x3B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x3C: /* bit absx */
+            absx();
+            bit();
+            clockticks6502 += 4;
+            break;
+        case 0x3D: /* and absx */
+            penaltyaddr = 0;
+            absx();
+            and();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x3E: /* rol absx */
+            absx();
+            rol();
+            clockticks6502 += 7;
+            break;
+        case 0x3F: /* bbr3 zprel */
+            zprel();
+            bbr3();
+            clockticks6502 += 5;
+            break;
+        case 0x40: /* rti imp */
+            imp();
+            rti();
+            clockticks6502 += 6;
+            break;
+        case 0x41: /* eor indx */
+            indx();
+            eor();
+            clockticks6502 += 6;
+            break;
+        case 0x42: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0x43: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x44: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 3;
+            break;
+        case 0x45: /* eor zp */
+            zp();
+            eor();
+            clockticks6502 += 3;
+            break;
+        case 0x46: /* lsr zp */
+            zp();
+            lsr();
+            clockticks6502 += 5;
+            break;
+        case 0x47: /* rmb4 zp */
+            zp();
+            rmb4();
+            clockticks6502 += 5;
+            break;
+        case 0x48: /* pha imp */
+            imp();
+            pha();
+            clockticks6502 += 3;
+            break;
+        case 0x49: /* eor immm */
+            immm();
+            eor();
+            clockticks6502 += 2;
+            break;
+        case 0x4A: /* lsr acc */
+            acc();
+            lsr();
+            clockticks6502 += 2;
+            break;
+        case 0x4B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x4C: /* jmp abso */
+            abso();
+            jmp();
+            clockticks6502 += 3;
+            break;
+        case 0x4D: /* eor abso */
+            abso();
+            eor();
+            clockticks6502 += 4;
+            break;
+        case 0x4E: /* lsr abso */
+            abso();
+            lsr();
+            clockticks6502 += 6;
+            break;
+        case 0x4F: /* bbr4 zprel */
+            zprel();
+            bbr4();
+            clockticks6502 += 5;
+            break;
+        case 0x50: /* bvc rel */
+            penaltye = 0;
+            rel();
+            bvc();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x51: /* eor indy */
+            penaltyaddr = 0;
+            indy();
+            eor();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x52: /* eor ind0 */
+            ind0();
+            eor();
+            clockticks6502 += 5;
+            break;
+        case 0x53: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x54: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 4;
+            break;
+        case 0x55: /* eor zpx */
+            zpx();
+            eor();
+            clockticks6502 += 4;
+            break;
+        case 0x56: /* lsr zpx */
+            zpx();
+            lsr();
+            clockticks6502 += 6;
+            break;
+        case 0x57: /* rmb5 zp */
+            zp();
+            rmb5();
+            clockticks6502 += 5;
+            break;
+        case 0x58: /* cli imp */
+            imp();
+            cli();
+            clockticks6502 += 2;
+            break;
+        case 0x59: /* eor absy */
+            penaltyaddr = 0;
+            absy();
+            eor();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x5A: /* phy imp */
+            imp();
+            phy();
+            clockticks6502 += 3;
+            break;
+        case 0x5B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x5C: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 8;
+            break;
+        case 0x5D: /* eor absx */
+            penaltyaddr = 0;
+            absx();
+            eor();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x5E: /* lsr absx */
+            absx();
+            lsr();
+            clockticks6502 += 7;
+            break;
+        case 0x5F: /* bbr5 zprel */
+            zprel();
+            bbr5();
+            clockticks6502 += 5;
+            break;
+        case 0x60: /* rts imp */
+            imp();
+            rts();
+            clockticks6502 += 6;
+            break;
+        case 0x61: /* adc indx */
+            indx();
+            adc();
+            clockticks6502 += 6;
+            break;
+        case 0x62: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0x63: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x64: /* stz zp */
+            zp();
+            stz();
+            clockticks6502 += 3;
+            break;
+        case 0x65: /* adc zp */
+            zp();
+            adc();
+            clockticks6502 += 3;
+            break;
+        case 0x66: /* ror zp */
+            zp();
+            ror();
+            clockticks6502 += 5;
+            break;
+        case 0x67: /* rmb6 zp */
+            zp();
+            rmb6();
+            clockticks6502 += 5;
+            break;
+        case 0x68: /* pla imp */
+            imp();
+            pla();
+            clockticks6502 += 4;
+            break;
+        case 0x69: /* adc immm */
+            immm();
+            adc();
+            clockticks6502 += 2;
+            break;
+        case 0x6A: /* ror acc */
+            acc();
+            ror();
+            clockticks6502 += 2;
+            break;
+        case 0x6B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x6C: /* jmp ind */
+            ind();
+            jmp();
+            clockticks6502 += 5;
+            break;
+        case 0x6D: /* adc abso */
+            abso();
+            adc();
+            clockticks6502 += 4;
+            break;
+        case 0x6E: /* ror abso */
+            abso();
+            ror();
+            clockticks6502 += 6;
+            break;
+        case 0x6F: /* bbr6 zprel */
+            zprel();
+            bbr6();
+            clockticks6502 += 5;
+            break;
+        case 0x70: /* bvs rel */
+            penaltye = 0;
+            rel();
+            bvs();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x71: /* adc indy */
+            penaltyaddr = 0;
+            indy();
+            adc();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x72: /* adc ind0 */
+            ind0();
+            adc();
+            clockticks6502 += 5;
+            break;
+        case 0x73: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x74: /* stz zpx */
+            zpx();
+            stz();
+            clockticks6502 += 4;
+            break;
+        case 0x75: /* adc zpx */
+            zpx();
+            adc();
+            clockticks6502 += 4;
+            break;
+        case 0x76: /* ror zpx */
+            zpx();
+            ror();
+            clockticks6502 += 6;
+            break;
+        case 0x77: /* rmb7 zp */
+            zp();
+            rmb7();
+            clockticks6502 += 5;
+            break;
+        case 0x78: /* sei imp */
+            imp();
+            sei();
+            clockticks6502 += 2;
+            break;
+        case 0x79: /* adc absy */
+            penaltyaddr = 0;
+            absy();
+            adc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x7A: /* ply imp */
+            imp();
+            ply();
+            clockticks6502 += 4;
+            break;
+        case 0x7B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x7C: /* jmp ainx */
+            ainx();
+            jmp();
+            clockticks6502 += 6;
+            break;
+        case 0x7D: /* adc absx */
+            penaltyaddr = 0;
+            absx();
+            adc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x7E: /* ror absx */
+            absx();
+            ror();
+            clockticks6502 += 7;
+            break;
+        case 0x7F: /* bbr7 zprel */
+            zprel();
+            bbr7();
+            clockticks6502 += 5;
+            break;
+        case 0x80: /* bra rel */
+            rel();
+            bra();
+            clockticks6502 += 3;
+            break;
+        case 0x81: /* sta indx */
+            indx();
+            sta();
+            clockticks6502 += 6;
+            break;
+        case 0x82: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0x83: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x84: /* sty zp */
+            zp();
+            sty();
+            clockticks6502 += 3;
+            break;
+        case 0x85: /* sta zp */
+            zp();
+            sta();
+            clockticks6502 += 3;
+            break;
+        case 0x86: /* stx zp */
+            zp();
+            stx();
+            clockticks6502 += 3;
+            break;
+        case 0x87: /* smb0 zp */
+            zp();
+            smb0();
+            clockticks6502 += 5;
+            break;
+        case 0x88: /* dey imp */
+            imp();
+            dey();
+            clockticks6502 += 2;
+            break;
+        case 0x89: /* bit immm */
+            immm();
+            bit();
+            clockticks6502 += 2;
+            break;
+        case 0x8A: /* txa imp */
+            imp();
+            txa();
+            clockticks6502 += 2;
+            break;
+        case 0x8B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x8C: /* sty abso */
+            abso();
+            sty();
+            clockticks6502 += 4;
+            break;
+        case 0x8D: /* sta abso */
+            abso();
+            sta();
+            clockticks6502 += 4;
+            break;
+        case 0x8E: /* stx abso */
+            abso();
+            stx();
+            clockticks6502 += 4;
+            break;
+        case 0x8F: /* bbs0 zprel */
+            zprel();
+            bbs0();
+            clockticks6502 += 5;
+            break;
+        case 0x90: /* bcc rel */
+            penaltye = 0;
+            rel();
+            bcc();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x91: /* sta indy */
+            indy();
+            sta();
+            clockticks6502 += 6;
+            break;
+        case 0x92: /* sta ind0 */
+            ind0();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x93: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x94: /* sty zpx */
+            zpx();
+            sty();
+            clockticks6502 += 4;
+            break;
+        case 0x95: /* sta zpx */
+            zpx();
+            sta();
+            clockticks6502 += 4;
+            break;
+        case 0x96: /* stx zpy */
+            zpy();
+            stx();
+            clockticks6502 += 4;
+            break;
+        case 0x97: /* smb1 zp */
+            zp();
+            smb1();
+            clockticks6502 += 5;
+            break;
+        case 0x98: /* tya imp */
+            imp();
+            tya();
+            clockticks6502 += 2;
+            break;
+        case 0x99: /* sta absy */
+            absy();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x9A: /* txs imp */
+            imp();
+            txs();
+            clockticks6502 += 2;
+            break;
+        case 0x9B: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0x9C: /* stz abso */
+            abso();
+            stz();
+            clockticks6502 += 4;
+            break;
+        case 0x9D: /* sta absx */
+            absx();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x9E: /* stz absx */
+            absx();
+            stz();
+            clockticks6502 += 5;
+            break;
+        case 0x9F: /* bbs1 zprel */
+            zprel();
+            bbs1();
+            clockticks6502 += 5;
+            break;
+        case 0xA0: /* ldy immx */
+            immx();
+            ldy();
+            clockticks6502 += 2;
+            break;
+        case 0xA1: /* lda indx */
+            indx();
+            lda();
+            clockticks6502 += 6;
+            break;
+        case 0xA2: /* ldx immx */
+            immx();
+            ldx();
+            clockticks6502 += 2;
+            break;
+        case 0xA3: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xA4: /* ldy zp */
+            zp();
+            ldy();
+            clockticks6502 += 3;
+            break;
+        case 0xA5: /* lda zp */
+            zp();
+            lda();
+            clockticks6502 += 3;
+            break;
+        case 0xA6: /* ldx zp */
+            zp();
+            ldx();
+            clockticks6502 += 3;
+            break;
+        case 0xA7: /* smb2 zp */
+            zp();
+            smb2();
+            clockticks6502 += 5;
+            break;
+        case 0xA8: /* tay imp */
+            imp();
+            tay();
+            clockticks6502 += 2;
+            break;
+        case 0xA9: /* lda immm */
+            immm();
+            lda();
+            clockticks6502 += 2;
+            break;
+        case 0xAA: /* tax imp */
+            imp();
+            tax();
+            clockticks6502 += 2;
+            break;
+        case 0xAB: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xAC: /* ldy abso */
+            abso();
+            ldy();
+            clockticks6502 += 4;
+            break;
+        case 0xAD: /* lda abso */
+            abso();
+            lda();
+            clockticks6502 += 4;
+            break;
+        case 0xAE: /* ldx abso */
+            abso();
+            ldx();
+            clockticks6502 += 4;
+            break;
+        case 0xAF: /* bbs2 zprel */
+            zprel();
+            bbs2();
+            clockticks6502 += 5;
+            break;
+        case 0xB0: /* bcs rel */
+            penaltye = 0;
+            rel();
+            bcs();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0xB1: /* lda indy */
+            penaltyaddr = 0;
+            indy();
+            lda();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xB2: /* lda ind0 */
+            ind0();
+            lda();
+            clockticks6502 += 5;
+            break;
+        case 0xB3: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xB4: /* ldy zpx */
+            zpx();
+            ldy();
+            clockticks6502 += 4;
+            break;
+        case 0xB5: /* lda zpx */
+            zpx();
+            lda();
+            clockticks6502 += 4;
+            break;
+        case 0xB6: /* ldx zpy */
+            zpy();
+            ldx();
+            clockticks6502 += 4;
+            break;
+        case 0xB7: /* smb3 zp */
+            zp();
+            smb3();
+            clockticks6502 += 5;
+            break;
+        case 0xB8: /* clv imp */
+            imp();
+            clv();
+            clockticks6502 += 2;
+            break;
+        case 0xB9: /* lda absy */
+            penaltyaddr = 0;
+            absy();
+            lda();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xBA: /* tsx imp */
+            imp();
+            tsx();
+            clockticks6502 += 2;
+            break;
+        case 0xBB: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xBC: /* ldy absx */
+            penaltyaddr = 0;
+            absx();
+            ldy();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xBD: /* lda absx */
+            penaltyaddr = 0;
+            absx();
+            lda();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xBE: /* ldx absy */
+            penaltyaddr = 0;
+            absy();
+            ldx();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xBF: /* bbs3 zprel */
+            zprel();
+            bbs3();
+            clockticks6502 += 5;
+            break;
+        case 0xC0: /* cpy immx */
+            immx();
+            cpy();
+            clockticks6502 += 2;
+            break;
+        case 0xC1: /* cmp indx */
+            indx();
+            cmp();
+            clockticks6502 += 6;
+            break;
+        case 0xC2: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0xC3: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xC4: /* cpy zp */
+            zp();
+            cpy();
+            clockticks6502 += 3;
+            break;
+        case 0xC5: /* cmp zp */
+            zp();
+            cmp();
+            clockticks6502 += 3;
+            break;
+        case 0xC6: /* dec zp */
+            zp();
+            dec();
+            clockticks6502 += 5;
+            break;
+        case 0xC7: /* smb4 zp */
+            zp();
+            smb4();
+            clockticks6502 += 5;
+            break;
+        case 0xC8: /* iny imp */
+            imp();
+            iny();
+            clockticks6502 += 2;
+            break;
+        case 0xC9: /* cmp immm */
+            immm();
+            cmp();
+            clockticks6502 += 2;
+            break;
+        case 0xCA: /* dex imp */
+            imp();
+            dex();
+            clockticks6502 += 2;
+            break;
+        case 0xCB: /* wai imp */
+            imp();
+            wai();
+            clockticks6502 += 3;
+            break;
+        case 0xCC: /* cpy abso */
+            abso();
+            cpy();
+            clockticks6502 += 4;
+            break;
+        case 0xCD: /* cmp abso */
+            abso();
+            cmp();
+            clockticks6502 += 4;
+            break;
+        case 0xCE: /* dec abso */
+            abso();
+            dec();
+            clockticks6502 += 6;
+            break;
+        case 0xCF: /* bbs4 zprel */
+            zprel();
+            bbs4();
+            clockticks6502 += 5;
+            break;
+        case 0xD0: /* bne rel */
+            penaltye = 0;
+            rel();
+            bne();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0xD1: /* cmp indy */
+            penaltyaddr = 0;
+            indy();
+            cmp();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xD2: /* cmp ind0 */
+            ind0();
+            cmp();
+            clockticks6502 += 5;
+            break;
+        case 0xD3: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xD4: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 4;
+            break;
+        case 0xD5: /* cmp zpx */
+            zpx();
+            cmp();
+            clockticks6502 += 4;
+            break;
+        case 0xD6: /* dec zpx */
+            zpx();
+            dec();
+            clockticks6502 += 6;
+            break;
+        case 0xD7: /* smb5 zp */
+            zp();
+            smb5();
+            clockticks6502 += 5;
+            break;
+        case 0xD8: /* cld imp */
+            imp();
+            cld();
+            clockticks6502 += 2;
+            break;
+        case 0xD9: /* cmp absy */
+            penaltyaddr = 0;
+            absy();
+            cmp();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xDA: /* phx imp */
+            imp();
+            phx();
+            clockticks6502 += 3;
+            break;
+        case 0xDB: /* dbg imp */
+            imp();
+            dbg();
+            clockticks6502 += 1;
+            break;
+        case 0xDC: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 4;
+            break;
+        case 0xDD: /* cmp absx */
+            penaltyaddr = 0;
+            absx();
+            cmp();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xDE: /* dec absx */
+            absx();
+            dec();
+            clockticks6502 += 7;
+            break;
+        case 0xDF: /* bbs5 zprel */
+            zprel();
+            bbs5();
+            clockticks6502 += 5;
+            break;
+        case 0xE0: /* cpx immx */
+            immx();
+            cpx();
+            clockticks6502 += 2;
+            break;
+        case 0xE1: /* sbc indx */
+            indx();
+            sbc();
+            clockticks6502 += 6;
+            break;
+        case 0xE2: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0xE3: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xE4: /* cpx zp */
+            zp();
+            cpx();
+            clockticks6502 += 3;
+            break;
+        case 0xE5: /* sbc zp */
+            zp();
+            sbc();
+            clockticks6502 += 3;
+            break;
+        case 0xE6: /* inc zp */
+            zp();
+            inc();
+            clockticks6502 += 5;
+            break;
+        case 0xE7: /* smb6 zp */
+            zp();
+            smb6();
+            clockticks6502 += 5;
+            break;
+        case 0xE8: /* inx imp */
+            imp();
+            inx();
+            clockticks6502 += 2;
+            break;
+        case 0xE9: /* sbc immm */
+            immm();
+            sbc();
+            clockticks6502 += 2;
+            break;
+        case 0xEA: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0xEB: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xEC: /* cpx abso */
+            abso();
+            cpx();
+            clockticks6502 += 4;
+            break;
+        case 0xED: /* sbc abso */
+            abso();
+            sbc();
+            clockticks6502 += 4;
+            break;
+        case 0xEE: /* inc abso */
+            abso();
+            inc();
+            clockticks6502 += 6;
+            break;
+        case 0xEF: /* bbs6 zprel */
+            zprel();
+            bbs6();
+            clockticks6502 += 5;
+            break;
+        case 0xF0: /* beq rel */
+            penaltye = 0;
+            rel();
+            beq();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0xF1: /* sbc indy */
+            penaltyaddr = 0;
+            indy();
+            sbc();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xF2: /* sbc ind0 */
+            ind0();
+            sbc();
+            clockticks6502 += 5;
+            break;
+        case 0xF3: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xF4: /* nop imm8 */
+            imm8();
+            nop();
+            clockticks6502 += 4;
+            break;
+        case 0xF5: /* sbc zpx */
+            zpx();
+            sbc();
+            clockticks6502 += 4;
+            break;
+        case 0xF6: /* inc zpx */
+            zpx();
+            inc();
+            clockticks6502 += 6;
+            break;
+        case 0xF7: /* smb7 zp */
+            zp();
+            smb7();
+            clockticks6502 += 5;
+            break;
+        case 0xF8: /* sed imp */
+            imp();
+            sed();
+            clockticks6502 += 2;
+            break;
+        case 0xF9: /* sbc absy */
+            penaltyaddr = 0;
+            absy();
+            sbc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xFA: /* plx imp */
+            imp();
+            plx();
+            clockticks6502 += 4;
+            break;
+        case 0xFB: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 1;
+            break;
+        case 0xFC: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 4;
+            break;
+        case 0xFD: /* sbc absx */
+            penaltyaddr = 0;
+            absx();
+            sbc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xFE: /* inc absx */
+            absx();
+            inc();
+            clockticks6502 += 7;
+            break;
+        case 0xFF: /* bbs7 zprel */
+            zprel();
+            bbs7();
+            clockticks6502 += 5;
+            break;
+    }
+}
 
-static const uint32_t ticktable_c02[256] = {
-/*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
-/* 0 */       7,    6,    2,    1,    5,    3,    5,    5,    3,    2,    2,    1,    6,    4,    6,    5, /* 0 */
-/* 1 */       2,    5,    5,    1,    5,    4,    6,    5,    2,    4,    2,    1,    6,    4,    7,    5, /* 1 */
-/* 2 */       6,    6,    2,    1,    3,    3,    5,    5,    4,    2,    2,    1,    4,    4,    6,    5, /* 2 */
-/* 3 */       2,    5,    5,    1,    4,    4,    6,    5,    2,    4,    2,    1,    4,    4,    7,    5, /* 3 */
-/* 4 */       6,    6,    2,    1,    3,    3,    5,    5,    3,    2,    2,    1,    3,    4,    6,    5, /* 4 */
-/* 5 */       2,    5,    5,    1,    4,    4,    6,    5,    2,    4,    3,    1,    8,    4,    7,    5, /* 5 */
-/* 6 */       6,    6,    2,    1,    3,    3,    5,    5,    4,    2,    2,    1,    5,    4,    6,    5, /* 6 */
-/* 7 */       2,    5,    5,    1,    4,    4,    6,    5,    2,    4,    4,    1,    6,    4,    7,    5, /* 7 */
-/* 8 */       3,    6,    2,    1,    3,    3,    3,    5,    2,    2,    2,    1,    4,    4,    4,    5, /* 8 */
-/* 9 */       2,    6,    5,    1,    4,    4,    4,    5,    2,    5,    2,    1,    4,    5,    5,    5, /* 9 */
-/* A */       2,    6,    2,    1,    3,    3,    3,    5,    2,    2,    2,    1,    4,    4,    4,    5, /* A */
-/* B */       2,    5,    5,    1,    4,    4,    4,    5,    2,    4,    2,    1,    4,    4,    4,    5, /* B */
-/* C */       2,    6,    2,    1,    3,    3,    5,    5,    2,    2,    2,    3,    4,    4,    6,    5, /* C */
-/* D */       2,    5,    5,    1,    4,    4,    6,    5,    2,    4,    3,    1,    4,    4,    7,    5, /* D */
-/* E */       2,    6,    2,    1,    3,    3,    5,    5,    2,    2,    2,    1,    4,    4,    6,    5, /* E */
-/* F */       2,    5,    5,    1,    4,    4,    6,    5,    2,    4,    4,    1,    4,    4,    7,    5  /* F */
-};
-
-static const uint32_t ticktable_c816[256] = {
-/*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
-/* 0 */       7,    6,    7,    4,    5,    3,    5,    6,    3,    2,    2,    4,    6,    4,    6,    5, /* 0 */
-/* 1 */       2,    5,    5,    7,    5,    4,    6,    6,    2,    4,    2,    2,    6,    4,    7,    5, /* 1 */
-/* 2 */       6,    6,    8,    4,    3,    3,    5,    6,    4,    2,    2,    5,    4,    4,    6,    5, /* 2 */
-/* 3 */       2,    5,    5,    7,    4,    4,    6,    6,    2,    4,    2,    2,    4,    4,    7,    5, /* 3 */
-/* 4 */       6,    6,    2,    4,    7,    3,    5,    6,    3,    2,    2,    3,    3,    4,    6,    5, /* 4 */
-/* 5 */       2,    5,    5,    7,    7,    4,    6,    6,    2,    4,    3,    2,    4,    4,    7,    5, /* 5 */
-/* 6 */       6,    6,    6,    4,    3,    3,    5,    6,    4,    2,    2,    6,    5,    4,    6,    5, /* 6 */
-/* 7 */       2,    5,    5,    7,    4,    4,    6,    6,    2,    4,    4,    2,    6,    4,    7,    5, /* 7 */
-/* 8 */       3,    6,    4,    4,    3,    3,    3,    6,    2,    2,    2,    3,    4,    4,    4,    5, /* 8 */
-/* 9 */       2,    6,    5,    7,    4,    4,    4,    6,    2,    5,    2,    2,    4,    5,    5,    5, /* 9 */
-/* A */       2,    6,    2,    4,    3,    3,    3,    6,    2,    2,    2,    4,    4,    4,    4,    5, /* A */
-/* B */       2,    5,    5,    7,    4,    4,    4,    6,    2,    4,    2,    2,    4,    4,    4,    5, /* B */
-/* C */       2,    6,    3,    4,    3,    3,    5,    6,    2,    2,    2,    3,    4,    4,    6,    5, /* C */
-/* D */       2,    5,    5,    7,    6,    4,    6,    6,    2,    4,    3,    1,    6,    4,    7,    5, /* D */
-/* E */       2,    6,    3,    4,    3,    3,    5,    6,    2,    2,    2,    3,    4,    4,    6,    5, /* E */
-/* F */       2,    5,    5,    7,    5,    4,    6,    6,    2,    4,    4,    2,    8,    4,    7,    5  /* F */
-};
+static void execute_c816() {
+    switch (opcode) {
+        case 0x00: /* brk imp8 */
+            imp8();
+            brk();
+            clockticks6502 += 7;
+            if (!emulation_mode()) clockticks6502++;
+            break;
+        case 0x01: /* ora indx */
+            indx();
+            ora();
+            clockticks6502 += 6;
+            break;
+        case 0x02: /* cop imp8 */
+            imp8();
+            cop();
+            clockticks6502 += 7;
+            if (!emulation_mode()) clockticks6502++;
+            break;
+        case 0x03: /* ora sr */
+            sr();
+            ora();
+            clockticks6502 += 4;
+            break;
+        case 0x04: /* tsb zp */
+            zp();
+            tsb();
+            clockticks6502 += 5;
+            break;
+        case 0x05: /* ora zp */
+            zp();
+            ora();
+            clockticks6502 += 3;
+            break;
+        case 0x06: /* asl zp */
+            zp();
+            asl();
+            clockticks6502 += 5;
+            break;
+        case 0x07: /* ora indl0 */
+            indl0();
+            ora();
+            clockticks6502 += 6;
+            break;
+        case 0x08: /* php imp */
+            imp();
+            php();
+            clockticks6502 += 3;
+            break;
+        case 0x09: /* ora immm */
+            immm();
+            ora();
+            clockticks6502 += 2;
+            break;
+        case 0x0A: /* asl acc */
+            acc();
+            asl();
+            clockticks6502 += 2;
+            break;
+        case 0x0B: /* phd imp */
+            imp();
+            phd();
+            clockticks6502 += 4;
+            break;
+        case 0x0C: /* tsb abso */
+            abso();
+            tsb();
+            clockticks6502 += 6;
+            break;
+        case 0x0D: /* ora abso */
+            abso();
+            ora();
+            clockticks6502 += 4;
+            break;
+        case 0x0E: /* asl abso */
+            abso();
+            asl();
+            clockticks6502 += 6;
+            break;
+        case 0x0F: /* ora absl */
+            absl();
+            ora();
+            clockticks6502 += 5;
+            break;
+        case 0x10: /* bpl rel */
+            penaltye = 0;
+            rel();
+            bpl();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x11: /* ora indy */
+            penaltyaddr = 0;
+            indy();
+            ora();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x12: /* ora ind0 */
+            ind0();
+            ora();
+            clockticks6502 += 5;
+            break;
+        case 0x13: /* ora sridy */
+            penaltyaddr = 0;
+            sridy();
+            ora();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x14: /* trb zp */
+            zp();
+            trb();
+            clockticks6502 += 5;
+            break;
+        case 0x15: /* ora zpx */
+            zpx();
+            ora();
+            clockticks6502 += 4;
+            break;
+        case 0x16: /* asl zpx */
+            zpx();
+            asl();
+            clockticks6502 += 6;
+            break;
+        case 0x17: /* ora indly */
+            indly();
+            ora();
+            clockticks6502 += 6;
+            break;
+        case 0x18: /* clc imp */
+            imp();
+            clc();
+            clockticks6502 += 2;
+            break;
+        case 0x19: /* ora absy */
+            penaltyaddr = 0;
+            absy();
+            ora();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x1A: /* inc acc */
+            acc();
+            inc();
+            clockticks6502 += 2;
+            break;
+        case 0x1B: /* tcs imp */
+            imp();
+            tcs();
+            clockticks6502 += 2;
+            break;
+        case 0x1C: /* trb abso */
+            abso();
+            trb();
+            clockticks6502 += 6;
+            break;
+        case 0x1D: /* ora absx */
+            penaltyaddr = 0;
+            absx();
+            ora();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x1E: /* asl absx */
+            absx();
+            asl();
+            clockticks6502 += 7;
+            break;
+        case 0x1F: /* ora abslx */
+            penaltyaddr = 0;
+            abslx();
+            ora();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x20: /* jsr abso */
+            abso();
+            jsr();
+            clockticks6502 += 6;
+            break;
+        case 0x21: /* and indx */
+            indx();
+            and();
+            clockticks6502 += 6;
+            break;
+        case 0x22: /* jsl absl */
+            absl();
+            jsl();
+            clockticks6502 += 8;
+            break;
+        case 0x23: /* and sr */
+            sr();
+            and();
+            clockticks6502 += 4;
+            break;
+        case 0x24: /* bit zp */
+            zp();
+            bit();
+            clockticks6502 += 3;
+            break;
+        case 0x25: /* and zp */
+            zp();
+            and();
+            clockticks6502 += 3;
+            break;
+        case 0x26: /* rol zp */
+            zp();
+            rol();
+            clockticks6502 += 5;
+            break;
+        case 0x27: /* and indl0 */
+            indl0();
+            and();
+            clockticks6502 += 6;
+            break;
+        case 0x28: /* plp imp */
+            imp();
+            plp();
+            clockticks6502 += 4;
+            break;
+        case 0x29: /* and immm */
+            immm();
+            and();
+            clockticks6502 += 2;
+            break;
+        case 0x2A: /* rol acc */
+            acc();
+            rol();
+            clockticks6502 += 2;
+            break;
+        case 0x2B: /* pld imp */
+            imp();
+            pld();
+            clockticks6502 += 5;
+            break;
+        case 0x2C: /* bit abso */
+            abso();
+            bit();
+            clockticks6502 += 4;
+            break;
+        case 0x2D: /* and abso */
+            abso();
+            and();
+            clockticks6502 += 4;
+            break;
+        case 0x2E: /* rol abso */
+            abso();
+            rol();
+            clockticks6502 += 6;
+            break;
+        case 0x2F: /* and absl */
+            absl();
+            and();
+            clockticks6502 += 5;
+            break;
+        case 0x30: /* bmi rel */
+            penaltye = 0;
+            rel();
+            bmi();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x31: /* and indy */
+            penaltyaddr = 0;
+            indy();
+            and();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x32: /* and ind0 */
+            ind0();
+            and();
+            clockticks6502 += 5;
+            break;
+        case 0x33: /* and sridy */
+            penaltyaddr = 0;
+            sridy();
+            and();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x34: /* bit zpx */
+            zpx();
+            bit();
+            clockticks6502 += 4;
+            break;
+        case 0x35: /* and zpx */
+            zpx();
+            and();
+            clockticks6502 += 4;
+            break;
+        case 0x36: /* rol zpx */
+            zpx();
+            rol();
+            clockticks6502 += 6;
+            break;
+        case 0x37: /* and indly */
+            indly();
+            and();
+            clockticks6502 += 6;
+            break;
+        case 0x38: /* sec imp */
+            imp();
+            sec();
+            clockticks6502 += 2;
+            break;
+        case 0x39: /* and absy */
+            penaltyaddr = 0;
+            absy();
+            and();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x3A: /* dec acc */
+            acc();
+            dec();
+            clockticks6502 += 2;
+            break;
+        case 0x3B: /* tsc imp */
+            imp();
+            tsc();
+            clockticks6502 += 2;
+            break;
+        case 0x3C: /* bit absx */
+            absx();
+            bit();
+            clockticks6502 += 4;
+            break;
+        case 0x3D: /* and absx */
+            penaltyaddr = 0;
+            absx();
+            and();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x3E: /* rol absx */
+            absx();
+            rol();
+            clockticks6502 += 7;
+            break;
+        case 0x3F: /* and abslx */
+            penaltyaddr = 0;
+            abslx();
+            and();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x40: /* rti imp */
+            imp();
+            rti();
+            clockticks6502 += 6;
+            break;
+        case 0x41: /* eor indx */
+            indx();
+            eor();
+            clockticks6502 += 6;
+            break;
+        case 0x42: /* wdm imm8 */
+            imm8();
+            wdm();
+            clockticks6502 += 2;
+            break;
+        case 0x43: /* eor sr */
+            sr();
+            eor();
+            clockticks6502 += 4;
+            break;
+        case 0x44: /* mvp bmv */
+            bmv();
+            mvp();
+            clockticks6502 += 7;
+            break;
+        case 0x45: /* eor zp */
+            zp();
+            eor();
+            clockticks6502 += 3;
+            break;
+        case 0x46: /* lsr zp */
+            zp();
+            lsr();
+            clockticks6502 += 5;
+            break;
+        case 0x47: /* eor indl0 */
+            indl0();
+            eor();
+            clockticks6502 += 6;
+            break;
+        case 0x48: /* pha imp */
+            imp();
+            pha();
+            clockticks6502 += 3;
+            break;
+        case 0x49: /* eor immm */
+            immm();
+            eor();
+            clockticks6502 += 2;
+            break;
+        case 0x4A: /* lsr acc */
+            acc();
+            lsr();
+            clockticks6502 += 2;
+            break;
+        case 0x4B: /* phk imp */
+            imp();
+            phk();
+            clockticks6502 += 3;
+            break;
+        case 0x4C: /* jmp abso */
+            abso();
+            jmp();
+            clockticks6502 += 3;
+            break;
+        case 0x4D: /* eor abso */
+            abso();
+            eor();
+            clockticks6502 += 4;
+            break;
+        case 0x4E: /* lsr abso */
+            abso();
+            lsr();
+            clockticks6502 += 6;
+            break;
+        case 0x4F: /* eor absl */
+            absl();
+            eor();
+            clockticks6502 += 5;
+            break;
+        case 0x50: /* bvc rel */
+            penaltye = 0;
+            rel();
+            bvc();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x51: /* eor indy */
+            penaltyaddr = 0;
+            indy();
+            eor();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x52: /* eor ind0 */
+            ind0();
+            eor();
+            clockticks6502 += 5;
+            break;
+        case 0x53: /* eor sridy */
+            penaltyaddr = 0;
+            sridy();
+            eor();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x54: /* mvn bmv */
+            bmv();
+            mvn();
+            clockticks6502 += 7;
+            break;
+        case 0x55: /* eor zpx */
+            zpx();
+            eor();
+            clockticks6502 += 4;
+            break;
+        case 0x56: /* lsr zpx */
+            zpx();
+            lsr();
+            clockticks6502 += 6;
+            break;
+        case 0x57: /* eor indly */
+            indly();
+            eor();
+            clockticks6502 += 6;
+            break;
+        case 0x58: /* cli imp */
+            imp();
+            cli();
+            clockticks6502 += 2;
+            break;
+        case 0x59: /* eor absy */
+            penaltyaddr = 0;
+            absy();
+            eor();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x5A: /* phy imp */
+            imp();
+            phy();
+            clockticks6502 += 3;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0x5B: /* tcd imp */
+            imp();
+            tcd();
+            clockticks6502 += 2;
+            break;
+        case 0x5C: /* jml absl */
+            absl();
+            jml();
+            clockticks6502 += 4;
+            break;
+        case 0x5D: /* eor absx */
+            penaltyaddr = 0;
+            absx();
+            eor();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x5E: /* lsr absx */
+            absx();
+            lsr();
+            clockticks6502 += 7;
+            break;
+        case 0x5F: /* eor abslx */
+            penaltyaddr = 0;
+            abslx();
+            eor();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x60: /* rts imp */
+            imp();
+            rts();
+            clockticks6502 += 6;
+            break;
+        case 0x61: /* adc indx */
+            indx();
+            adc();
+            clockticks6502 += 6;
+            break;
+        case 0x62: /* per rel16 */
+            rel16();
+            per();
+            clockticks6502 += 6;
+            break;
+        case 0x63: /* adc sr */
+            sr();
+            adc();
+            clockticks6502 += 4;
+            break;
+        case 0x64: /* stz zp */
+            zp();
+            stz();
+            clockticks6502 += 3;
+            break;
+        case 0x65: /* adc zp */
+            zp();
+            adc();
+            clockticks6502 += 3;
+            break;
+        case 0x66: /* ror zp */
+            zp();
+            ror();
+            clockticks6502 += 5;
+            break;
+        case 0x67: /* adc indl0 */
+            indl0();
+            adc();
+            clockticks6502 += 6;
+            break;
+        case 0x68: /* pla imp */
+            imp();
+            pla();
+            clockticks6502 += 4;
+            break;
+        case 0x69: /* adc immm */
+            immm();
+            adc();
+            clockticks6502 += 2;
+            break;
+        case 0x6A: /* ror acc */
+            acc();
+            ror();
+            clockticks6502 += 2;
+            break;
+        case 0x6B: /* rtl imp */
+            imp();
+            rtl();
+            clockticks6502 += 6;
+            break;
+        case 0x6C: /* jmp ind */
+            ind();
+            jmp();
+            clockticks6502 += 5;
+            break;
+        case 0x6D: /* adc abso */
+            abso();
+            adc();
+            clockticks6502 += 4;
+            break;
+        case 0x6E: /* ror abso */
+            abso();
+            ror();
+            clockticks6502 += 6;
+            break;
+        case 0x6F: /* adc absl */
+            absl();
+            adc();
+            clockticks6502 += 5;
+            break;
+        case 0x70: /* bvs rel */
+            penaltye = 0;
+            rel();
+            bvs();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x71: /* adc indy */
+            penaltyaddr = 0;
+            indy();
+            adc();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x72: /* adc ind0 */
+            ind0();
+            adc();
+            clockticks6502 += 5;
+            break;
+        case 0x73: /* adc sridy */
+            penaltyaddr = 0;
+            sridy();
+            adc();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x74: /* stz zpx */
+            zpx();
+            stz();
+            clockticks6502 += 4;
+            break;
+        case 0x75: /* adc zpx */
+            zpx();
+            adc();
+            clockticks6502 += 4;
+            break;
+        case 0x76: /* ror zpx */
+            zpx();
+            ror();
+            clockticks6502 += 6;
+            break;
+        case 0x77: /* adc indly */
+            indly();
+            adc();
+            clockticks6502 += 6;
+            break;
+        case 0x78: /* sei imp */
+            imp();
+            sei();
+            clockticks6502 += 2;
+            break;
+        case 0x79: /* adc absy */
+            penaltyaddr = 0;
+            absy();
+            adc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x7A: /* ply imp */
+            imp();
+            ply();
+            clockticks6502 += 4;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0x7B: /* tdc imp */
+            imp();
+            tdc();
+            clockticks6502 += 2;
+            break;
+        case 0x7C: /* jmp ainx */
+            ainx();
+            jmp();
+            clockticks6502 += 6;
+            break;
+        case 0x7D: /* adc absx */
+            penaltyaddr = 0;
+            absx();
+            adc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x7E: /* ror absx */
+            absx();
+            ror();
+            clockticks6502 += 7;
+            break;
+        case 0x7F: /* adc abslx */
+            penaltyaddr = 0;
+            abslx();
+            adc();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0x80: /* bra rel */
+            rel();
+            bra();
+            clockticks6502 += 3;
+            break;
+        case 0x81: /* sta indx */
+            indx();
+            sta();
+            clockticks6502 += 6;
+            break;
+        case 0x82: /* brl rel16 */
+            rel16();
+            brl();
+            clockticks6502 += 4;
+            break;
+        case 0x83: /* sta sr */
+            sr();
+            sta();
+            clockticks6502 += 4;
+            break;
+        case 0x84: /* sty zp */
+            zp();
+            sty();
+            clockticks6502 += 3;
+            break;
+        case 0x85: /* sta zp */
+            zp();
+            sta();
+            clockticks6502 += 3;
+            break;
+        case 0x86: /* stx zp */
+            zp();
+            stx();
+            clockticks6502 += 3;
+            break;
+        case 0x87: /* sta indl0 */
+            indl0();
+            sta();
+            clockticks6502 += 6;
+            break;
+        case 0x88: /* dey imp */
+            imp();
+            dey();
+            clockticks6502 += 2;
+            break;
+        case 0x89: /* bit immm */
+            immm();
+            bit();
+            clockticks6502 += 2;
+            break;
+        case 0x8A: /* txa imp */
+            imp();
+            txa();
+            clockticks6502 += 2;
+            break;
+        case 0x8B: /* phb imp */
+            imp();
+            phb();
+            clockticks6502 += 3;
+            break;
+        case 0x8C: /* sty abso */
+            abso();
+            sty();
+            clockticks6502 += 4;
+            break;
+        case 0x8D: /* sta abso */
+            abso();
+            sta();
+            clockticks6502 += 4;
+            break;
+        case 0x8E: /* stx abso */
+            abso();
+            stx();
+            clockticks6502 += 4;
+            break;
+        case 0x8F: /* sta absl */
+            absl();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x90: /* bcc rel */
+            penaltye = 0;
+            rel();
+            bcc();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0x91: /* sta indy */
+            indy();
+            sta();
+            clockticks6502 += 6;
+            break;
+        case 0x92: /* sta ind0 */
+            ind0();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x93: /* sta sridy */
+            sridy();
+            sta();
+            clockticks6502 += 7;
+            break;
+        case 0x94: /* sty zpx */
+            zpx();
+            sty();
+            clockticks6502 += 4;
+            break;
+        case 0x95: /* sta zpx */
+            zpx();
+            sta();
+            clockticks6502 += 4;
+            break;
+        case 0x96: /* stx zpy */
+            zpy();
+            stx();
+            clockticks6502 += 4;
+            break;
+        case 0x97: /* sta indly */
+            indly();
+            sta();
+            clockticks6502 += 6;
+            break;
+        case 0x98: /* tya imp */
+            imp();
+            tya();
+            clockticks6502 += 2;
+            break;
+        case 0x99: /* sta absy */
+            absy();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x9A: /* txs imp */
+            imp();
+            txs();
+            clockticks6502 += 2;
+            break;
+        case 0x9B: /* txy imp */
+            imp();
+            txy();
+            clockticks6502 += 2;
+            break;
+        case 0x9C: /* stz abso */
+            abso();
+            stz();
+            clockticks6502 += 4;
+            break;
+        case 0x9D: /* sta absx */
+            absx();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0x9E: /* stz absx */
+            absx();
+            stz();
+            clockticks6502 += 5;
+            break;
+        case 0x9F: /* sta abslx */
+            abslx();
+            sta();
+            clockticks6502 += 5;
+            break;
+        case 0xA0: /* ldy immx */
+            immx();
+            ldy();
+            clockticks6502 += 2;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xA1: /* lda indx */
+            indx();
+            lda();
+            clockticks6502 += 6;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xA2: /* ldx immx */
+            immx();
+            ldx();
+            clockticks6502 += 2;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xA3: /* lda sr */
+            sr();
+            lda();
+            clockticks6502 += 4;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xA4: /* ldy zp */
+            zp();
+            ldy();
+            clockticks6502 += 3;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xA5: /* lda zp */
+            zp();
+            lda();
+            clockticks6502 += 3;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xA6: /* ldx zp */
+            zp();
+            ldx();
+            clockticks6502 += 3;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xA7: /* lda indl0 */
+            indl0();
+            lda();
+            clockticks6502 += 6;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xA8: /* tay imp */
+            imp();
+            tay();
+            clockticks6502 += 2;
+            break;
+        case 0xA9: /* lda immm */
+            immm();
+            lda();
+            clockticks6502 += 2;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xAA: /* tax imp */
+            imp();
+            tax();
+            clockticks6502 += 2;
+            break;
+        case 0xAB: /* plb imp */
+            imp();
+            plb();
+            clockticks6502 += 4;
+            break;
+        case 0xAC: /* ldy abso */
+            abso();
+            ldy();
+            clockticks6502 += 4;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xAD: /* lda abso */
+            abso();
+            lda();
+            clockticks6502 += 4;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xAE: /* ldx abso */
+            abso();
+            ldx();
+            clockticks6502 += 4;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xAF: /* lda absl */
+            absl();
+            lda();
+            clockticks6502 += 5;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xB0: /* bcs rel */
+            penaltye = 0;
+            rel();
+            bcs();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0xB1: /* lda indy */
+            penaltyaddr = 0;
+            indy();
+            lda();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xB2: /* lda ind0 */
+            ind0();
+            lda();
+            clockticks6502 += 5;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xB3: /* lda sridy */
+            penaltyaddr = 0;
+            sridy();
+            lda();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xB4: /* ldy zpx */
+            zpx();
+            ldy();
+            clockticks6502 += 4;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xB5: /* lda zpx */
+            zpx();
+            lda();
+            clockticks6502 += 4;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xB6: /* ldx zpy */
+            zpy();
+            ldx();
+            clockticks6502 += 4;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xB7: /* lda indly */
+            indly();
+            lda();
+            clockticks6502 += 6;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xB8: /* clv imp */
+            imp();
+            clv();
+            clockticks6502 += 2;
+            break;
+        case 0xB9: /* lda absy */
+            penaltyaddr = 0;
+            absy();
+            lda();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xBA: /* tsx imp */
+            imp();
+            tsx();
+            clockticks6502 += 2;
+            break;
+        case 0xBB: /* tyx imp */
+            imp();
+            tyx();
+            clockticks6502 += 2;
+            break;
+        case 0xBC: /* ldy absx */
+            penaltyaddr = 0;
+            absx();
+            ldy();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xBD: /* lda absx */
+            penaltyaddr = 0;
+            absx();
+            lda();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xBE: /* ldx absy */
+            penaltyaddr = 0;
+            absy();
+            ldx();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            if (index_16bit()) clockticks6502++;
+            break;
+        case 0xBF: /* lda abslx */
+            penaltyaddr = 0;
+            abslx();
+            lda();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xC0: /* cpy immx */
+            immx();
+            cpy();
+            clockticks6502 += 2;
+            break;
+        case 0xC1: /* cmp indx */
+            indx();
+            cmp();
+            clockticks6502 += 6;
+            break;
+        case 0xC2: /* rep imm8 */
+            imm8();
+            rep();
+            clockticks6502 += 3;
+            break;
+        case 0xC3: /* cmp sr */
+            sr();
+            cmp();
+            clockticks6502 += 4;
+            break;
+        case 0xC4: /* cpy zp */
+            zp();
+            cpy();
+            clockticks6502 += 3;
+            break;
+        case 0xC5: /* cmp zp */
+            zp();
+            cmp();
+            clockticks6502 += 3;
+            break;
+        case 0xC6: /* dec zp */
+            zp();
+            dec();
+            clockticks6502 += 5;
+            break;
+        case 0xC7: /* cmp indl0 */
+            indl0();
+            cmp();
+            clockticks6502 += 6;
+            break;
+        case 0xC8: /* iny imp */
+            imp();
+            iny();
+            clockticks6502 += 2;
+            break;
+        case 0xC9: /* cmp immm */
+            immm();
+            cmp();
+            clockticks6502 += 2;
+            break;
+        case 0xCA: /* dex imp */
+            imp();
+            dex();
+            clockticks6502 += 2;
+            break;
+        case 0xCB: /* wai imp */
+            imp();
+            wai();
+            clockticks6502 += 3;
+            break;
+        case 0xCC: /* cpy abso */
+            abso();
+            cpy();
+            clockticks6502 += 4;
+            break;
+        case 0xCD: /* cmp abso */
+            abso();
+            cmp();
+            clockticks6502 += 4;
+            break;
+        case 0xCE: /* dec abso */
+            abso();
+            dec();
+            clockticks6502 += 6;
+            break;
+        case 0xCF: /* cmp absl */
+            absl();
+            cmp();
+            clockticks6502 += 5;
+            break;
+        case 0xD0: /* bne rel */
+            penaltye = 0;
+            rel();
+            bne();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0xD1: /* cmp indy */
+            penaltyaddr = 0;
+            indy();
+            cmp();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xD2: /* cmp ind0 */
+            ind0();
+            cmp();
+            clockticks6502 += 5;
+            break;
+        case 0xD3: /* cmp sridy */
+            penaltyaddr = 0;
+            sridy();
+            cmp();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xD4: /* pei ind0p */
+            ind0p();
+            pei();
+            clockticks6502 += 6;
+            break;
+        case 0xD5: /* cmp zpx */
+            zpx();
+            cmp();
+            clockticks6502 += 4;
+            break;
+        case 0xD6: /* dec zpx */
+            zpx();
+            dec();
+            clockticks6502 += 6;
+            break;
+        case 0xD7: /* cmp indly */
+            indly();
+            cmp();
+            clockticks6502 += 6;
+            break;
+        case 0xD8: /* cld imp */
+            imp();
+            cld();
+            clockticks6502 += 2;
+            break;
+        case 0xD9: /* cmp absy */
+            penaltyaddr = 0;
+            absy();
+            cmp();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xDA: /* phx imp */
+            imp();
+            phx();
+            clockticks6502 += 3;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xDB: /* dbg imp */
+            imp();
+            dbg();
+            clockticks6502 += 1;
+            break;
+        case 0xDC: /* jml aindl */
+            aindl();
+            jml();
+            clockticks6502 += 6;
+            break;
+        case 0xDD: /* cmp absx */
+            penaltyaddr = 0;
+            absx();
+            cmp();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xDE: /* dec absx */
+            absx();
+            dec();
+            clockticks6502 += 7;
+            break;
+        case 0xDF: /* cmp abslx */
+            penaltyaddr = 0;
+            abslx();
+            cmp();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xE0: /* cpx immx */
+            immx();
+            cpx();
+            clockticks6502 += 2;
+            break;
+        case 0xE1: /* sbc indx */
+            indx();
+            sbc();
+            clockticks6502 += 6;
+            break;
+        case 0xE2: /* sep imm8 */
+            imm8();
+            sep();
+            clockticks6502 += 3;
+            break;
+        case 0xE3: /* sbc sr */
+            sr();
+            sbc();
+            clockticks6502 += 4;
+            break;
+        case 0xE4: /* cpx zp */
+            zp();
+            cpx();
+            clockticks6502 += 3;
+            break;
+        case 0xE5: /* sbc zp */
+            zp();
+            sbc();
+            clockticks6502 += 3;
+            break;
+        case 0xE6: /* inc zp */
+            zp();
+            inc();
+            clockticks6502 += 5;
+            break;
+        case 0xE7: /* sbc indl0 */
+            indl0();
+            sbc();
+            clockticks6502 += 6;
+            break;
+        case 0xE8: /* inx imp */
+            imp();
+            inx();
+            clockticks6502 += 2;
+            break;
+        case 0xE9: /* sbc immm */
+            immm();
+            sbc();
+            clockticks6502 += 2;
+            break;
+        case 0xEA: /* nop imp */
+            imp();
+            nop();
+            clockticks6502 += 2;
+            break;
+        case 0xEB: /* xba imp */
+            imp();
+            xba();
+            clockticks6502 += 3;
+            break;
+        case 0xEC: /* cpx abso */
+            abso();
+            cpx();
+            clockticks6502 += 4;
+            break;
+        case 0xED: /* sbc abso */
+            abso();
+            sbc();
+            clockticks6502 += 4;
+            break;
+        case 0xEE: /* inc abso */
+            abso();
+            inc();
+            clockticks6502 += 6;
+            break;
+        case 0xEF: /* sbc absl */
+            absl();
+            sbc();
+            clockticks6502 += 5;
+            break;
+        case 0xF0: /* beq rel */
+            penaltye = 0;
+            rel();
+            beq();
+            clockticks6502 += 2;
+            if (penaltye && emulation_mode()) clockticks6502++;
+            break;
+        case 0xF1: /* sbc indy */
+            penaltyaddr = 0;
+            indy();
+            sbc();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xF2: /* sbc ind0 */
+            ind0();
+            sbc();
+            clockticks6502 += 5;
+            break;
+        case 0xF3: /* sbc sridy */
+            penaltyaddr = 0;
+            sridy();
+            sbc();
+            clockticks6502 += 7;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xF4: /* pea imm16 */
+            imm16();
+            pea();
+            clockticks6502 += 5;
+            break;
+        case 0xF5: /* sbc zpx */
+            zpx();
+            sbc();
+            clockticks6502 += 4;
+            break;
+        case 0xF6: /* inc zpx */
+            zpx();
+            inc();
+            clockticks6502 += 6;
+            break;
+        case 0xF7: /* sbc indly */
+            indly();
+            sbc();
+            clockticks6502 += 6;
+            break;
+        case 0xF8: /* sed imp */
+            imp();
+            sed();
+            clockticks6502 += 2;
+            break;
+        case 0xF9: /* sbc absy */
+            penaltyaddr = 0;
+            absy();
+            sbc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xFA: /* plx imp */
+            imp();
+            plx();
+            clockticks6502 += 4;
+            if (memory_16bit()) clockticks6502++;
+            break;
+        case 0xFB: /* xce imp */
+            imp();
+            xce();
+            clockticks6502 += 2;
+            break;
+        case 0xFC: /* jsr ainx */
+            ainx();
+            jsr();
+            clockticks6502 += 8;
+            break;
+        case 0xFD: /* sbc absx */
+            penaltyaddr = 0;
+            absx();
+            sbc();
+            clockticks6502 += 4;
+            if (penaltyaddr) clockticks6502++;
+            break;
+        case 0xFE: /* inc absx */
+            absx();
+            inc();
+            clockticks6502 += 7;
+            break;
+        case 0xFF: /* sbc abslx */
+            penaltyaddr = 0;
+            abslx();
+            sbc();
+            clockticks6502 += 5;
+            if (penaltyaddr) clockticks6502++;
+            break;
+    }
+}
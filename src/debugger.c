@@ -80,13 +80,12 @@ static void DEBUGExecCmd();
 #define DBGKEY_HOME     SDLK_F1                         // F1 is "Goto PC"
 #define DBGKEY_RESET    SDLK_F2                         // F2 resets the 6502
 #define DBGKEY_RUN      SDLK_F5                         // F5 is run.
-#define DBGKEY_SETBRK   SDLK_F9                         // F9 sets breakpoint
+#define DBGKEY_SETBRK   SDLK_F9                         // F9 toggles breakpoint
 #define DBGKEY_STEP     SDLK_F11                        // F11 is step into.
 #define DBGKEY_STEPOVER SDLK_F10                        // F10 is step over.
 #define DBGKEY_BANK_NEXT	SDLK_KP_PLUS
 #define DBGKEY_BANK_PREV	SDLK_KP_MINUS
 
-#define DBGSCANKEY_BRK  SDL_SCANCODE_F12                // F12 is break into running code.
 #define DBGSCANKEY_SHOW SDL_SCANCODE_TAB                // Show screen key.
                                                         // *** MUST BE SCAN CODES ***
 
@@ -95,7 +94,8 @@ static void DEBUGExecCmd();
 #define DDUMP_RAM	0
 #define DDUMP_VERA	1
 
-enum DBG_CMD { CMD_DUMP_MEM='m', CMD_DUMP_VERA='v', CMD_DISASM='d', CMD_SET_BANK='b', CMD_SET_REGISTER='r', CMD_FILL_MEMORY='f' };
+enum DBG_CMD { CMD_DUMP_MEM='m', CMD_DUMP_VERA='v', CMD_DISASM='d', CMD_SET_BANK='b', CMD_SET_REGISTER='r', CMD_FILL_MEMORY='f',
+               CMD_SET_BREAK='s', CMD_CLEAR_BREAK='c', CMD_WATCH='w', CMD_UNWATCH='u', CMD_LIST='l' };
 
 // RGB colours
 const SDL_Color col_bkgnd= {0, 0, 0, 255};
@@ -123,9 +123,70 @@ uint32_t debugCPUClocks = 0;
 
 int dumpmode          = DDUMP_RAM;
 
-struct breakpoint breakPoint = { -1, 0, -1 };            // User Break
+struct breakpoint breakPoint = { -1, 0, -1 };            // Last user break set, for the display
 struct breakpoint stepBreakPoint = { -1, 0, -1 };        // Single step break.
 
+int debugArmed = 0;                                      // DBGARM_ flags, see DEBUGCheckPC()
+uint32_t debugPageMap[0x10000 / 32];                     // One bit per bank/page with something to check
+int debugWatchVRAM = 0;                                  // Access types with a VRAM watchpoint
+
+// *******************************************************************************************
+//
+//		User breakpoints live in an open addressed hash table keyed on bank, x16 bank
+//		and pc, each with an optional condition. Watchpoints are a plain list, which
+//		is only searched when an access hits a watched page. Both can be changed by
+//		the MCP server thread, so changes and lookups take bpLock.
+//
+// *******************************************************************************************
+
+enum COND_SOURCE { COND_NONE, COND_A, COND_B, COND_C, COND_X, COND_Y, COND_SP, COND_D, COND_K, COND_DBR, COND_P, COND_MEMORY };
+enum COND_OP { OP_EQ, OP_NE, OP_LT, OP_GT, OP_LE, OP_GE, OP_AND };
+
+static const char *watchSpaces[] = { "ram", "bram", "vram", NULL };
+static const char *condSources[] = { "", "a", "b", "c", "x", "y", "sp", "d", "k", "dbr", "p", NULL };
+static const struct { const char *text; int op; } condOps[] = {      // Longer ones first
+	{ "==", OP_EQ }, { "!=", OP_NE }, { "<=", OP_LE }, { ">=", OP_GE },
+	{ "<", OP_LT }, { ">", OP_GT }, { "&", OP_AND }, { "=", OP_EQ }, { NULL, 0 }
+};
+
+struct condition {
+	int source;                                          // What to test, COND_NONE always hits
+	int addr;                                            // Address for COND_MEMORY
+	uint8_t bank;
+	int x16Bank;
+	int op;
+	int value;
+};
+
+struct breakEntry {
+	bool used;
+	uint32_t key;
+	struct breakpoint bp;
+	struct condition cond;
+	char condText[32];                                   // As typed, for listing
+};
+
+struct watchpoint {
+	int space;                                           // WATCH_RAM, WATCH_BRAM or WATCH_VRAM
+	int access;                                          // WATCH_READ, WATCH_WRITE and/or WATCH_EXEC
+	uint32_t start,end;                                  // Inclusive range
+};
+
+static struct breakEntry *bpTable = NULL;                // Hash table, size is a power of two
+static int bpTableSize = 0;
+static int bpCount = 0;
+
+static struct watchpoint *watchPoints = NULL;
+static int watchCount = 0;
+static int watchAlloc = 0;
+static int watchExec = 0;                                // Number of execute watchpoints
+static uint8_t watchPages[256];                          // Read/write watched pages, for memory.c
+static bool watchPagesDirty = false;                     // watchPages not yet passed to memory.c
+static bool watchHit = false;                            // Stop at the next instruction
+static char watchHitText[96];
+
+static SDL_SpinLock bpLock = 0;
+
 char cmdLine[64]= "";                                    // command line buffer
 int currentPosInLine= 0;                                 // cursor position in the buffer (NOT USED _YET_)
 int currentLineLen= 0;                                   // command line buffer length
@@ -161,6 +222,320 @@ static inline bool hitBreakpoint(int pc, uint8_t bank, struct breakpoint bp) {
 	return false;
 }
 
+// *******************************************************************************************
+//
+//			Keys and hashing for the breakpoint table. Only addresses in the banked
+//			areas of bank 0 have an x16 bank. A breakpoint there with an x16 bank
+//			of -1 hits in any bank.
+//
+// *******************************************************************************************
+
+static inline uint32_t breakKey(int pc, uint8_t bank, int x16Bank) {
+	return (x16Bank < 0) ? ((uint32_t)bank << 16) | pc : 0x1000000 | ((uint32_t)x16Bank << 16) | pc;
+}
+
+static inline int breakHash(uint32_t key) {
+	return (key * 2654435761u) & (bpTableSize - 1);
+}
+
+static struct breakEntry *DEBUGFindBreakEntry(uint32_t key) {
+	if (bpTableSize == 0) return NULL;
+	for (int i = breakHash(key);bpTable[i].used;i = (i + 1) & (bpTableSize - 1)) {
+		if (bpTable[i].key == key) return &bpTable[i];
+	}
+	return NULL;
+}
+
+static void DEBUGInsertBreakEntry(struct breakEntry *entry) {
+	int i = breakHash(entry->key);
+	while (bpTable[i].used) i = (i + 1) & (bpTableSize - 1);
+	bpTable[i] = *entry;
+}
+
+static void DEBUGRehash(int size) {                                           // Also closes gaps after removal
+	struct breakEntry *oldTable = bpTable;
+	int oldSize = bpTableSize;
+	bpTable = calloc(size, sizeof(struct breakEntry));
+	bpTableSize = size;
+	for (int i = 0;i < oldSize;i++) {
+		if (oldTable[i].used) DEBUGInsertBreakEntry(&oldTable[i]);
+	}
+	free(oldTable);
+}
+
+// *******************************************************************************************
+//
+//			Recalculate debugArmed, and with it how hard the CPU loop has to look
+//			at each instruction. Called with bpLock held.
+//
+// *******************************************************************************************
+
+static void DEBUGRearm(void) {
+	int armed = 0;
+	if (debugger_enabled && (currentMode != DMODE_RUN || watchHit || watchPagesDirty)) {
+		armed |= DBGARM_ALWAYS;
+	}
+	if (bpCount != 0 || watchExec != 0 || stepBreakPoint.pc >= 0) {
+		armed |= DBGARM_PAGES;
+	}
+	debugArmed = armed;
+}
+
+// *******************************************************************************************
+//
+//			Rebuild the page map and the watched pages after any change to the
+//			breakpoints or watchpoints. Called with bpLock held.
+//
+// *******************************************************************************************
+
+static inline void DEBUGMarkPage(uint8_t bank, int pc) {
+	int page = (bank << 8) | (pc >> 8);
+	debugPageMap[page >> 5] |= 1u << (page & 31);
+}
+
+static void DEBUGUpdate(void) {
+	uint8_t pages[256];
+	int vram = 0;
+
+	memset(debugPageMap, 0, sizeof(debugPageMap));
+	memset(pages, 0, sizeof(pages));
+	for (int i = 0;i < bpTableSize;i++) {
+		if (bpTable[i].used) DEBUGMarkPage(bpTable[i].bp.bank, bpTable[i].bp.pc);
+	}
+	if (stepBreakPoint.pc >= 0) DEBUGMarkPage(stepBreakPoint.bank, stepBreakPoint.pc);
+
+	watchExec = 0;
+	for (int i = 0;i < watchCount;i++) {
+		struct watchpoint *w = &watchPoints[i];
+		if (w->space == WATCH_VRAM) {
+			vram |= w->access;
+			continue;
+		}
+		if (w->access & WATCH_EXEC) watchExec++;
+		for (uint32_t p = w->start >> 8;p <= w->end >> 8;p++) {
+			int cpuPage = p & 0xFF;
+			if (w->space == WATCH_BRAM && (cpuPage < 0xA0 || cpuPage >= 0xC0)) continue;
+			if (w->access & WATCH_EXEC) {
+				DEBUGMarkPage(w->space == WATCH_BRAM ? 0 : p >> 8, cpuPage << 8);
+			}
+			pages[cpuPage] |= w->access & (WATCH_READ | WATCH_WRITE);
+		}
+	}
+
+	if (memcmp(pages, watchPages, sizeof(pages)) != 0) {                    // memory.c picks these up
+		memcpy(watchPages, pages, sizeof(pages));                       // in DEBUGApplyWatchPages()
+		watchPagesDirty = true;
+	}
+	debugWatchVRAM = vram;
+	DEBUGRearm();
+}
+
+static void DEBUGSetStepBreakPoint(int pc, uint8_t bank, int x16Bank) {
+	SDL_AtomicLock(&bpLock);
+	stepBreakPoint.pc = pc;
+	stepBreakPoint.bank = bank;
+	stepBreakPoint.x16Bank = x16Bank;
+	DEBUGUpdate();
+	SDL_AtomicUnlock(&bpLock);
+}
+
+// *******************************************************************************************
+//
+//			Conditions are "<register> <op> <value>" or "[<address>] <op> <value>",
+//			with hex numbers as everywhere else in the debugger.
+//
+// *******************************************************************************************
+
+static bool DEBUGParseCondition(const char *text, struct condition *cond) {
+	char name[4];
+	int bnumber, number, n = 0, len = 0;
+
+	cond->source = COND_NONE;
+	while (*text == ' ') text++;
+	if (*text == 0) return true;                                            // No condition, always hits.
+
+	if (*text == '[') {                                                     // Memory, like the 'm' command.
+		if (sscanf(text, "[%x:%x]%n", &bnumber, &number, &n) == 2 && n > 0) {
+			cond->bank = 0;
+			cond->x16Bank = bnumber & 0xFF;
+		} else if (sscanf(text, "[%x]%n", &number, &n) == 1 && n > 0) {
+			cond->bank = is_gen2 ? (number >> 16) & 0xFF : 0;
+			cond->x16Bank = (is_gen2 || number < 0x10000) ? USE_CURRENT_X16_BANK : (number >> 16) & 0xFF;
+		} else {
+			return false;
+		}
+		cond->source = COND_MEMORY;
+		cond->addr = number & 0xFFFF;
+		text += n;
+	} else {                                                                // Register, like the 'r' command.
+		while (text[len] >= 'a' && text[len] <= 'z' && len < (int)sizeof(name) - 1) {
+			name[len] = text[len];
+			len++;
+		}
+		name[len] = 0;
+		for (int i = 1;condSources[i] != NULL;i++) {
+			if (!strcmp(name, condSources[i])) cond->source = i;
+		}
+		if (cond->source == COND_NONE) return false;
+		text += len;
+	}
+
+	while (*text == ' ') text++;
+	for (len = 0;condOps[len].text != NULL;len++) {
+		if (!strncmp(text, condOps[len].text, strlen(condOps[len].text))) break;
+	}
+	if (condOps[len].text == NULL) return false;
+	cond->op = condOps[len].op;
+	text += strlen(condOps[len].text);
+
+	while (*text == ' ') text++;
+	if (*text == '$') text++;
+	n = 0;
+	if (sscanf(text, "%x%n", &cond->value, &n) != 1) return false;
+	text += n;
+	while (*text == ' ') text++;
+	return *text == 0;
+}
+
+static int DEBUGConditionValue(struct condition *cond) {
+	switch (cond->source) {
+		case COND_A:		return regs.a;
+		case COND_B:		return regs.b;
+		case COND_C:		return regs.c;
+		case COND_X:		return regs.e ? regs.xl : regs.x;
+		case COND_Y:		return regs.e ? regs.yl : regs.y;
+		case COND_SP:		return regs.e ? 0x100 | (regs.sp & 0xFF) : regs.sp;
+		case COND_D:		return regs.dp;
+		case COND_K:		return regs.k;
+		case COND_DBR:		return regs.db;
+		case COND_P:		return regs.status;
+		case COND_MEMORY:	return debug_read6502(cond->addr, cond->bank, cond->x16Bank);
+	}
+	return 0;
+}
+
+static bool DEBUGTestCondition(struct condition *cond) {
+	if (cond->source == COND_NONE) return true;
+	int v = DEBUGConditionValue(cond);
+	switch (cond->op) {
+		case OP_EQ:		return v == cond->value;
+		case OP_NE:		return v != cond->value;
+		case OP_LT:		return v < cond->value;
+		case OP_GT:		return v > cond->value;
+		case OP_LE:		return v <= cond->value;
+		case OP_GE:		return v >= cond->value;
+		case OP_AND:	return (v & cond->value) != 0;
+	}
+	return false;
+}
+
+// *******************************************************************************************
+//
+//			Watchpoint hits. The CPU finishes the instruction, then the debugger stops.
+//
+// *******************************************************************************************
+
+static void DEBUGFormatWatchAddr(char *buffer, size_t size, int space, uint32_t addr) {
+	if (space == WATCH_VRAM) {
+		snprintf(buffer, size, "%05X", addr);
+	} else if (space == WATCH_BRAM) {
+		snprintf(buffer, size, "%02X:%04X", addr >> 16, addr & 0xFFFF);
+	} else if (addr > 0xFFFF) {
+		snprintf(buffer, size, "%02X %04X", addr >> 16, addr & 0xFFFF);
+	} else {
+		snprintf(buffer, size, "%04X", addr);
+	}
+}
+
+static bool DEBUGMatchWatch(int space, uint32_t addr, int access, uint8_t value) {
+	char where[16];
+	for (int i = 0;i < watchCount;i++) {
+		struct watchpoint *w = &watchPoints[i];
+		if (w->space == space && (w->access & access) && addr >= w->start && addr <= w->end) {
+			if (!watchHit) {
+				DEBUGFormatWatchAddr(where, sizeof(where), space, addr);
+				if (access == WATCH_EXEC) {
+					snprintf(watchHitText, sizeof(watchHitText), "Watchpoint %d: execute %s %s",
+								i + 1, watchSpaces[space], where);
+				} else {
+					snprintf(watchHitText, sizeof(watchHitText), "Watchpoint %d: %s $%02X %s %s %s at PC %04X",
+								i + 1, access == WATCH_READ ? "read" : "write", value,
+								access == WATCH_READ ? "from" : "to", watchSpaces[space], where, opcode_addr);
+				}
+				watchHit = true;
+				DEBUGRearm();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void DEBUGWatchAccess(int space, uint32_t addr, int access, uint8_t value) {
+	SDL_AtomicLock(&bpLock);
+	DEBUGMatchWatch(space, addr, access, value);
+	SDL_AtomicUnlock(&bpLock);
+}
+
+// *******************************************************************************************
+//
+//			Check the PC against all breakpoints. Pages without any cost one load.
+//
+// *******************************************************************************************
+
+static bool DEBUGHitBreakpoint(int pc, uint8_t bank) {
+	int page = (bank << 8) | (pc >> 8);
+	if (((debugPageMap[page >> 5] >> (page & 31)) & 1) == 0) return false;
+
+	int x16Bank = getCurrentBank(pc, bank);
+	bool hit = false;
+	SDL_AtomicLock(&bpLock);
+	if (hitBreakpoint(pc, bank, stepBreakPoint)) {
+		hit = true;
+	} else {
+		struct breakEntry *entry = DEBUGFindBreakEntry(breakKey(pc, bank, x16Bank));
+		struct breakEntry *anyBank = x16Bank >= 0 ? DEBUGFindBreakEntry(breakKey(pc, bank, -1)) : NULL;
+		hit = (entry != NULL && DEBUGTestCondition(&entry->cond)) ||
+				(anyBank != NULL && DEBUGTestCondition(&anyBank->cond));
+		if (!hit && watchExec != 0) {
+			if (bank == 0 && pc >= 0xA000 && pc < 0xC000) {
+				hit = DEBUGMatchWatch(WATCH_BRAM, (memory_get_ram_bank() << 16) | pc, WATCH_EXEC, 0);
+			} else {
+				hit = DEBUGMatchWatch(WATCH_RAM, (bank << 16) | pc, WATCH_EXEC, 0);
+			}
+		}
+	}
+	SDL_AtomicUnlock(&bpLock);
+	return hit;
+}
+
+// *******************************************************************************************
+//
+//			Pass changed watched pages on to memory.c, which remaps its page tables
+//			for them. Only the emulator loop may call this, between two instructions.
+//
+// *******************************************************************************************
+
+void DEBUGApplyWatchPages(void) {
+	if (!watchPagesDirty) return;
+	SDL_AtomicLock(&bpLock);
+	memory_watch_pages(watchPages);
+	watchPagesDirty = false;
+	DEBUGRearm();
+	SDL_AtomicUnlock(&bpLock);
+}
+
+// *******************************************************************************************
+//
+//			The status DEBUGGetCurrentStatus() would return, without polling events or
+//			changing anything, for other threads: 1 if stopped, 0 if running.
+//
+// *******************************************************************************************
+
+int DEBUGGetStatus(void) {
+	return currentMode == DMODE_STOP ? 1 : 0;
+}
+
 // *******************************************************************************************
 //
 //			This is used to determine who is in control. If it returns zero then
@@ -173,6 +548,8 @@ static inline bool hitBreakpoint(int pc, uint8_t bank, struct breakpoint bp) {
 int  DEBUGGetCurrentStatus(void) {
 
 	SDL_Event event;
+	if (debugArmed == 0) return 0;                                          // Nothing armed, run free.
+
 	if (currentPC < 0) currentPC = regs.pc;                                      // Initialise current PC displayed.
 
 	if (currentMode == DMODE_STEP) {                                        // Single step before
@@ -184,21 +561,16 @@ int  DEBUGGetCurrentStatus(void) {
 		}
 	}
 
-	if ((currentMode != DMODE_STOP) && (hitBreakpoint(regs.pc, regs.k, breakPoint) || hitBreakpoint(regs.pc, regs.k, stepBreakPoint))) {       // Hit a breakpoint.
+	if ((currentMode != DMODE_STOP) && (watchHit || DEBUGHitBreakpoint(regs.pc, regs.k))) {   // Hit a breakpoint.
+		if (watchHit) {
+			printf("%s\n", watchHitText);
+			watchHit = false;
+		}
 		currentPC = regs.pc;                                                         // Update current PC
 		currentPCBank = regs.k;
 		currentPCX16Bank = getCurrentBank(regs.pc, regs.k);                     // Update the bank if we are in upper memory.
 		currentMode = DMODE_STOP;                                               // So now stop, as we've done it.
-		stepBreakPoint.pc = -1;                                                 // Clear step breakpoint.
-		stepBreakPoint.bank = 0;
-		stepBreakPoint.x16Bank = -1;
-	}
-
-	if (SDL_GetKeyboardState(NULL)[DBGSCANKEY_BRK]) {                       // Stop on break pressed.
-		currentMode = DMODE_STOP;
-		currentPC = regs.pc;                                                 // Set the PC to what it is.                                                      // Update current PC
-		currentPCBank = regs.k;
-		currentPCX16Bank = getCurrentBank(regs.pc, regs.k);                 // Update the bank if we are in upper memory.
+		if (stepBreakPoint.pc >= 0) DEBUGSetStepBreakPoint(-1, 0, -1);          // Clear step breakpoint.
 	}
 
 	if (currentPCX16Bank<0 && currentPC >= 0xA000 && currentPCBank == 0) {
@@ -224,6 +596,10 @@ int  DEBUGGetCurrentStatus(void) {
 		}
 	}
 
+	SDL_AtomicLock(&bpLock);
+	DEBUGRearm();                                                           // The mode may have changed.
+	SDL_AtomicUnlock(&bpLock);
+
 	showDebugOnRender = (currentMode != DMODE_RUN);                         // Do we draw it - only in RUN mode.
 	if (currentMode == DMODE_STOP) {                                        // We're in charge.
 		video_update();
@@ -254,12 +630,149 @@ void DEBUGFreeUI() {
 
 // *******************************************************************************************
 //
-//								Set a new breakpoint address. -1 to disable.
+//				Set a new breakpoint address, in addition to the others. -1 clears all.
 //
 // *******************************************************************************************
 
 void DEBUGSetBreakPoint(struct breakpoint newBreakPoint) {
+	if (newBreakPoint.pc < 0) {
+		DEBUGClearBreakPoints();
+	} else {
+		DEBUGAddBreakPoint(newBreakPoint, NULL);
+	}
+}
+
+// *******************************************************************************************
+//
+//				Add a breakpoint with an optional condition, or change the condition
+//				of an existing one. Returns false if the condition can't be parsed.
+//
+// *******************************************************************************************
+
+bool DEBUGAddBreakPoint(struct breakpoint newBreakPoint, const char *condition) {
+	struct breakEntry entry;
+
+	if (newBreakPoint.pc < 0 || newBreakPoint.pc > 0xFFFF) return false;
+	if (newBreakPoint.pc < 0xA000 || newBreakPoint.bank != 0) newBreakPoint.x16Bank = -1;
+	memset(&entry, 0, sizeof(entry));
+	if (!DEBUGParseCondition(condition != NULL ? condition : "", &entry.cond)) return false;
+	entry.used = true;
+	entry.key = breakKey(newBreakPoint.pc, newBreakPoint.bank, newBreakPoint.x16Bank);
+	entry.bp = newBreakPoint;
+	snprintf(entry.condText, sizeof(entry.condText), "%s", condition != NULL ? condition : "");
+
+	SDL_AtomicLock(&bpLock);
+	struct breakEntry *old = DEBUGFindBreakEntry(entry.key);
+	if (old != NULL) {
+		*old = entry;
+	} else {
+		if ((bpCount + 1) * 2 > bpTableSize) DEBUGRehash(bpTableSize != 0 ? bpTableSize * 2 : 64);
+		DEBUGInsertBreakEntry(&entry);
+		bpCount++;
+	}
 	breakPoint = newBreakPoint;
+	DEBUGUpdate();
+	SDL_AtomicUnlock(&bpLock);
+	return true;
+}
+
+bool DEBUGRemoveBreakPoint(struct breakpoint oldBreakPoint) {
+	if (oldBreakPoint.pc < 0xA000 || oldBreakPoint.bank != 0) oldBreakPoint.x16Bank = -1;
+	uint32_t key = breakKey(oldBreakPoint.pc, oldBreakPoint.bank, oldBreakPoint.x16Bank);
+
+	SDL_AtomicLock(&bpLock);
+	struct breakEntry *entry = DEBUGFindBreakEntry(key);
+	if (entry != NULL) {
+		entry->used = false;
+		bpCount--;
+		DEBUGRehash(bpTableSize);
+		if (breakPoint.pc >= 0 && breakKey(breakPoint.pc, breakPoint.bank, breakPoint.x16Bank) == key) {
+			breakPoint.pc = -1;                                     // Show another one, if any.
+			for (int i = 0;i < bpTableSize;i++) {
+				if (bpTable[i].used) breakPoint = bpTable[i].bp;
+			}
+		}
+		DEBUGUpdate();
+	}
+	SDL_AtomicUnlock(&bpLock);
+	return entry != NULL;
+}
+
+void DEBUGClearBreakPoints(void) {
+	SDL_AtomicLock(&bpLock);
+	free(bpTable);
+	bpTable = NULL;
+	bpTableSize = bpCount = 0;
+	breakPoint.pc = -1;
+	DEBUGUpdate();
+	SDL_AtomicUnlock(&bpLock);
+}
+
+// *******************************************************************************************
+//
+//			Add a watchpoint on an inclusive range. RAM addresses are CPU addresses
+//			with the bank in bits 16-23, BRAM addresses are x16 bank:address.
+//
+// *******************************************************************************************
+
+bool DEBUGAddWatchPoint(int space, int access, uint32_t start, uint32_t end) {
+	if (start > end) {
+		uint32_t t = start;start = end;end = t;
+	}
+	if (access == 0 || (access & ~(WATCH_READ | WATCH_WRITE | WATCH_EXEC)) != 0) return false;
+	switch (space) {
+		case WATCH_RAM:
+			if (end > 0xFFFFFF) return false;
+			break;
+		case WATCH_BRAM:
+			if (end > 0xFFFFFF || (start & 0xFFFF) < 0xA000 || (end & 0xFFFF) >= 0xC000) return false;
+			break;
+		case WATCH_VRAM:
+			if (end > 0x1FFFF || (access & WATCH_EXEC) != 0) return false;
+			break;
+		default:
+			return false;
+	}
+
+	SDL_AtomicLock(&bpLock);
+	if (watchCount == watchAlloc) {
+		int newAlloc = watchAlloc != 0 ? watchAlloc * 2 : 16;
+		struct watchpoint *newPoints = realloc(watchPoints, newAlloc * sizeof(struct watchpoint));
+		if (newPoints == NULL) {                                        // Keep the ones we have.
+			SDL_AtomicUnlock(&bpLock);
+			return false;
+		}
+		watchPoints = newPoints;
+		watchAlloc = newAlloc;
+	}
+	watchPoints[watchCount].space = space;
+	watchPoints[watchCount].access = access;
+	watchPoints[watchCount].start = start;
+	watchPoints[watchCount].end = end;
+	watchCount++;
+	DEBUGUpdate();
+	SDL_AtomicUnlock(&bpLock);
+	return true;
+}
+
+static bool DEBUGRemoveWatchPoint(int index) {
+	bool found = false;
+	SDL_AtomicLock(&bpLock);
+	if (index >= 0 && index < watchCount) {
+		memmove(&watchPoints[index], &watchPoints[index + 1], (watchCount - index - 1) * sizeof(struct watchpoint));
+		watchCount--;
+		found = true;
+		DEBUGUpdate();
+	}
+	SDL_AtomicUnlock(&bpLock);
+	return found;
+}
+
+void DEBUGClearWatchPoints(void) {
+	SDL_AtomicLock(&bpLock);
+	watchCount = 0;
+	DEBUGUpdate();
+	SDL_AtomicUnlock(&bpLock);
 }
 
 // *******************************************************************************************
@@ -273,6 +786,9 @@ void DEBUGBreakToDebugger(void) {
 	currentPC = regs.pc;
 	currentPCBank = regs.k;
 	currentPCX16Bank = getCurrentBank(regs.pc, regs.k);
+	SDL_AtomicLock(&bpLock);
+	DEBUGRearm();
+	SDL_AtomicUnlock(&bpLock);
 }
 
 // *******************************************************************************************
@@ -283,6 +799,7 @@ void DEBUGBreakToDebugger(void) {
 
 static void DEBUGHandleKeyEvent(SDL_Keycode key, int isShift) {
 	int opcode;
+	struct breakpoint bp;
 
 	switch(key) {
 
@@ -294,9 +811,8 @@ static void DEBUGHandleKeyEvent(SDL_Keycode key, int isShift) {
 		case DBGKEY_STEPOVER:								// Step over (F10 by default)
 			opcode = debug_read6502(regs.pc, regs.k, currentPCX16Bank); 	// What opcode is it ?
 			if (opcode == 0x20 || opcode == 0xFC || opcode == 0x22) { 		// Is it JSR or JSL ?
-				stepBreakPoint.pc = regs.pc + 3 + (opcode == 0x22);			// Then break 3 / 4 on.
-				stepBreakPoint.bank = regs.k;
-				stepBreakPoint.x16Bank = getCurrentBank(regs.pc, regs.k);
+				DEBUGSetStepBreakPoint((regs.pc + 3 + (opcode == 0x22)) & 0xFFFF,	// Then break 3 / 4 on.
+							regs.k, getCurrentBank(regs.pc, regs.k));
 				currentMode = DMODE_RUN;					// And run.
 				debugCPUClocks = clockticks6502;
 				timing_init();
@@ -312,10 +828,13 @@ static void DEBUGHandleKeyEvent(SDL_Keycode key, int isShift) {
 			timing_init();
 			break;
 
-		case DBGKEY_SETBRK:								// F9 Set breakpoint to displayed.
-			breakPoint.pc = currentPC;
-			breakPoint.bank = currentPCBank;
-			breakPoint.x16Bank = currentPCX16Bank;
+		case DBGKEY_SETBRK:								// F9 Toggle breakpoint at displayed.
+			bp.pc = currentPC;
+			bp.bank = currentPCBank;
+			bp.x16Bank = currentPCX16Bank;
+			if (!DEBUGRemoveBreakPoint(bp)) {
+				DEBUGAddBreakPoint(bp, NULL);
+			}
 			break;
 
 		case DBGKEY_HOME:								// F1 sets the display PC to the actual one.
@@ -439,10 +958,69 @@ static bool DEBUGEditCmdLine(SDL_Keycode key) {
 	return (key == SDLK_RETURN) || (key == SDLK_KP_ENTER);
 }
 
+// *******************************************************************************************
+//
+//			Parse a breakpoint address, "bank:address" or with the bank in bits
+//			16-23 like the 'd' command. Returns what follows it, NULL if none.
+//
+// *******************************************************************************************
+
+static char *DEBUGParseBreakAddress(char *line, struct breakpoint *bp) {
+	int bnumber, number, n = 0;
+	if (sscanf(line, "%x:%x%n", &bnumber, &number, &n) == 2) {
+		bp->bank = 0;
+		bp->x16Bank = bnumber & 0xFF;
+	} else if (sscanf(line, "%x%n", &number, &n) == 1) {
+		bp->bank = is_gen2 ? (number >> 16) & 0xFF : 0;
+		bp->x16Bank = is_gen2 ? -1 : (number >> 16) & 0xFF;
+	} else {
+		return NULL;
+	}
+	bp->pc = number & 0xFFFF;
+	return line + n;
+}
+
+// *******************************************************************************************
+//
+//					List breakpoints and watchpoints on the console.
+//
+// *******************************************************************************************
+
+static void DEBUGListPoints(void) {
+	char from[16], to[16];
+	SDL_AtomicLock(&bpLock);
+	printf("Breakpoints:\n");
+	for (int i = 0;i < bpTableSize;i++) {
+		struct breakpoint *bp = &bpTable[i].bp;
+		if (!bpTable[i].used) continue;
+		if (bp->x16Bank >= 0) {
+			printf("  %02X:%04X", bp->x16Bank, bp->pc);
+		} else if (bp->pc >= 0xA000 && bp->bank == 0) {
+			printf("  --:%04X", bp->pc);
+		} else if (is_gen2) {
+			printf("  %02X %04X", bp->bank, bp->pc);
+		} else {
+			printf("  %04X", bp->pc);
+		}
+		printf(bpTable[i].condText[0] ? " if %s\n" : "\n", bpTable[i].condText);
+	}
+	printf("Watchpoints:\n");
+	for (int i = 0;i < watchCount;i++) {
+		struct watchpoint *w = &watchPoints[i];
+		DEBUGFormatWatchAddr(from, sizeof(from), w->space, w->start);
+		DEBUGFormatWatchAddr(to, sizeof(to), w->space, w->end);
+		printf("  %d: %c%c%c %-4s %s-%s\n", i + 1,
+					w->access & WATCH_READ ? 'r' : '-', w->access & WATCH_WRITE ? 'w' : '-',
+					w->access & WATCH_EXEC ? 'x' : '-', watchSpaces[w->space], from, to);
+	}
+	SDL_AtomicUnlock(&bpLock);
+}
+
 static void DEBUGExecCmd() {
-	int number, bnumber, addr, size, incr;
-	char reg[10];
+	int number, bnumber, addr, size, incr, access, space;
+	char reg[10], spaceName[10];
 	char cmd;
+	struct breakpoint bp;
 	char *line= ltrim(cmdLine);
 
 	cmd= *line;
@@ -484,8 +1062,10 @@ static void DEBUGExecCmd() {
 							// Nop.
 						} else if (addr >= 0xA000 && addr < 0xC000) {
 							BRAM[(currentX16Bank << 13) + addr - 0xA000] = number;
+							memory_dirty(&BRAM[(currentX16Bank << 13) + addr - 0xA000]);
 						} else if ((addr >> 16) < num_banks) {
 							RAM[addr] = number;
+							memory_dirty(&RAM[addr]);
 						}
 						if (incr) {
 							addr += incr;
@@ -585,6 +1165,46 @@ static void DEBUGExecCmd() {
 			}
 			break;
 
+		case CMD_SET_BREAK:
+			line = DEBUGParseBreakAddress(line, &bp);
+			if (line != NULL && !DEBUGAddBreakPoint(bp, line = ltrim(line))) {
+				printf("Bad breakpoint condition: %s\n", line);
+			}
+			break;
+
+		case CMD_CLEAR_BREAK:
+			if (DEBUGParseBreakAddress(line, &bp) != NULL) {
+				DEBUGRemoveBreakPoint(bp);
+			} else {
+				DEBUGClearBreakPoints();
+			}
+			break;
+
+		case CMD_WATCH:
+			number = sscanf(line, "%9s %9s %x %x", reg, spaceName, &addr, &bnumber);
+			if (number >= 3) {
+				access = (strchr(reg, 'r') ? WATCH_READ : 0) | (strchr(reg, 'w') ? WATCH_WRITE : 0) |
+							(strchr(reg, 'x') ? WATCH_EXEC : 0);
+				for (space = 0;watchSpaces[space] != NULL && strcmp(watchSpaces[space], spaceName);space++) {}
+				if (number == 3) bnumber = addr;
+				if (watchSpaces[space] == NULL || !DEBUGAddWatchPoint(space, access, addr, bnumber)) {
+					printf("Bad watchpoint: %s\n", ltrim(line));
+				}
+			}
+			break;
+
+		case CMD_UNWATCH:
+			if (sscanf(line, "%d", &number) == 1) {
+				DEBUGRemoveWatchPoint(number - 1);
+			} else {
+				DEBUGClearWatchPoints();
+			}
+			break;
+
+		case CMD_LIST:
+			DEBUGListPoints();
+			break;
+
 		default:
 			break;
 	}
@@ -881,6 +1501,11 @@ static int DEBUGRenderRegisters(void) {
 	} else {
 		DEBUGNumber(DBG_DATX, yc++, (breakPoint.x16Bank << 16) | breakPoint.pc, 6, col_data);
 	}
+	if (bpCount > 1) {												// And how many others.
+		char more[12];
+		snprintf(more, sizeof(more), "+%d", bpCount - 1);
+		DEBUGString(dbgRenderer, DBG_DATX + 7, yc - 1, more, col_data);
+	}
 	yc++;
 
 	return n; 													// Number of code display lines
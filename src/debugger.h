@@ -12,9 +12,14 @@
 #ifndef _DEBUGGER_H
 #define _DEBUGGER_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <SDL.h>
 
 extern int showDebugOnRender;
+extern int debugArmed;
+extern uint32_t debugPageMap[];
+extern int debugWatchVRAM;
 
 struct breakpoint {
 	int pc;
@@ -22,13 +27,49 @@ struct breakpoint {
 	int x16Bank;
 };
 
+#define DBGARM_PAGES	(1)										// Check PCs against debugPageMap
+#define DBGARM_ALWAYS	(2)										// Stop the CPU after every instruction
+
+#define DBGSCANKEY_BRK	SDL_SCANCODE_F12						// F12 is break into running code, see video.c
+
+#define WATCH_READ		(1)										// Watchpoint access types
+#define WATCH_WRITE		(2)
+#define WATCH_EXEC		(4)
+
+#define WATCH_RAM		(0)										// Watchpoint address spaces
+#define WATCH_BRAM		(1)
+#define WATCH_VRAM		(2)
+
 void DEBUGRenderDisplay(int width,int height);
 void DEBUGBreakToDebugger(void);
 int  DEBUGGetCurrentStatus(void);
+int  DEBUGGetStatus(void);
+void DEBUGApplyWatchPages(void);
 void DEBUGSetBreakPoint(struct breakpoint newBreakPoint);
+bool DEBUGAddBreakPoint(struct breakpoint newBreakPoint,const char *condition);
+bool DEBUGRemoveBreakPoint(struct breakpoint oldBreakPoint);
+void DEBUGClearBreakPoints(void);
+bool DEBUGAddWatchPoint(int space,int access,uint32_t start,uint32_t end);
+void DEBUGClearWatchPoints(void);
+void DEBUGWatchAccess(int space,uint32_t addr,int access,uint8_t value);
 void DEBUGInitUI(SDL_Renderer *pRenderer);
 void DEBUGFreeUI();
 
+// *******************************************************************************************
+//
+//		Called by the CPU loop after every instruction. Non-zero means the
+//		debugger wants to look at this PC, so the current batch has to end.
+//		With nothing armed this is a single test of debugArmed.
+//
+// *******************************************************************************************
+
+static inline int DEBUGCheckPC(uint8_t bank,uint16_t pc) {
+	if (debugArmed == 0) return 0;
+	if (debugArmed & DBGARM_ALWAYS) return 1;
+	int page = (bank << 8) | (pc >> 8);
+	return (debugPageMap[page >> 5] >> (page & 31)) & 1;
+}
+
 #define DBG_WIDTH 		(60)									// Char cells across
 #define DBG_HEIGHT 		(60)
 
@@ -80,8 +80,14 @@ extern bool warp_mode;
 extern bool grab_mouse;
 extern bool testbench;
 extern bool has_via2;
+extern bool has_serial;
+extern bool headless;
+extern bool ym2151_irq_support;
 extern uint32_t host_sample_rate;
 extern bool enable_midline;
+extern int render_threads;
+extern bool line_cache;
+extern bool present_thread;
 
 extern bool has_midi_card;
 extern uint16_t midi_card_addr;
@@ -91,6 +97,9 @@ extern void machine_reset();
 extern void machine_nmi();
 extern void machine_paste(char *text, bool handle_free);
 extern void machine_toggle_warp();
+extern bool machine_save_state(const char *path);
+extern bool machine_load_state(const char *path);
+extern bool machine_rewind(uint32_t frames);
 extern void init_audio();
 extern void main_shutdown();
 
@@ -105,6 +114,7 @@ extern bool nvram_dirty;
 extern uint8_t nvram[0x40];
 
 extern uint8_t MHZ;
+extern int instruction_counter;
 
 extern bool mouse_grabbed;
 extern bool no_keyboard_capture;
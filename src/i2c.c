@@ -7,6 +7,7 @@
 #include "i2c.h"
 #include "smc.h"
 #include "rtc.h"
+#include "state.h"
 
 #define LOG_LEVEL 0
 
@@ -94,10 +95,15 @@ i2c_write(uint8_t device) {
 #endif
 }
 
+// Called by VIA#1 whenever the levels on the CLK and DATA lines may have
+// changed. The bus state machine only advances on edges, so there is no
+// need to poll it.
 void
-i2c_step()
+i2c_set_lines(int clk_in, int data_in)
 {
-	static i2c_port_t old_i2c_port;
+	i2c_port_t old_i2c_port = i2c_port;
+	i2c_port.clk_in = clk_in;
+	i2c_port.data_in = data_in;
 
 	if (old_i2c_port.clk_in != i2c_port.clk_in || old_i2c_port.data_in != i2c_port.data_in) {
 #if LOG_LEVEL >= 5
@@ -189,7 +195,6 @@ i2c_step()
 				state = STATE_START;
 			}
 		}
-		old_i2c_port = i2c_port;
 	}
 }
 
@@ -403,3 +408,25 @@ mouse_set_device_id(uint8_t d) {
 	}
 	i2c_mse_buffer_flush();
 }
+
+void
+i2c_state()
+{
+	STATE_FIELD(i2c_port);
+	STATE_FIELD(state);
+	STATE_FIELD(read_mode);
+	STATE_FIELD(value);
+	STATE_FIELD(count);
+	STATE_FIELD(device);
+	STATE_FIELD(kbd_buffer);
+	STATE_FIELD(kbd_head);
+	STATE_FIELD(kbd_tail);
+	STATE_FIELD(mse_buffer);
+	STATE_FIELD(mse_head);
+	STATE_FIELD(mse_tail);
+	STATE_FIELD(buttons);
+	STATE_FIELD(mouse_diff_x);
+	STATE_FIELD(mouse_diff_y);
+	STATE_FIELD(wheel);
+	STATE_FIELD(mouse_device_id);
+}
@@ -19,7 +19,8 @@ typedef struct {
 extern i2c_port_t i2c_port;
 
 void i2c_reset_state();
-void i2c_step();
+void i2c_set_lines(int clk_in, int data_in);
+void i2c_state(void);
 
 void i2c_kbd_buffer_add(uint8_t value);
 uint8_t i2c_kbd_buffer_next();
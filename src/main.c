@@ -13,6 +13,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <limits.h>
+#include <sys/stat.h>
+#include <zlib.h>
 #ifdef __MINGW32__
 #include <ctype.h>
 #endif
@@ -47,6 +49,10 @@
 #include "keyboard.h"
 #include "logging.h"
 #include "asm_logging.h"
+#include "scheduler.h"
+#include "bench.h"
+#include "state.h"
+#include "rewind.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -55,6 +61,8 @@
 
 void *emulator_loop(void *param);
 void emscripten_main_loop(void);
+static void boot_cache_init(bool zeroram);
+static void basic_reads_line(void);
 
 // This must match the KERNAL's set!
 char *keymaps[] = {
@@ -110,6 +118,8 @@ bool dump_bank = true;
 bool dump_vram = false;
 bool warp_mode = false;
 bool warp_pastes = false;
+uint32_t bench_frames = 0;
+uint64_t bench_cycles = 0;
 bool grab_mouse = false;
 echo_mode_t echo_mode;
 bool save_on_exit = true;
@@ -133,6 +143,9 @@ bool headless = false;
 bool fullscreen = false;
 bool testbench = false;
 bool enable_midline = false;
+int render_threads = 0;
+bool line_cache = false;
+bool present_thread = false;
 bool ym2151_irq_support = false;
 char *cartridge_path = NULL;
 
@@ -157,9 +170,38 @@ char *prg_path = NULL;  // Global variable for logging system access
 
 char *nvram_path = NULL;
 
+char *load_state_path = NULL;
+char *save_state_path = NULL;
+bool compress_state = false;
+
+char *boot_cache_dir = NULL;
+uint32_t rewind_seconds = 0;
+static char boot_cache_path[PATH_MAX];
+static bool boot_cache_pending = false; // save at the first BASIC prompt
+
+// Save/load requests from the MCP server thread, served by the emulator
+// loop between two instructions
+enum {
+	STATE_REQUEST_NONE,
+	STATE_REQUEST_SAVE,
+	STATE_REQUEST_LOAD,
+	STATE_REQUEST_REWIND,
+	STATE_REQUEST_CLAIMED, // being set up by the requesting thread
+	STATE_REQUEST_SERVING, // being served by the emulator loop
+};
+static SDL_atomic_t state_request;
+static char state_request_path[PATH_MAX];
+static bool state_request_compress;
+static uint32_t state_request_frames;
+static bool state_request_result;
+
 bool pwr_long_press=false;
 bool is_gen2 = false;
 
+// CPU core picked by machine_reset(): the full 65C816 core, or the
+// 65C02-only core with all 65C816 paths compiled out
+static void (*step_cpu)(void) = step6502;
+
 // MCP Server configuration
 bool mcp_enabled = false;
 int mcp_port = 8080;
@@ -372,6 +414,7 @@ machine_reset()
 	video_reset();
 	mouse_state_init();
 	reset6502(regs.is65c816);
+	step_cpu = regs.is65c816 ? step6502 : step6502_c02;
 	midi_serial_init();
 }
 
@@ -479,6 +522,13 @@ usage()
 	printf("\tStart the -prg/-bas program using RUN\n");
 	printf("-warp\n");
 	printf("\tEnable warp mode, run emulator as fast as possible.\n");
+	printf("-warp-frames {<n>|<fps>fps|auto}\n");
+	printf("\tRender one frame in <n> in warp mode (default: 64), none if\n");
+	printf("\t<n> is 0, up to <fps> frames per second, or as many as the\n");
+	printf("\thost can afford without slowing down the emulation much.\n");
+	printf("-bench [{<frames>|<cycles>cycles}]\n");
+	printf("\tRun the given number of frames (default: %d) or CPU cycles\n", BENCH_DEFAULT_FRAMES);
+	printf("\tas fast as possible, print performance statistics and exit.\n");
 	printf("-pastewarp\n");
 	printf("\tEnable warp mode during pastes and during loading via -bas.\n");
 	printf("-echo [{iso|raw}]\n");
@@ -527,6 +577,20 @@ usage()
 	printf("-dump {C|R|B|V}...\n");
 	printf("\tConfigure system dump: (C)PU, (R)AM, (B)anked-RAM, (V)RAM\n");
 	printf("\tMultiple characters are possible, e.g. -dump CV ; Default: RB\n");
+	printf("-loadstate <file>\n");
+	printf("\tRestore the machine state from a file saved with -savestate.\n");
+	printf("-savestate <file>\n");
+	printf("\tSave the machine state to a file when the emulator exits.\n");
+	printf("\tCtrl+F5/Ctrl+F9 save/restore it at any time.\n");
+	printf("-statecompress\n");
+	printf("\tCompress saved machine states.\n");
+	printf("-rewind [<seconds>]\n");
+	printf("\tKeep a snapshot of every frame of the last seconds (default: %d).\n", REWIND_DEFAULT_SECONDS);
+	printf("\tCtrl+Z rewinds by one second.\n");
+	printf("-bootcache [<dir>]\n");
+	printf("\tCache the machine state at the first BASIC prompt in the given\n");
+	printf("\tdirectory (default: current directory) and restore it instead\n");
+	printf("\tof booting on later runs with the same ROM and configuration.\n");
 	printf("-joy1\n");
 	printf("\tEnable binding a gamepad to SNES controller port 1\n");
 	printf("-joy2\n");
@@ -538,11 +602,16 @@ usage()
 	printf("-sound <output device>\n");
 	printf("\tSet the output device used for audio emulation\n");
 	printf("\tIf output device is 'none', no audio is generated\n");
+	printf("\tIf output device is 'offline', audio is only generated for -wav,\n");
+	printf("\tas fast as the emulation runs. This is the default with -testbench.\n");
 	printf("-abufs <number of audio buffers>\n");
 	printf("\tSet the number of audio buffers used for playback.\n");
 	printf("\tIf using HostFS, the default is 32, otherwise 8.\n");
 	printf("\tIncreasing this will reduce stutter on slower computers,\n");
 	printf("\tbut will increase audio latency.\n");
+	printf("-resampler {linear|sinc4|sinc8}\n");
+	printf("\tSet the filter used to resample audio to the host sample rate.\n");
+	printf("\tThe default is sinc4; sinc8 sounds cleaner, linear is cheapest.\n");
 	printf("-rtc\n");
 	printf("\tSet the real-time-clock to the current system time and date.\n");
 	printf("-via2\n");
@@ -557,6 +626,16 @@ usage()
 	printf("-midline-effects\n");
 	printf("\tApproximate mid-line raster effects when changing tile, sprite,\n");
 	printf("\tand palette data. Requires a fast host CPU.\n");
+	printf("-render-threads [<count>]\n");
+	printf("\tRender the layers on the given number of threads (default: one\n");
+	printf("\tless than the number of host CPUs). Ignored with -midline-effects.\n");
+	printf("-line-cache\n");
+	printf("\tOnly render the scanlines whose registers, palette, sprites or\n");
+	printf("\tvideo RAM have changed since the previous frame.\n");
+	printf("-present-thread\n");
+	printf("\tShow the frames on a thread of its own, so waiting for vsync\n");
+	printf("\tdoes not hold up the emulation. Ignored with -debug and\n");
+	printf("\ton macOS.\n");
 	printf("-enable-ym2151-irq\n");
 	printf("\tConnect the YM2151 IRQ source to the emulated CPU. This option increases\n");
 	printf("\tCPU usage as audio render is triggered for every CPU instruction.\n");
@@ -816,6 +895,45 @@ main(int argc, char **argv)
 			argc--;
 			argv++;
 			warp_mode = true;
+		} else if (!strcmp(argv[0], "-warp-frames")) {
+			argc--;
+			argv++;
+			if (!argc) {
+				usage();
+			}
+			if (!strcmp(argv[0], "auto")) {
+				warp_frames = WARP_FRAMES_AUTO;
+			} else {
+				char *end;
+				warp_frames_value = (int)strtol(argv[0], &end, 10);
+				if (end != argv[0] && !*end && warp_frames_value >= 0) {
+					warp_frames = WARP_FRAMES_RATIO;
+				} else if (end != argv[0] && !strcmp(end, "fps") && warp_frames_value > 0) {
+					warp_frames = WARP_FRAMES_FPS;
+				} else {
+					usage();
+				}
+			}
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-bench")) {
+			argc--;
+			argv++;
+			bench_frames = BENCH_DEFAULT_FRAMES;
+			if (argc && argv[0][0] != '-') {
+				char *end;
+				long long value = strtoll(argv[0], &end, 10);
+				if (end != argv[0] && !*end && value > 0 && value <= UINT32_MAX) {
+					bench_frames = (uint32_t)value;
+				} else if (end != argv[0] && !strcmp(end, "cycles") && value > 0) {
+					bench_frames = 0;
+					bench_cycles = (uint64_t)value;
+				} else {
+					usage();
+				}
+				argc--;
+				argv++;
+			}
 		} else if (!strcmp(argv[0], "-pastewarp")) {
 			argc--;
 			argv++;
@@ -889,6 +1007,49 @@ main(int argc, char **argv)
 			}
 			argc--;
 			argv++;
+		} else if (!strcmp(argv[0], "-loadstate")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			load_state_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-savestate")) {
+			argc--;
+			argv++;
+			if (!argc || argv[0][0] == '-') {
+				usage();
+			}
+			save_state_path = argv[0];
+			argc--;
+			argv++;
+		} else if (!strcmp(argv[0], "-statecompress")) {
+			argc--;
+			argv++;
+			compress_state = true;
+		} else if (!strcmp(argv[0], "-rewind")) {
+			argc--;
+			argv++;
+			rewind_seconds = REWIND_DEFAULT_SECONDS;
+			if (argc && argv[0][0] != '-') {
+				rewind_seconds = (uint32_t)strtol(argv[0], NULL, 10);
+				if (rewind_seconds < 1) {
+					usage();
+				}
+				argc--;
+				argv++;
+			}
+		} else if (!strcmp(argv[0], "-bootcache")) {
+			argc--;
+			argv++;
+			boot_cache_dir = ".";
+			if (argc && argv[0][0] != '-') {
+				boot_cache_dir = argv[0];
+				argc--;
+				argv++;
+			}
 		} else if (!strcmp(argv[0], "-gif")) {
 			argc--;
 			argv++;
@@ -1059,6 +1220,23 @@ main(int argc, char **argv)
 			audio_buffers_set = true;
 			argc--;
 			argv++;
+		} else if (!strcmp(argv[0], "-resampler")) {
+			argc--;
+			argv++;
+			if (!argc) {
+				usage();
+			}
+			if (!strcmp(argv[0], "linear")) {
+				audio_resampler = AUDIO_RESAMPLER_LINEAR;
+			} else if (!strcmp(argv[0], "sinc4")) {
+				audio_resampler = AUDIO_RESAMPLER_SINC4;
+			} else if (!strcmp(argv[0], "sinc8")) {
+				audio_resampler = AUDIO_RESAMPLER_SINC8;
+			} else {
+				usage();
+			}
+			argc--;
+			argv++;
 		} else if (!strcmp(argv[0], "-rtc")) {
 			argc--;
 			argv++;
@@ -1158,6 +1336,32 @@ main(int argc, char **argv)
 			argc--;
 			argv++;
 			enable_midline = true;
+		} else if (!strcmp(argv[0], "-render-threads")) {
+			argc--;
+			argv++;
+			render_threads = SDL_max(SDL_GetCPUCount() - 1, 1);
+			if (argc && argv[0][0] != '-') {
+				render_threads = (int)strtol(argv[0], NULL, 10);
+				if (render_threads < 1) {
+					usage();
+				}
+				argc--;
+				argv++;
+			}
+			render_threads = SDL_min(render_threads, MAX_RENDER_THREADS);
+		} else if (!strcmp(argv[0], "-line-cache")) {
+			argc--;
+			argv++;
+			line_cache = true;
+		} else if (!strcmp(argv[0], "-present-thread")) {
+			argc--;
+			argv++;
+#if defined(__APPLE__) || defined(__EMSCRIPTEN__)
+			// the renderer can only be used from the main thread
+			printf("-present-thread is not supported on this platform.\n");
+#else
+			present_thread = true;
+#endif
 		} else if (!strcmp(argv[0], "-enable-ym2151-irq")){
 			argc--;
 			argv++;
@@ -1322,6 +1526,12 @@ main(int argc, char **argv)
 	// Available since SDL 2.0.8
 	SDL_SetHint(SDL_HINT_VIDEO_X11_NET_WM_BYPASS_COMPOSITOR, "0");
 #endif
+#ifdef SDL_HINT_VIDEO_X11_XINITTHREADS
+	if (present_thread) {
+		// the presentation thread talks to the X server, too
+		SDL_SetHint(SDL_HINT_VIDEO_X11_XINITTHREADS, "1");
+	}
+#endif
 #ifdef __EMSCRIPTEN__
 	emscripten_set_main_loop(emscripten_main_loop, 0, 0);
 #endif
@@ -1345,6 +1555,9 @@ main(int argc, char **argv)
 		}
 		audio_init(audio_dev_name, audio_buffers);
 		video_init(window_scale, screen_x_scale, scale_quality, fullscreen, window_opacity);
+	} else if (wav_path) {
+		// without a window, there is only the WAV file to render audio for
+		audio_init("offline", 0);
 	}
 
 	wav_recorder_set_path(wav_path);
@@ -1362,6 +1575,8 @@ main(int argc, char **argv)
 
 	timing_init();
 
+	scheduler_init();
+
 	// Initialize logging system
 	printf("X16 Emulator starting with logging enabled\n");
 	
@@ -1408,6 +1623,20 @@ main(int argc, char **argv)
 
 	instruction_counter = 0;
 
+	if (load_state_path && !machine_load_state(load_state_path)) {
+		exit(1);
+	}
+	if (boot_cache_dir && !load_state_path) {
+		boot_cache_init(zeroram);
+	}
+
+	if (bench_frames || bench_cycles) {
+		bench_init(bench_frames, bench_cycles);
+	}
+	if (rewind_seconds) {
+		rewind_init(rewind_seconds * REWIND_FRAMES_PER_SECOND);
+	}
+
 #ifdef __EMSCRIPTEN__
 	emscripten_cancel_main_loop();
 	emscripten_set_main_loop(emscripten_main_loop, 0, 1);
@@ -1415,6 +1644,12 @@ main(int argc, char **argv)
 	emulator_loop(NULL);
 #endif
 
+	if (save_state_path) {
+		machine_save_state(save_state_path);
+	}
+	if (bench_enabled) {
+		bench_report();
+	}
 	main_shutdown();
 	memory_dump_usage_counts();
 	return 0;
@@ -1426,9 +1661,9 @@ void main_shutdown() {
 		mcp_server_cleanup();
 	}
 	
+	wav_recorder_shutdown();
+	audio_close();
 	if (!headless){
-		wav_recorder_shutdown();
-		audio_close();
 		video_end();
 		SDL_Quit();
 	}
@@ -1509,6 +1744,7 @@ set_kernal_status(uint8_t s)
 
 	// everything okay, write the status!
 	RAM[status0] = s;
+	memory_dirty(&RAM[status0]);
 	return true;
 }
 
@@ -1680,6 +1916,7 @@ handle_ieee_intercept()
 			handled = false;
 			break;
 	}
+	bench_stop(BENCH_IO, base_ticks);
 
 	if (handled) {
 		// Add the number CPU cycles equivalent to the amount of time that the operation actually took
@@ -1701,6 +1938,372 @@ handle_ieee_intercept()
 	return handled;
 }
 
+// KERNAL idle loop detection
+//
+// While the KERNAL waits for input (e.g. at the BASIC prompt), it spins in
+// a loop that only polls the keyboard buffer, which is filled by the IRQ
+// handler. In headless and warp mode, such a loop gets probed once per
+// interrupt: if the CPU gets back to the same PC with the same registers,
+// without any I/O access and with all memory it wrote holding the original
+// values again, it would just repeat this until the next interrupt, so all
+// iterations of the loop up to the next possible interrupt can be skipped.
+
+#define IDLE_PROBE_CLOCKS 2000
+
+static bool idle_probing = false;
+static bool idle_probe_armed = true;
+static bool cpu_idle = false;
+static struct regs idle_regs;
+static uint32_t idle_probe_start_clocks;
+static uint32_t idle_loop_clocks;
+static uint32_t idle_loop_instructions;
+
+static bool
+kernal_idle_candidate()
+{
+	if (!(headless || warp_mode) || debugger_enabled || pasting_bas) {
+		return false;
+	}
+	if ((regs.status & FLAG_INTERRUPT) || regs.pc < 0xc000 || (is_gen2 && regs.k != 0)) {
+		return false;
+	}
+	if (memory_get_rom_bank() != 0 || BRAM[NDX - 0xa000] != 0) {
+		// not in the KERNAL, or there is input to process
+		return false;
+	}
+	return is_kernal();
+}
+
+static void
+idle_probe_start()
+{
+	idle_probing = true;
+	idle_probe_armed = false;
+	memcpy(&idle_regs, &regs, sizeof(regs));
+	idle_probe_start_clocks = clockticks6502;
+	idle_loop_instructions = 0;
+	memory_log_writes(true);
+}
+
+static void
+idle_probe_stop()
+{
+	idle_probing = false;
+	memory_log_writes(false);
+}
+
+// The emulator is about to change the machine state behind the CPU's back.
+static void
+idle_cancel()
+{
+	if (idle_probing) {
+		idle_probe_stop();
+	}
+	cpu_idle = false;
+}
+
+// Compared field by field, since the padding in struct regs is indeterminate
+static bool
+idle_regs_match()
+{
+	return regs.pc == idle_regs.pc
+		&& regs.c == idle_regs.c
+		&& regs.x == idle_regs.x
+		&& regs.y == idle_regs.y
+		&& regs.dp == idle_regs.dp
+		&& regs.sp == idle_regs.sp
+		&& regs.db == idle_regs.db
+		&& regs.k == idle_regs.k
+		&& regs.status == idle_regs.status
+		&& regs.e == idle_regs.e
+		&& regs.is65c816 == idle_regs.is65c816;
+}
+
+static bool
+idle_loop_closed()
+{
+	return idle_regs_match() && memory_writes_reverted();
+}
+
+// Without a path, the hotkeys use the -savestate/-loadstate file.
+static const char *
+quick_state_path()
+{
+	if (save_state_path) {
+		return save_state_path;
+	}
+	return load_state_path ? load_state_path : "x16emu.state";
+}
+
+bool
+machine_save_state(const char *path)
+{
+	if (!path) {
+		path = quick_state_path();
+	}
+	scheduler_sync();
+	if (!state_save(path, compress_state)) {
+		return false;
+	}
+	printf("Saved machine state to %s.\n", path);
+	return true;
+}
+
+bool
+machine_load_state(const char *path)
+{
+	if (!path) {
+		path = quick_state_path();
+	}
+	scheduler_sync();
+	if (!state_load(path)) {
+		return false;
+	}
+	idle_cancel();
+	printf("Loaded machine state from %s.\n", path);
+	return true;
+}
+
+bool
+machine_rewind(uint32_t frames)
+{
+	if (!rewind_enabled) {
+		printf("Rewinding requires -rewind.\n");
+		return false;
+	}
+	scheduler_sync();
+	video_render_wait();
+	if (!rewind_restore(frames)) {
+		return false;
+	}
+	idle_cancel();
+	return true;
+}
+
+// The MCP server thread claims the request before setting it up, so
+// that only one request can be pending.
+static bool
+claim_state_request()
+{
+	return SDL_AtomicCAS(&state_request, STATE_REQUEST_NONE, STATE_REQUEST_CLAIMED);
+}
+
+// Blocks until the emulator loop has served the request. If the loop
+// hasn't picked it up within 5 seconds, the request is withdrawn; once
+// it is being served, it is always waited for.
+static bool
+wait_for_state_request(int request)
+{
+	SDL_AtomicSet(&state_request, request);
+	for (int i = 0; i < 5000; i++) {
+		if (SDL_AtomicGet(&state_request) == STATE_REQUEST_NONE) {
+			return state_request_result;
+		}
+		SDL_Delay(1);
+	}
+	if (SDL_AtomicCAS(&state_request, request, STATE_REQUEST_NONE)) {
+		// the emulator loop is not running
+		return false;
+	}
+	while (SDL_AtomicGet(&state_request) != STATE_REQUEST_NONE) {
+		SDL_Delay(1);
+	}
+	return state_request_result;
+}
+
+// Called by the MCP server thread
+bool
+machine_request_state(const char *path, bool save, bool compress)
+{
+	if (!claim_state_request()) {
+		return false;
+	}
+	snprintf(state_request_path, sizeof(state_request_path), "%s", path);
+	state_request_compress = compress;
+	return wait_for_state_request(save ? STATE_REQUEST_SAVE : STATE_REQUEST_LOAD);
+}
+
+// Called by the MCP server thread
+bool
+machine_request_rewind(uint32_t frames)
+{
+	if (!claim_state_request()) {
+		return false;
+	}
+	state_request_frames = frames;
+	return wait_for_state_request(STATE_REQUEST_REWIND);
+}
+
+static void
+serve_state_request()
+{
+	int request = SDL_AtomicGet(&state_request);
+	if (request != STATE_REQUEST_REWIND && request != STATE_REQUEST_SAVE && request != STATE_REQUEST_LOAD) {
+		return;
+	}
+	if (!SDL_AtomicCAS(&state_request, request, STATE_REQUEST_SERVING)) {
+		// withdrawn by the requesting thread
+		return;
+	}
+	if (request == STATE_REQUEST_REWIND) {
+		state_request_result = machine_rewind(state_request_frames);
+	} else {
+		bool compress = compress_state;
+		compress_state = state_request_compress;
+		if (request == STATE_REQUEST_SAVE) {
+			state_request_result = machine_save_state(state_request_path);
+		} else {
+			state_request_result = machine_load_state(state_request_path);
+		}
+		compress_state = compress;
+	}
+	SDL_AtomicSet(&state_request, STATE_REQUEST_NONE);
+}
+
+// Adds a file's name, size and modification time to a boot cache key
+static uint32_t
+boot_cache_key_file(uint32_t key, const char *path)
+{
+	struct stat st;
+	key = crc32(key, (const Bytef *)path, strlen(path) + 1);
+	if (!stat(path, &st)) {
+		uint64_t id[2] = { (uint64_t)st.st_size, (uint64_t)st.st_mtime };
+		key = crc32(key, (const Bytef *)id, sizeof(id));
+	}
+	return key;
+}
+
+// Everything that can change what the machine looks like at the first
+// BASIC prompt goes into the name of its boot cache file.
+static uint32_t
+boot_cache_key(bool zeroram)
+{
+	struct {
+		uint16_t num_ram_banks;
+		uint16_t midi_card_addr;
+		uint8_t mhz;
+		uint8_t is65c816;
+		uint8_t is_gen2;
+		uint8_t has_via2;
+		uint8_t has_midi_card;
+		uint8_t has_serial;
+		uint8_t has_sdcard;
+		uint8_t using_hostfs;
+		uint8_t keymap;
+		uint8_t zeroram;
+		uint8_t pwr_long_press;
+		uint8_t ym2151_irq_support;
+	} config;
+
+	memset(&config, 0, sizeof(config));
+	config.num_ram_banks = num_ram_banks;
+	config.midi_card_addr = has_midi_card ? midi_card_addr : 0;
+	config.mhz = MHZ;
+	config.is65c816 = regs.is65c816;
+	config.is_gen2 = is_gen2;
+	config.has_via2 = has_via2;
+	config.has_midi_card = has_midi_card;
+	config.has_serial = has_serial;
+	config.has_sdcard = sdcard_path_is_set();
+	config.using_hostfs = using_hostfs;
+	config.keymap = keymap;
+	config.zeroram = zeroram;
+	config.pwr_long_press = pwr_long_press;
+	config.ym2151_irq_support = ym2151_irq_support;
+
+	uint32_t key = crc32(0, (const Bytef *)&config, sizeof(config));
+	key = crc32(key, ROM, ROM_SIZE);
+	key = crc32(key, nvram, sizeof(nvram));
+	if (CART) {
+		key = crc32(key, CART, CART_SIZE);
+	}
+	// the KERNAL has already mounted the boot medium and tried AUTOBOOT.X16
+	if (sdcard_path_is_set()) {
+		key = boot_cache_key_file(key, sdcard_get_path());
+	}
+	if (using_hostfs) {
+		char autoboot[PATH_MAX];
+		key = crc32(key, fsroot_path, strlen((char *)fsroot_path) + 1);
+		snprintf(autoboot, sizeof(autoboot), "%s/AUTOBOOT.X16", (char *)startin_path);
+		key = boot_cache_key_file(key, autoboot);
+	}
+	return key;
+}
+
+// Restores the cached post-boot state, or arranges for it to be saved
+// once the KERNAL has booted into BASIC.
+static void
+boot_cache_init(bool zeroram)
+{
+	snprintf(boot_cache_path, sizeof(boot_cache_path), "%s/x16emu-boot-%08x.state", boot_cache_dir, boot_cache_key(zeroram));
+
+	SDL_RWops *f = SDL_RWFromFile(boot_cache_path, "rb");
+	if (!f) {
+		boot_cache_pending = true;
+		return;
+	}
+	SDL_RWclose(f);
+
+	if (!machine_load_state(boot_cache_path)) {
+		// boot normally and replace it
+		boot_cache_pending = true;
+		return;
+	}
+	if (set_system_time) {
+		rtc_set_system_time();
+	}
+	// the state was saved as BASIC started reading a line, and it
+	// still has to get the -prg/-bas/-test input
+	basic_reads_line();
+}
+
+static void
+basic_reads_line()
+{
+	if (boot_cache_pending) {
+		boot_cache_pending = false;
+		if (state_save(boot_cache_path, true)) {
+			printf("Saved boot cache to %s.\n", boot_cache_path);
+		}
+	}
+
+	// as soon as BASIC starts reading a line...
+	static bool prg_done = false;
+
+	if (prg_file && !prg_done) {
+		int loadlen = 0;
+		// LOAD":*" will cause the IEEE library
+		// to load from "prg_file"
+		if (prg_override_start >= 0) {
+			loadlen = snprintf(paste_text_data, sizeof(paste_text_data), "LOAD\":*\",%d,1,$%04X\r", ieee_unit, prg_override_start);
+		} else {
+			loadlen = snprintf(paste_text_data, sizeof(paste_text_data), "LOAD\":*\",%d,1\r", ieee_unit);
+		}
+		paste_text = paste_text_data;
+		prg_done = true;
+
+		if (run_after_load) {
+			if (prg_override_start >= 0) {
+				snprintf(paste_text_data + loadlen, sizeof(paste_text_data) - loadlen, "SYS$%04X\r", prg_override_start);
+			} else {
+				snprintf(paste_text_data + loadlen, sizeof(paste_text_data) - loadlen, "RUN\r");
+			}
+		}
+	}
+	else if (testbench && !test_init_complete){
+		snprintf(paste_text_data, sizeof(paste_text_data), "SYS65533\r");
+		paste_text = paste_text_data;
+		test_init_complete=true;
+	}
+
+	if (paste_text) {
+		// ...paste BASIC code into the keyboard buffer
+		pasting_bas = true;
+		if (warp_pastes) warp_mode = true;
+	}
+
+}
+
 void
 emscripten_main_loop(void) {
 	emulator_loop(NULL);
@@ -1710,8 +2313,10 @@ emscripten_main_loop(void) {
 void *
 emulator_loop(void *param)
 {
-	uint32_t old_clockticks6502 = clockticks6502;
+	static bool irq_asserted = false;
 	for (;;) {
+		serve_state_request();
+
 		// Check if emulator is paused
 		if (emulator_paused) {
 			// Sleep briefly to avoid busy waiting
@@ -1726,6 +2331,7 @@ emulator_loop(void *param)
 		}
 
 		if (debugger_enabled) {
+			DEBUGApplyWatchPages();
 			int dbgCmd = DEBUGGetCurrentStatus();
 			if (dbgCmd > 0) continue;
 			if (dbgCmd < 0) break;
@@ -1842,42 +2448,68 @@ emulator_loop(void *param)
 #endif
 
 		if (handle_ieee_intercept()) {
+			idle_cancel();
 			continue;
 		}
 
-		instruction_counter += waiting ^ 0x1;
-
-		step6502();
-		uint32_t clocks = clockticks6502 - old_clockticks6502;
-		old_clockticks6502 = clockticks6502;
-		bool new_frame = false;
-		via1_step(clocks);
-		vera_spi_step(MHZ, clocks);
-		if (has_serial) {
-			serial_step(clocks);
+		// Run a batch of instructions up to the next device deadline. The
+		// batch ends early on I/O accesses, once the PC enters the KERNAL
+		// API area that is intercepted below and at every instruction the
+		// debugger has to look at (breakpoint pages, single stepping).
+		// While an IRQ is asserted, every instruction is its own batch.
+		uint32_t batch_clocks = scheduler_clocks_until_deadline();
+		if (irq_asserted) {
+			batch_clocks = 1;
 		}
-		if (has_via2) {
-			via2_step(clocks);
-		}
-		if (!headless) {
-			new_frame |= video_step(MHZ, clocks, false);
+#if defined(TRACE) || defined(PERFSTAT)
+		batch_clocks = 1;
+#endif
+		if (!waiting && !cpu_idle && !idle_probing && idle_probe_armed && !irq_asserted && !debugArmed && kernal_idle_candidate()) {
+			idle_probe_start();
 		}
 
-		for (uint32_t i = 0; i < clocks; i++) {
-			i2c_step();
+		uint32_t batch_end = clockticks6502 + batch_clocks;
+		scheduler_io_pending = false;
+		if (waiting) {
+			// WAI: nothing happens until a device raises an interrupt
+			clockticks6502 += scheduler_clocks_until_irq();
+		} else if (cpu_idle) {
+			// skip all iterations of the idle loop that end before a
+			// device can raise an interrupt, and run the rest normally
+			uint32_t loops = scheduler_clocks_until_irq() / idle_loop_clocks;
+			clockticks6502 += loops * idle_loop_clocks;
+			instruction_counter += loops * idle_loop_instructions;
+			cpu_idle = false;
+			idle_probe_armed = true;
+		} else if (idle_probing) {
+			do {
+				instruction_counter++;
+				idle_loop_instructions++;
+				step_cpu();
+				if (idle_loop_closed()) {
+					idle_loop_clocks = clockticks6502 - idle_probe_start_clocks;
+					cpu_idle = true;
+					break;
+				}
+			} while ((int32_t)(batch_end - clockticks6502) > 0 && !scheduler_io_pending && regs.pc < 0xfea8 && !waiting && !DEBUGCheckPC(regs.k, regs.pc));
+		} else {
+			do {
+				instruction_counter += waiting ^ 0x1;
+				step_cpu();
+			} while ((int32_t)(batch_end - clockticks6502) > 0 && !scheduler_io_pending && regs.pc < 0xfea8 && !waiting && !DEBUGCheckPC(regs.k, regs.pc));
 		}
-		rtc_step(clocks);
-
-		if (!headless) {
-			audio_step(clocks);
+		if (idle_probing && (cpu_idle || scheduler_io_pending || waiting || clockticks6502 - idle_probe_start_clocks >= IDLE_PROBE_CLOCKS)) {
+			idle_probe_stop();
 		}
 
-		midi_serial_step(clocks);
-
-		// Process MCP keyboard queue with timing
-		keyboard_process_mcp_queue();
+		scheduler_sync();
 
+		bool new_frame = scheduler_take_new_frame();
+		if (new_frame && rewind_enabled) {
+			rewind_snapshot();
+		}
 		if (!headless && new_frame) {
+			uint64_t bench_video = bench_start();
 			if (nvram_dirty && nvram_path) {
 				SDL_RWops *f = SDL_RWFromFile(nvram_path, "wb");
 				if (f) {
@@ -1892,6 +2524,7 @@ emulator_loop(void *param)
 			}
 
 			timing_update();
+			bench_stop(BENCH_VIDEO, bench_video);
 #ifdef __EMSCRIPTEN__
 			// After completing a frame we yield back control to the browser to stay responsive
 			return 0;
@@ -1902,12 +2535,21 @@ emulator_loop(void *param)
 		// is lost if we need to track the YM2151 IRQ, so it has been made a
 		// command-line switch that's disabled by default.
 		if (ym2151_irq_support) {
+			uint64_t bench_audio = bench_start();
 			audio_render();
+			bench_stop(BENCH_AUDIO, bench_audio);
 		}
 
-		if (video_get_irq_out() || via1_irq() || (has_via2 && via2_irq()) || (ym2151_irq_support && YM_irq()) || (has_midi_card && midi_serial_irq())) {
+		if (bench_enabled && bench_step(new_frame)) {
+			break;
+		}
+
+		irq_asserted = video_get_irq_out() || via1_irq() || (has_via2 && via2_irq()) || (ym2151_irq_support && YM_irq()) || (has_midi_card && midi_serial_irq());
+		if (irq_asserted) {
 //			printf("IRQ!\n");
 			irq6502();
+			idle_cancel();
+			idle_probe_armed = true;
 		}
 
 		if (regs.pc == 0xffff) {
@@ -1955,43 +2597,13 @@ emulator_loop(void *param)
 			}
 
 			if (regs.pc == 0xffcf) {
-				// as soon as BASIC starts reading a line...
-				static bool prg_done = false;
-
-				if (prg_file && !prg_done) {
-					int loadlen = 0;
-					// LOAD":*" will cause the IEEE library
-					// to load from "prg_file"
-					if (prg_override_start >= 0) {
-						loadlen = snprintf(paste_text_data, sizeof(paste_text_data), "LOAD\":*\",%d,1,$%04X\r", ieee_unit, prg_override_start);
-					} else {
-						loadlen = snprintf(paste_text_data, sizeof(paste_text_data), "LOAD\":*\",%d,1\r", ieee_unit);
-					}
-					paste_text = paste_text_data;
-					prg_done = true;
-
-					if (run_after_load) {
-						if (prg_override_start >= 0) {
-							snprintf(paste_text_data + loadlen, sizeof(paste_text_data) - loadlen, "SYS$%04X\r", prg_override_start);
-						} else {
-							snprintf(paste_text_data + loadlen, sizeof(paste_text_data) - loadlen, "RUN\r");
-						}
-					}
-				}
-				else if (testbench && !test_init_complete){
-					snprintf(paste_text_data, sizeof(paste_text_data), "SYS65533\r");
-					paste_text = paste_text_data;
-					test_init_complete=true;
-				}
-
-				if (paste_text) {
-					// ...paste BASIC code into the keyboard buffer
-					pasting_bas = true;
-					if (warp_pastes) warp_mode = true;
-				}
+				basic_reads_line();
 			}
 
 		}
+		if (pasting_bas) {
+			idle_cancel();
+		}
 #if 0 // enable this for slow pasting
 		if (!(instruction_counter % 100000))
 #endif
@@ -2010,7 +2622,9 @@ emulator_loop(void *param)
 			}
 			if (c && !e) {
 				BRAM[KEYD - 0xa000 + BRAM[NDX - 0xa000]] = c;
+				memory_dirty(&BRAM[KEYD - 0xa000 + BRAM[NDX - 0xa000]]);
 				BRAM[NDX - 0xa000]++;
+				memory_dirty(&BRAM[NDX - 0xa000]);
 			} else {
 				pasting_bas = false;
 				if (warp_pastes) warp_mode = false;
@@ -158,6 +158,10 @@ public:
 // Forward declarations for screenshot functions
 extern "C" bool video_take_screenshot(void);
 extern "C" const char* get_last_screenshot_filename(void);
+extern "C" void video_request_capture(void);
+extern "C" bool video_capture_pending(void);
+extern "C" bool headless;
+extern "C" bool debugger_enabled;
 
 // Forward declarations for screen capture functions
 extern "C" {
@@ -205,10 +209,19 @@ extern "C" {
     extern void emulator_pause(void);
     extern void emulator_unpause(void);
     
+    // Save states
+    extern bool machine_request_state(const char *path, bool save, bool compress);
+    extern bool machine_request_rewind(uint32_t frames);
+    
     // Debugger functions
     extern void DEBUGBreakToDebugger(void);
     extern void DEBUGSetBreakPoint(struct breakpoint newBreakPoint);
-    extern int DEBUGGetCurrentStatus(void);
+    extern bool DEBUGAddBreakPoint(struct breakpoint newBreakPoint, const char *condition);
+    extern bool DEBUGRemoveBreakPoint(struct breakpoint oldBreakPoint);
+    extern void DEBUGClearBreakPoints(void);
+    extern bool DEBUGAddWatchPoint(int space, int access, uint32_t start, uint32_t end);
+    extern void DEBUGClearWatchPoints(void);
+    extern int DEBUGGetStatus(void);
     
     // Program loading functions - properly declared
     extern char paste_text_data[65536];  // Array, not pointer
@@ -373,6 +386,33 @@ static void* mcp_server_thread(void* arg) {
     return NULL;
 }
 
+// Without a window, VERA only composes the framebuffer while a capture is
+// pending, so have it render a complete frame before taking a screenshot
+static void wait_for_headless_frame() {
+    if (!headless) {
+        return;
+    }
+    video_request_capture();
+    // give up after a second, e.g. while the emulator is paused
+    for (int i = 0; i < 100 && video_capture_pending(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+// Breakpoints and watchpoints are only checked by the debugger, so
+// setting them without -debug would silently have no effect
+static bool require_debugger(httplib::Response& res) {
+    if (debugger_enabled) {
+        return true;
+    }
+    json response = {
+        {"status", "error"},
+        {"message", "The debugger is not enabled, start the emulator with -debug"}
+    };
+    res.set_content(response.dump(), "application/json");
+    return false;
+}
+
 // Set up MCP HTTP routes
 static void setup_mcp_routes(httplib::Server& server) {
     if (g_mcp_state.config.debug_mode) {
@@ -390,6 +430,9 @@ static void setup_mcp_routes(httplib::Server& server) {
                 "GET / - Server info",
                 "POST /reset - Reset emulator",
                 "POST /nmi - Send NMI interrupt",
+                "POST /save_state - Save machine state to a file",
+                "POST /load_state - Load machine state from a file",
+                "POST /rewind - Rewind by a number of frames (requires -rewind)",
                 "POST /screenshot - Capture screenshot only",
                 "POST /text_screenshot - Capture text screen content",
                 "POST /snapshot - Capture system state (CPU, memory, VERA) with screenshot",
@@ -438,6 +481,83 @@ static void setup_mcp_routes(httplib::Server& server) {
         return;
     });
     
+    // Save or load the machine state. The request is served by the
+    // emulator thread between two instructions.
+    auto state_handler = [](bool save) {
+        return [save](const httplib::Request& req, httplib::Response& res) {
+            if (g_mcp_state.config.debug_mode) {
+                printf("MCP Server: %s state command received\n", save ? "Save" : "Load");
+            }
+            
+            try {
+                json request_json = json::parse(req.body);
+                
+                if (!request_json.contains("path")) {
+                    json response = {
+                        {"status", "error"},
+                        {"message", "Missing required parameter: path"}
+                    };
+                    res.set_content(response.dump(), "application/json");
+                    return;
+                }
+                
+                std::string path = request_json["path"];
+                bool compress = request_json.value("compress", false);
+                
+                bool success = machine_request_state(path.c_str(), save, compress);
+                json response = {
+                    {"status", success ? "success" : "error"},
+                    {"path", path}
+                };
+                if (!success) {
+                    response["message"] = save ? "Cannot save state" : "Cannot load state";
+                }
+                res.set_content(response.dump(), "application/json");
+                
+            } catch (const json::exception& e) {
+                json response = {
+                    {"status", "error"},
+                    {"message", "Invalid JSON: " + std::string(e.what())}
+                };
+                res.set_content(response.dump(), "application/json");
+            }
+        };
+    };
+    server.Post("/save_state", state_handler(true));
+    server.Post("/load_state", state_handler(false));
+    
+    // Rewind through the snapshots kept by -rewind
+    server.Post("/rewind", [](const httplib::Request& req, httplib::Response& res) {
+        if (g_mcp_state.config.debug_mode) {
+            printf("MCP Server: Rewind command received\n");
+        }
+        
+        try {
+            json request_json;
+            if (!req.body.empty()) {
+                request_json = json::parse(req.body);
+            }
+            uint32_t frames = request_json.value("frames", 60);
+            
+            bool success = machine_request_rewind(frames);
+            json response = {
+                {"status", success ? "success" : "error"},
+                {"frames", frames}
+            };
+            if (!success) {
+                response["message"] = "Cannot rewind (is -rewind enabled?)";
+            }
+            res.set_content(response.dump(), "application/json");
+            
+        } catch (const json::exception& e) {
+            json response = {
+                {"status", "error"},
+                {"message", "Invalid JSON: " + std::string(e.what())}
+            };
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+    
     // Take a text screenshot
     server.Post("/text_screenshot", [](const httplib::Request& req, httplib::Response& res) {
         if (g_mcp_state.config.debug_mode) {
@@ -547,6 +667,7 @@ static void setup_mcp_routes(httplib::Server& server) {
         log_info("MCP Server: Starting screenshot capture");
         
         // Take screenshot using new API
+        wait_for_headless_frame();
         bool success = video_take_screenshot();
         
         if (success) {
@@ -658,6 +779,7 @@ static void setup_mcp_routes(httplib::Server& server) {
         log_info("MCP Server: Starting snapshot capture");
         
         // Take screenshot using new API
+        wait_for_headless_frame();
         bool success = video_take_screenshot();
         
         if (success) {
@@ -1126,12 +1248,16 @@ static void setup_mcp_routes(httplib::Server& server) {
             printf("MCP Server: Debug break command received\n");
         }
         
+        if (!require_debugger(res)) {
+            return;
+        }
+        
         DEBUGBreakToDebugger();
         
         json response = {
             {"status", "success"},
             {"message", "Debugger break triggered"},
-            {"debug_status", DEBUGGetCurrentStatus()}
+            {"debug_status", DEBUGGetStatus()}
         };
         res.set_content(response.dump(), "application/json");
     });
@@ -1142,6 +1268,10 @@ static void setup_mcp_routes(httplib::Server& server) {
             printf("MCP Server: Set breakpoint command received\n");
         }
         
+        if (!require_debugger(res)) {
+            return;
+        }
+        
         try {
             json request_json = json::parse(req.body);
             
@@ -1157,13 +1287,22 @@ static void setup_mcp_routes(httplib::Server& server) {
             int address = request_json["address"];
             uint8_t bank = request_json.value("bank", 0);
             int x16_bank = request_json.value("x16_bank", -1);
+            std::string condition = request_json.value("condition", "");
             
             struct breakpoint bp;
             bp.pc = address;
             bp.bank = bank;
             bp.x16Bank = x16_bank;
             
-            DEBUGSetBreakPoint(bp);
+            // Adds to the existing breakpoints; x16_bank -1 hits in any bank
+            if (!DEBUGAddBreakPoint(bp, condition.c_str())) {
+                json response = {
+                    {"status", "error"},
+                    {"message", "Invalid breakpoint address or condition"}
+                };
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
             
             json response = {
                 {"status", "success"},
@@ -1171,7 +1310,8 @@ static void setup_mcp_routes(httplib::Server& server) {
                 {"breakpoint", {
                     {"address", address},
                     {"bank", bank},
-                    {"x16_bank", x16_bank}
+                    {"x16_bank", x16_bank},
+                    {"condition", condition}
                 }}
             };
             res.set_content(response.dump(), "application/json");
@@ -1185,22 +1325,122 @@ static void setup_mcp_routes(httplib::Server& server) {
         }
     });
     
-    // Clear breakpoint (set to -1)
+    // Clear one breakpoint, or all of them without an address
     server.Post("/debug/clear_breakpoint", [](const httplib::Request& req, httplib::Response& res) {
         if (g_mcp_state.config.debug_mode) {
             printf("MCP Server: Clear breakpoint command received\n");
         }
         
-        struct breakpoint bp;
-        bp.pc = -1;
-        bp.bank = 0;
-        bp.x16Bank = -1;
+        try {
+            json request_json = req.body.empty() ? json::object() : json::parse(req.body);
+            
+            if (!request_json.contains("address")) {
+                DEBUGClearBreakPoints();
+                json response = {
+                    {"status", "success"},
+                    {"message", "All breakpoints cleared"}
+                };
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+            
+            struct breakpoint bp;
+            bp.pc = request_json["address"];
+            bp.bank = request_json.value("bank", 0);
+            bp.x16Bank = request_json.value("x16_bank", -1);
+            
+            bool found = DEBUGRemoveBreakPoint(bp);
+            json response = {
+                {"status", found ? "success" : "error"},
+                {"message", found ? "Breakpoint cleared" : "No breakpoint at this address"}
+            };
+            res.set_content(response.dump(), "application/json");
+            
+        } catch (const json::exception& e) {
+            json response = {
+                {"status", "error"},
+                {"message", "Invalid JSON: " + std::string(e.what())}
+            };
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+    
+    // Set watchpoint
+    server.Post("/debug/watchpoint", [](const httplib::Request& req, httplib::Response& res) {
+        if (g_mcp_state.config.debug_mode) {
+            printf("MCP Server: Set watchpoint command received\n");
+        }
+        
+        if (!require_debugger(res)) {
+            return;
+        }
+        
+        try {
+            json request_json = json::parse(req.body);
+            
+            if (!request_json.contains("start")) {
+                json response = {
+                    {"status", "error"},
+                    {"message", "Missing required parameter: start"}
+                };
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+            
+            // start/end are CPU addresses (bank in bits 16-23) for "ram",
+            // x16 bank in bits 16-23 for "bram" and VRAM addresses for "vram"
+            std::string space_name = request_json.value("space", "ram");
+            std::string access_name = request_json.value("access", "w");
+            uint32_t start = request_json["start"];
+            uint32_t end = request_json.value("end", start);
+            
+            int space = space_name == "bram" ? WATCH_BRAM : space_name == "vram" ? WATCH_VRAM : space_name == "ram" ? WATCH_RAM : -1;
+            int access = 0;
+            if (access_name.find('r') != std::string::npos) access |= WATCH_READ;
+            if (access_name.find('w') != std::string::npos) access |= WATCH_WRITE;
+            if (access_name.find('x') != std::string::npos) access |= WATCH_EXEC;
+            
+            if (!DEBUGAddWatchPoint(space, access, start, end)) {
+                json response = {
+                    {"status", "error"},
+                    {"message", "Invalid watchpoint space, access or range"}
+                };
+                res.set_content(response.dump(), "application/json");
+                return;
+            }
+            
+            json response = {
+                {"status", "success"},
+                {"message", "Watchpoint set"},
+                {"watchpoint", {
+                    {"space", space_name},
+                    {"access", access_name},
+                    {"start", start},
+                    {"end", end}
+                }}
+            };
+            res.set_content(response.dump(), "application/json");
+            
+        } catch (const json::exception& e) {
+            json response = {
+                {"status", "error"},
+                {"message", "Invalid JSON: " + std::string(e.what())}
+            };
+            res.set_content(response.dump(), "application/json");
+        }
+    });
+    
+    // Clear all watchpoints
+    server.Post("/debug/clear_watchpoints", [](const httplib::Request& req, httplib::Response& res) {
+        if (g_mcp_state.config.debug_mode) {
+            printf("MCP Server: Clear watchpoints command received\n");
+        }
         
-        DEBUGSetBreakPoint(bp);
+        DEBUGClearWatchPoints();
         
         json response = {
             {"status", "success"},
-            {"message", "Breakpoint cleared"}
+            {"message", "Watchpoints cleared"}
         };
         res.set_content(response.dump(), "application/json");
     });
@@ -1216,7 +1456,7 @@ static void setup_mcp_routes(httplib::Server& server) {
         json response = {
             {"status", "success"},
             {"message", "Execution continued"},
-            {"debug_status", DEBUGGetCurrentStatus()},
+            {"debug_status", DEBUGGetStatus()},
             {"paused", emulator_is_paused()}
         };
         res.set_content(response.dump(), "application/json");
@@ -1228,7 +1468,7 @@ static void setup_mcp_routes(httplib::Server& server) {
             printf("MCP Server: Debug status command received\n");
         }
         
-        int debug_status = DEBUGGetCurrentStatus();
+        int debug_status = DEBUGGetStatus();
         bool paused = emulator_is_paused();
         
         std::string status_str;
@@ -20,6 +20,10 @@
 #include "iso_8859_15.h"
 #include "midi.h"
 #include "asm_logging.h"
+#include "scheduler.h"
+#include "state.h"
+#include "rewind.h"
+#include "debugger.h"
 
 uint8_t ram_bank;
 uint8_t rom_bank;
@@ -42,12 +46,50 @@ uint64_t *ROM_banked_reads[256];
 uint64_t *ROM_banked_writes[256];	// shouldn't occur for obvious reasons unless Bonk RAM is installed in a cart
 
 
+// Host pointers for each 256 byte page of the CPU's bank 0 address space
+// that can be accessed without side effects: low RAM, the current RAM bank
+// and, for reading, the current ROM bank. Pages with a NULL entry (I/O,
+// open bus, cartridge banks, writes to page 0 with the bank registers and
+// to ROM) take the slow path. With access diagnostics enabled or while
+// writes are being logged, all entries stay NULL so that every access goes
+// through the slow path. With the rewind buffer enabled, only pages that
+// are already dirty are mapped for writing, so the slow path sees the
+// first write to each page after a snapshot. Pages with a debugger
+// watchpoint are not mapped for the watched kind of access.
+static uint8_t *read_pages[256];
+static uint8_t *write_pages[256];
+static bool instrumented = false;
+
+// WATCH_READ/WATCH_WRITE for each page of the CPU's address space with a
+// watchpoint, in any bank (see memory_watch_pages())
+static uint8_t watch_pages[256];
+
+// One flag per STATE_PAGE_SIZE bytes of memory written since the last
+// snapshot of the rewind buffer
+static uint8_t *ram_dirty;
+static uint8_t *bram_dirty;
+static uint8_t cart_dirty[CART_MAX_SIZE / STATE_PAGE_SIZE];
+
+// Original values of the memory locations written while logging is on, to
+// detect code that leaves memory unchanged (see memory_writes_reverted())
+#define WRITE_LOG_SIZE 16
+static struct {
+	uint8_t *mem;
+	uint8_t value;
+} write_log[WRITE_LOG_SIZE];
+static int write_log_count;
+static bool write_log_overflow;
+static bool logging_writes = false;
+
 static uint32_t clock_snap = 0UL;
 static uint32_t clock_base = 0UL;
 
 #define DEVICE_EMULATOR (0x9fb0)
 
 void cpuio_write(uint8_t reg, uint8_t value);
+static void map_low_ram();
+static void map_ram_bank();
+static void map_rom_bank();
 
 void
 memory_init()
@@ -55,6 +97,8 @@ memory_init()
 	// Initialize RAM array
 	RAM = calloc(RAM_SIZE, sizeof(uint8_t));
 	BRAM = calloc(BRAM_SIZE, sizeof(uint8_t));
+	ram_dirty = calloc(RAM_SIZE / STATE_PAGE_SIZE, sizeof(uint8_t));
+	bram_dirty = calloc(BRAM_SIZE / STATE_PAGE_SIZE, sizeof(uint8_t));
 
 	if(reportUsageStatisticsFilename!=NULL) {
 		RAM_system_reads = calloc(num_banks * BANK_SIZE, sizeof(uint64_t));
@@ -98,6 +142,9 @@ memory_init()
 		}
 	}
 
+	instrumented = reportUninitializedAccess || reportUsageStatisticsFilename != NULL;
+	map_low_ram();
+
 	memory_reset();
 }
 
@@ -160,9 +207,9 @@ static const char *format_addr(uint16_t address, uint8_t bank, uint8_t x16Bank)
 	return buffer;
 }
 
-uint8_t
-read6502(uint16_t address, uint8_t bank) {
-	if (!is_gen2) bank = 0;
+static uint8_t
+read6502_instrumented(uint16_t address, uint8_t bank)
+{
 	// Report access to uninitialized RAM (if option selected)
 	if (reportUninitializedAccess) {
 		if (bank == 0) {
@@ -203,6 +250,34 @@ read6502(uint16_t address, uint8_t bank) {
 	return real_read6502(address, bank, false, USE_CURRENT_X16_BANK);
 }
 
+static void
+watch_access(uint16_t address, uint8_t bank, int access, uint8_t value)
+{
+	if (bank == 0 && address >= 0xa000 && address < 0xc000) {
+		DEBUGWatchAccess(WATCH_BRAM, (ram_bank << 16) | address, access, value);
+	} else {
+		DEBUGWatchAccess(WATCH_RAM, (bank << 16) | address, access, value);
+	}
+}
+
+uint8_t
+read6502(uint16_t address, uint8_t bank)
+{
+	uint8_t *page = read_pages[address >> 8];
+	if (page && (bank == 0 || !is_gen2)) {
+		return page[address & 0xff];
+	}
+
+	if (!is_gen2) bank = 0;
+	if (watch_pages[address >> 8] & WATCH_READ) {
+		watch_access(address, bank, WATCH_READ, real_read6502(address, bank, true, USE_CURRENT_X16_BANK));
+	}
+	if (instrumented) {
+		return read6502_instrumented(address, bank);
+	}
+	return real_read6502(address, bank, false, USE_CURRENT_X16_BANK);
+}
+
 uint8_t
 real_read6502(uint16_t address, uint8_t bank, bool debugOn, int16_t x16Bank)
 {
@@ -217,6 +292,9 @@ real_read6502(uint16_t address, uint8_t bank, bool debugOn, int16_t x16Bank)
 	if (address < 0x9f00) { // RAM
 		return RAM[address];
 	} else if (address < 0xa000) { // I/O
+		if (!debugOn) {
+			scheduler_io_access();
+		}
 		if (!debugOn && address >= 0x9fa0) {
 			// slow IO5-7 range
 			clockticks6502 += 3;
@@ -270,11 +348,12 @@ real_read6502(uint16_t address, uint8_t bank, bool debugOn, int16_t x16Bank)
 	}
 }
 
-void
-write6502(uint16_t address, uint8_t bank, uint8_t value)
-{
-	if (!is_gen2) bank = 0;
+static void
+real_write6502(uint16_t address, uint8_t bank, uint8_t value);
 
+static void
+write6502_instrumented(uint16_t address, uint8_t bank, uint8_t value)
+{
 	if(reportUsageStatisticsFilename!=NULL) {
 		if (bank != 0 || address < 0xa000) {
 			RAM_system_writes[bank * BANK_SIZE + address]++;
@@ -296,10 +375,81 @@ write6502(uint16_t address, uint8_t bank, uint8_t value)
 		}
 	}
 
+	real_write6502(address, bank, value);
+}
+
+static void
+log_write(uint16_t address, uint8_t bank)
+{
+	uint8_t *mem;
+	if (is_gen2 && bank != 0) {
+		if (bank >= num_banks) {
+			return;
+		}
+		mem = &RAM[bank * BANK_SIZE + address];
+	} else if (address < 0x9f00) {
+		mem = &RAM[address];
+	} else if (address < 0xa000) {
+		// I/O accesses are tracked by the scheduler
+		return;
+	} else if (address < 0xc000) {
+		if (ram_bank >= num_ram_banks) {
+			return;
+		}
+		mem = &BRAM[(ram_bank << 13) + address - 0xa000];
+	} else {
+		if (rom_bank >= 32) {
+			// cartridge RAM is not tracked
+			write_log_overflow = true;
+		}
+		return;
+	}
+
+	for (int i = 0; i < write_log_count; i++) {
+		if (write_log[i].mem == mem) {
+			return;
+		}
+	}
+	if (write_log_count == WRITE_LOG_SIZE) {
+		write_log_overflow = true;
+		return;
+	}
+	write_log[write_log_count].mem = mem;
+	write_log[write_log_count].value = *mem;
+	write_log_count++;
+}
+
+void
+write6502(uint16_t address, uint8_t bank, uint8_t value)
+{
+	uint8_t *page = write_pages[address >> 8];
+	if (page && (bank == 0 || !is_gen2)) {
+		page[address & 0xff] = value;
+		return;
+	}
+
+	if (!is_gen2) bank = 0;
+	if (watch_pages[address >> 8] & WATCH_WRITE) {
+		watch_access(address, bank, WATCH_WRITE, value);
+	}
+	if (logging_writes) {
+		log_write(address, bank);
+	}
+	if (instrumented) {
+		write6502_instrumented(address, bank, value);
+	} else {
+		real_write6502(address, bank, value);
+	}
+}
+
+static void
+real_write6502(uint16_t address, uint8_t bank, uint8_t value)
+{
 	// Write to memory
 	if (is_gen2 && bank != 0) {
 		if (bank < num_banks) {
 			RAM[bank * BANK_SIZE + address] = value;
+			ram_dirty[(bank * BANK_SIZE + address) / STATE_PAGE_SIZE] = 1;
 		}
 		return;
 	}
@@ -311,7 +461,12 @@ write6502(uint16_t address, uint8_t bank, uint8_t value)
 	// Write to memory
 	if (address < 0x9f00) { // RAM
 		RAM[address] = value;
+		if (!ram_dirty[address / STATE_PAGE_SIZE]) {
+			ram_dirty[address / STATE_PAGE_SIZE] = 1;
+			map_low_ram();
+		}
 	} else if (address < 0xa000) { // I/O
+		scheduler_io_access();
 		if (address >= 0x9fa0) {
 			// slow IO5-7 range
 			clockticks6502 += 3;
@@ -344,11 +499,17 @@ write6502(uint16_t address, uint8_t bank, uint8_t value)
 		}
 	} else if (address < 0xc000) { // banked RAM
 		if (memory_get_ram_bank() < num_ram_banks) {
-			BRAM[(memory_get_ram_bank() << 13) + address - 0xa000] = value;
+			uint32_t offset = (memory_get_ram_bank() << 13) + address - 0xa000;
+			BRAM[offset] = value;
+			if (!bram_dirty[offset / STATE_PAGE_SIZE]) {
+				bram_dirty[offset / STATE_PAGE_SIZE] = 1;
+				map_ram_bank();
+			}
 		}
 	} else { // ROM
 		if (rom_bank >= 32) { // Cartridge ROM/RAM
 			cartridge_write(address, rom_bank, value);
+			cart_dirty[(((rom_bank - 32) << 14) + address - 0xc000) / STATE_PAGE_SIZE] = 1;
 		}
 		// ignore if base ROM (banks 0-31)
 	}
@@ -375,6 +536,48 @@ memory_save(SDL_RWops *f, bool dump_ram, bool dump_bank)
 	}
 }
 
+void
+memory_state()
+{
+	STATE_FIELD(ram_bank);
+	STATE_FIELD(rom_bank);
+	STATE_FIELD(addr_ym);
+	STATE_FIELD(clock_snap);
+	STATE_FIELD(clock_base);
+	state_memory(RAM, is_gen2 ? num_banks * BANK_SIZE : 0xa000, ram_dirty);
+	state_memory(BRAM, num_ram_banks * 8192, bram_dirty);
+
+	// only the RAM banks of a cartridge can change
+	if (CART) {
+		for (int bank = 32; bank < 256; bank++) {
+			if (cartridge_get_bank_type(bank) >= CART_BANK_UNINITIALIZED_RAM) {
+				uint32_t offset = (bank - 32) * CART_BANK_SIZE;
+				state_memory(&CART[offset], CART_BANK_SIZE, &cart_dirty[offset / STATE_PAGE_SIZE]);
+			}
+		}
+	}
+
+	if (state_loading()) {
+		memory_set_rom_bank(rom_bank);
+	}
+	// a snapshot of the rewind buffer clears the dirty flags, which
+	// unmaps the pages for writing
+	map_low_ram();
+	map_ram_bank();
+}
+
+// For code that writes to RAM or banked RAM directly instead of through
+// write6502()
+void
+memory_dirty(const uint8_t *mem)
+{
+	if (mem >= RAM && mem < RAM + RAM_SIZE) {
+		ram_dirty[(mem - RAM) / STATE_PAGE_SIZE] = 1;
+	} else if (mem >= BRAM && mem < BRAM + BRAM_SIZE) {
+		bram_dirty[(mem - BRAM) / STATE_PAGE_SIZE] = 1;
+	}
+}
+
 
 void writestring(SDL_RWops *f, const char *string) {
 	SDL_RWwrite(f, string, strlen(string), 1);
@@ -448,10 +651,93 @@ void memory_dump_usage_counts() {
 ///
 ///
 
+static void
+map_low_ram()
+{
+	for (int page = 0; page < 0x9f; page++) {
+		if (instrumented || logging_writes) {
+			read_pages[page] = NULL;
+			write_pages[page] = NULL;
+		} else {
+			read_pages[page] = watch_pages[page] & WATCH_READ ? NULL : &RAM[page << 8];
+			write_pages[page] = page && !(watch_pages[page] & WATCH_WRITE) && (!rewind_enabled || ram_dirty[page]) ? &RAM[page << 8] : NULL;
+		}
+	}
+}
+
+static void
+map_ram_bank()
+{
+	uint8_t *bank = NULL;
+	uint8_t *dirty = NULL;
+	if (!instrumented && !logging_writes && ram_bank < num_ram_banks) {
+		bank = &BRAM[ram_bank << 13];
+		dirty = &bram_dirty[(ram_bank << 13) / STATE_PAGE_SIZE];
+	}
+	for (int page = 0; page < 0x20; page++) {
+		uint8_t watch = watch_pages[0xa0 + page];
+		read_pages[0xa0 + page] = bank && !(watch & WATCH_READ) ? &bank[page << 8] : NULL;
+		write_pages[0xa0 + page] = bank && !(watch & WATCH_WRITE) && (!rewind_enabled || dirty[page]) ? &bank[page << 8] : NULL;
+	}
+}
+
+static void
+map_rom_bank()
+{
+	uint8_t *bank = NULL;
+	if (!instrumented && !logging_writes && rom_bank < 32) {
+		bank = &ROM[rom_bank << 14];
+	}
+	for (int page = 0; page < 0x40; page++) {
+		read_pages[0xc0 + page] = bank && !(watch_pages[0xc0 + page] & WATCH_READ) ? &bank[page << 8] : NULL;
+	}
+}
+
+// Set the pages with debugger watchpoints. Must be called on the
+// emulator thread.
+void
+memory_watch_pages(const uint8_t *pages)
+{
+	memcpy(watch_pages, pages, sizeof(watch_pages));
+	map_low_ram();
+	map_ram_bank();
+	map_rom_bank();
+}
+
+// Start or stop logging the original values of all memory locations the
+// CPU writes to. While logging, all accesses take the slow path.
+void
+memory_log_writes(bool enable)
+{
+	logging_writes = enable;
+	write_log_count = 0;
+	write_log_overflow = false;
+	map_low_ram();
+	map_ram_bank();
+	map_rom_bank();
+}
+
+// Whether all memory locations written since logging was started hold
+// their original values again.
+bool
+memory_writes_reverted()
+{
+	if (write_log_overflow) {
+		return false;
+	}
+	for (int i = 0; i < write_log_count; i++) {
+		if (*write_log[i].mem != write_log[i].value) {
+			return false;
+		}
+	}
+	return true;
+}
+
 inline void
 memory_set_ram_bank(uint8_t bank)
 {
 	ram_bank = bank;
+	map_ram_bank();
 }
 
 inline uint8_t
@@ -464,6 +750,7 @@ inline void
 memory_set_rom_bank(uint8_t bank)
 {
 	rom_bank = bank;
+	map_rom_bank();
 }
 
 inline uint8_t
@@ -61,6 +61,8 @@ void memory_report_usage_statistics(const char *filename);
 void memory_randomize_ram(bool);
 
 void memory_save(SDL_RWops *f, bool dump_ram, bool dump_bank);
+void memory_state(void);
+void memory_dirty(const uint8_t *mem);
 void memory_dump_usage_counts();
 
 void memory_set_ram_bank(uint8_t bank);
@@ -69,6 +71,10 @@ void memory_set_rom_bank(uint8_t bank);
 uint8_t memory_get_ram_bank();
 uint8_t memory_get_rom_bank();
 
+void memory_log_writes(bool enable);
+void memory_watch_pages(const uint8_t *pages);
+bool memory_writes_reverted();
+
 uint8_t emu_read(uint8_t reg, bool debugOn);
 void emu_write(uint8_t reg, uint8_t value);
 
@@ -989,6 +989,20 @@ void midi_serial_write(uint8_t reg, uint8_t val)
     }
 }
 
+uint32_t midi_serial_next_event(void)
+{
+    // number of CPU clocks until the next UART bit time on either channel
+    uint32_t next = UINT32_MAX;
+    uint8_t sel;
+    for (sel=0; sel<2; sel++) {
+        if (mregs[sel].clockdec > 0) {
+            int64_t clocks = mregs[sel].clock / mregs[sel].clockdec + 1;
+            if (clocks < next) next = (uint32_t)clocks;
+        }
+    }
+    return next;
+}
+
 bool midi_serial_irq(void)
 {
     bool uart0int = (mregs[0].iir & 1) == 0 && mregs[0].mcr_out2;
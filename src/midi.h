@@ -43,5 +43,6 @@ void midi_serial_write(uint8_t reg, uint8_t val);
 void midi_load_sf2(uint8_t* filename);
 void midi_synth_render(int16_t* buf, int len);
 bool midi_serial_irq(void);
+uint32_t midi_serial_next_event(void);
 
 extern bool fs_midi_in_connect;
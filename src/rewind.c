@@ -0,0 +1,222 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+// Rewind buffer (-rewind)
+//
+// A ring of in-memory snapshots, one per frame. A snapshot holds the
+// device state from state_snapshot() and, for the bulk memory passed to
+// state_memory(), the previous contents of the pages that changed during
+// the frame. The previous contents come from a shadow copy of the memory
+// as of the newest snapshot, so only the dirty pages are ever compared
+// and copied. Rewinding first reverts the pages written since the newest
+// snapshot, then undoes the frames from the newest to the oldest.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rewind.h"
+#include "state.h"
+
+// RAM, banked RAM, video RAM and up to 224 cartridge RAM banks
+#define MAX_REGIONS 256
+
+typedef struct {
+	uint8_t *data;
+	size_t size;
+	uint8_t *dirty;
+	uint8_t *shadow; // contents as of the newest snapshot
+} region_t;
+
+typedef struct {
+	uint32_t region;
+	uint32_t page;
+	uint8_t data[STATE_PAGE_SIZE];
+} page_t;
+
+typedef struct {
+	uint8_t *state;
+	size_t state_size;
+	size_t state_capacity;
+	page_t *pages; // contents as of the previous snapshot
+	uint32_t num_pages;
+	uint32_t pages_capacity;
+} snapshot_t;
+
+bool rewind_enabled = false;
+
+static region_t regions[MAX_REGIONS];
+static uint32_t num_regions;
+static uint32_t region_index; // of the next rewind_memory() call
+
+static snapshot_t *ring;
+static uint32_t ring_size;
+static uint32_t ring_first;
+static uint32_t ring_count;
+static snapshot_t *current; // being taken
+static bool snapshot_failed; // ran out of memory while taking it
+
+void
+rewind_init(uint32_t frames)
+{
+	ring = calloc(frames, sizeof(snapshot_t));
+	if (!ring) {
+		printf("Not enough memory for the rewind buffer!\n");
+		return;
+	}
+	rewind_enabled = true;
+	ring_size = frames;
+}
+
+// Forgets all snapshots, e.g. after the memory has been replaced by
+// loading a state file. The next snapshot starts over with full copies.
+void
+rewind_reset()
+{
+	for (uint32_t i = 0; i < num_regions; i++) {
+		free(regions[i].shadow);
+	}
+	num_regions = 0;
+	ring_count = 0;
+}
+
+// Called through state_memory() while taking a snapshot
+void
+rewind_memory(void *data, size_t size, uint8_t *dirty)
+{
+	uint32_t num_pages = size / STATE_PAGE_SIZE;
+
+	if (snapshot_failed) {
+		return;
+	}
+	if (region_index == num_regions) {
+		if (num_regions == MAX_REGIONS) {
+			printf("Too many memory regions for the rewind buffer, rewind is disabled.\n");
+			rewind_enabled = false;
+			snapshot_failed = true;
+			return;
+		}
+		uint8_t *shadow = malloc(size);
+		if (!shadow) {
+			snapshot_failed = true;
+			return;
+		}
+		region_t *region = &regions[num_regions++];
+		region->data = data;
+		region->size = size;
+		region->dirty = dirty;
+		region->shadow = shadow;
+		memcpy(region->shadow, data, size);
+		memset(dirty, 0, num_pages);
+		region_index++;
+		return;
+	}
+
+	region_t *region = &regions[region_index];
+	for (uint32_t page = 0; page < num_pages; page++) {
+		if (!dirty[page]) {
+			continue;
+		}
+		dirty[page] = 0;
+		uint8_t *mem = region->data + page * STATE_PAGE_SIZE;
+		uint8_t *shadow = region->shadow + page * STATE_PAGE_SIZE;
+		if (!memcmp(mem, shadow, STATE_PAGE_SIZE)) {
+			continue;
+		}
+		if (current->num_pages == current->pages_capacity) {
+			uint32_t capacity = current->pages_capacity ? current->pages_capacity * 2 : 64;
+			page_t *pages = realloc(current->pages, capacity * sizeof(page_t));
+			if (!pages) {
+				snapshot_failed = true;
+				return;
+			}
+			current->pages = pages;
+			current->pages_capacity = capacity;
+		}
+		page_t *undo = &current->pages[current->num_pages++];
+		undo->region = region_index;
+		undo->page = page;
+		memcpy(undo->data, shadow, STATE_PAGE_SIZE);
+		memcpy(shadow, mem, STATE_PAGE_SIZE);
+	}
+	region_index++;
+}
+
+// Takes a snapshot, dropping the oldest one if the ring is full. Must be
+// called between two instructions, with all devices synced.
+void
+rewind_snapshot()
+{
+	if (ring_count == ring_size) {
+		ring_first = (ring_first + 1) % ring_size;
+		ring_count--;
+	}
+	current = &ring[(ring_first + ring_count) % ring_size];
+	current->num_pages = 0;
+
+	region_index = 0;
+	snapshot_failed = false;
+	size_t size;
+	const uint8_t *state = state_snapshot(&size);
+	if (state && !snapshot_failed && size > current->state_capacity) {
+		uint8_t *grown = realloc(current->state, size);
+		if (grown) {
+			current->state = grown;
+			current->state_capacity = size;
+		} else {
+			snapshot_failed = true;
+		}
+	}
+	if (!state || snapshot_failed) {
+		// The undo pages taken so far are lost, so the older snapshots
+		// can't be restored either. Drop them all and start over.
+		if (rewind_enabled) {
+			printf("Out of memory, the rewind buffer has been cleared.\n");
+		}
+		rewind_reset();
+		return;
+	}
+	memcpy(current->state, state, size);
+	current->state_size = size;
+	ring_count++;
+}
+
+// Restores the snapshot taken the given number of frames before the
+// newest one, or the oldest one if the buffer does not reach back that
+// far. The snapshots after it are dropped.
+bool
+rewind_restore(uint32_t frames)
+{
+	if (!ring_count) {
+		return false;
+	}
+	if (frames >= ring_count) {
+		frames = ring_count - 1;
+	}
+
+	// back to the newest snapshot
+	for (uint32_t i = 0; i < num_regions; i++) {
+		region_t *region = &regions[i];
+		for (uint32_t page = 0; page < region->size / STATE_PAGE_SIZE; page++) {
+			if (region->dirty[page]) {
+				region->dirty[page] = 0;
+				memcpy(region->data + page * STATE_PAGE_SIZE, region->shadow + page * STATE_PAGE_SIZE, STATE_PAGE_SIZE);
+			}
+		}
+	}
+
+	// undo one frame at a time
+	for (; frames; frames--) {
+		snapshot_t *snapshot = &ring[(ring_first + ring_count - 1) % ring_size];
+		for (uint32_t i = 0; i < snapshot->num_pages; i++) {
+			page_t *undo = &snapshot->pages[i];
+			region_t *region = &regions[undo->region];
+			memcpy(region->data + undo->page * STATE_PAGE_SIZE, undo->data, STATE_PAGE_SIZE);
+			memcpy(region->shadow + undo->page * STATE_PAGE_SIZE, undo->data, STATE_PAGE_SIZE);
+		}
+		ring_count--;
+	}
+
+	snapshot_t *snapshot = &ring[(ring_first + ring_count - 1) % ring_size];
+	state_restore_snapshot(snapshot->state, snapshot->state_size);
+	return true;
+}
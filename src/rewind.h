@@ -0,0 +1,24 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define REWIND_DEFAULT_SECONDS 30
+#define REWIND_FRAMES_PER_SECOND 60
+#define REWIND_HOTKEY_FRAMES REWIND_FRAMES_PER_SECOND
+
+extern bool rewind_enabled;
+
+void rewind_init(uint32_t frames);
+void rewind_snapshot(void);
+bool rewind_restore(uint32_t frames);
+void rewind_reset(void);
+
+void rewind_memory(void *data, size_t size, uint8_t *dirty);
+
+#endif
@@ -13,6 +13,7 @@
 #include <time.h>
 #include "rtc.h"
 #include "glue.h"
+#include "state.h"
 
 bool nvram_dirty = false;
 uint8_t nvram[0x40];
@@ -47,6 +48,21 @@ rtc_i2c_data(uint8_t v) {
 #define BCD(a) (((a) / 10) << 4 | ((a) % 10))
 #define UNBCD(a) (((a) >> 4) * 10 + ((a) & 0xf))
 
+void
+rtc_set_system_time()
+{
+	running = true;
+	time_t t = time(NULL);
+	struct tm tm = *localtime(&t);
+	seconds = tm.tm_sec;
+	minutes = tm.tm_min;
+	hours = tm.tm_hour;
+	day_of_week = (tm.tm_wday == 0 ? 7 : tm.tm_wday);
+	day = tm.tm_mday;
+	month = tm.tm_mon + 1;
+	year = tm.tm_year - 100;
+}
+
 void
 rtc_init(bool set_system_time)
 {
@@ -55,16 +71,7 @@ rtc_init(bool set_system_time)
 	clocks = 0;
 
 	if (set_system_time) {
-		running = true;
-		time_t t = time(NULL);
-		struct tm tm = *localtime(&t);
-		seconds = tm.tm_sec;
-		minutes = tm.tm_min;
-		hours = tm.tm_hour;
-		day_of_week = (tm.tm_wday == 0 ? 7 : tm.tm_wday);
-		day = tm.tm_mday;
-		month = tm.tm_mon + 1;
-		year = tm.tm_year - 100;
+		rtc_set_system_time();
 	} else {
 		running = false; // yes, the MCP7940N starts out this way!
 		seconds = 0;
@@ -257,3 +264,21 @@ rtc_write() {
 	i2c_data_pos = 0;
 }
 
+void
+rtc_state()
+{
+	STATE_FIELD(nvram);
+	STATE_FIELD(running);
+	STATE_FIELD(vbaten);
+	STATE_FIELD(h24);
+	STATE_FIELD(clocks);
+	STATE_FIELD(seconds);
+	STATE_FIELD(minutes);
+	STATE_FIELD(hours);
+	STATE_FIELD(day_of_week);
+	STATE_FIELD(day);
+	STATE_FIELD(month);
+	STATE_FIELD(year);
+	STATE_FIELD(i2c_data);
+	STATE_FIELD(i2c_data_pos);
+}
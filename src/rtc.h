@@ -13,5 +13,6 @@ void rtc_set_system_time();
 void rtc_step(int c);
 uint8_t rtc_read();
 void rtc_write();
+void rtc_state(void);
 
 #endif
@@ -0,0 +1,176 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+// Cycle-timestamped device scheduler
+//
+// Instead of stepping every device after every instruction, the CPU runs
+// batches of instructions up to the earliest point in time at which a
+// device could change the state of the IRQ line (a VERA scanline, a VIA
+// timer underflow, a MIDI UART tick...). All devices are then stepped in
+// one go. Any access to the I/O area catches up all devices first, so the
+// CPU always observes the same device state it would have observed with
+// per-instruction stepping, and ends the current batch, so that the
+// deadlines can be recomputed from the new device state.
+//
+// While the CPU is halted by WAI, the clock jumps straight to the next
+// event that can raise an interrupt, and all devices are stepped in bulk.
+
+#include "scheduler.h"
+#include "glue.h"
+#include "cpu/fake6502.h"
+#include "via.h"
+#include "video.h"
+#include "vera_spi.h"
+#include "serial.h"
+#include "rtc.h"
+#include "audio.h"
+#include "midi.h"
+#include "keyboard.h"
+#include "bench.h"
+
+// Upper bound for skipping ahead while the CPU waits for an interrupt
+#define SCHEDULER_MAX_WAIT ((uint32_t)MHZ * 1000000 / 60)
+
+bool scheduler_io_pending = false;
+
+static uint32_t synced_clockticks; // CPU clock up to which all devices have been stepped
+static uint32_t deadline;          // CPU clock of the earliest pending device event
+static bool new_frame;
+
+static uint32_t
+next_device_event()
+{
+	uint32_t next = SCHEDULER_MAX_BATCH;
+
+	// The serial bus and the YM2151 timers are only ever updated in
+	// lockstep with the CPU.
+	if (has_serial || ym2151_irq_support) {
+		return 1;
+	}
+
+	next = SDL_min(next, via1_next_event());
+	if (has_via2) {
+		next = SDL_min(next, via2_next_event());
+	}
+	next = SDL_min(next, video_next_event(MHZ));
+	if (has_midi_card) {
+		next = SDL_min(next, midi_serial_next_event());
+	}
+	return next;
+}
+
+// Like next_device_event(), but only counts events that can assert IRQ or
+// end a frame. While the CPU is in WAI, nothing else can change its state.
+static uint32_t
+next_irq_event()
+{
+	uint32_t next = UINT32_MAX;
+
+	// The serial bus is only ever updated in lockstep with the CPU.
+	if (has_serial) {
+		return 1;
+	}
+
+	next = SDL_min(next, via1_next_event());
+	if (has_via2) {
+		next = SDL_min(next, via2_next_event());
+	}
+	next = SDL_min(next, video_next_irq_event(MHZ));
+	if (ym2151_irq_support) {
+		next = SDL_min(next, audio_ym_timer_next_event());
+	}
+	if (has_midi_card) {
+		next = SDL_min(next, midi_serial_next_event());
+	}
+	// Devices still need to be synced every once in a while, e.g. for the
+	// RTC and audio in headless mode.
+	return SDL_min(next, SCHEDULER_MAX_WAIT);
+}
+
+static void
+step_devices(uint32_t clocks)
+{
+	uint64_t bench_io = bench_start();
+	via1_step(clocks);
+	vera_spi_step(MHZ, clocks);
+	if (has_serial) {
+		serial_step(clocks);
+	}
+	if (has_via2) {
+		via2_step(clocks);
+	}
+	rtc_step(clocks);
+	midi_serial_step(clocks);
+	bench_stop(BENCH_IO, bench_io);
+
+	uint64_t bench_video = bench_start();
+	new_frame |= video_step(MHZ, clocks, false);
+	bench_stop(BENCH_VIDEO, bench_video);
+
+	// audio_step() returns early unless a device or the offline backend
+	// is open, so headless -wav runs render audio too.
+	uint64_t bench_audio = bench_start();
+	audio_step(clocks);
+	bench_stop(BENCH_AUDIO, bench_audio);
+}
+
+void
+scheduler_init()
+{
+	synced_clockticks = clockticks6502;
+	deadline = clockticks6502 + next_device_event();
+	scheduler_io_pending = false;
+	new_frame = false;
+}
+
+// Bring all devices up to the current CPU clock.
+void
+scheduler_sync()
+{
+	uint32_t clocks = clockticks6502 - synced_clockticks;
+	if (clocks) {
+		step_devices(clocks);
+		synced_clockticks = clockticks6502;
+	}
+
+	// Process MCP keyboard queue with timing
+	keyboard_process_mcp_queue();
+
+	deadline = clockticks6502 + next_device_event();
+}
+
+// Called by the memory subsystem before the CPU touches the I/O area.
+void
+scheduler_io_access()
+{
+	uint32_t clocks = clockticks6502 - synced_clockticks;
+	if (clocks) {
+		step_devices(clocks);
+		synced_clockticks = clockticks6502;
+	}
+	scheduler_io_pending = true;
+}
+
+uint32_t
+scheduler_clocks_until_deadline()
+{
+	int32_t clocks = (int32_t)(deadline - clockticks6502);
+	return clocks > 0 ? clocks : 1;
+}
+
+// Number of clocks the CPU can skip while waiting for an interrupt (WAI):
+// the earliest point at which a device can raise one. The skipped time is
+// handed to the devices by the next scheduler_sync().
+uint32_t
+scheduler_clocks_until_irq()
+{
+	return next_irq_event();
+}
+
+bool
+scheduler_take_new_frame()
+{
+	bool result = new_frame;
+	new_frame = false;
+	return result;
+}
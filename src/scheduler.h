@@ -0,0 +1,23 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Upper bound for a single batch of CPU instructions, in CPU clocks.
+// Devices without a pending event are still synced at least this often.
+#define SCHEDULER_MAX_BATCH 0x4000
+
+extern bool scheduler_io_pending;
+
+void scheduler_init(void);
+void scheduler_sync(void);
+void scheduler_io_access(void);
+uint32_t scheduler_clocks_until_deadline(void);
+uint32_t scheduler_clocks_until_irq(void);
+bool scheduler_take_new_frame(void);
+
+#endif
@@ -13,6 +13,7 @@
 #include <string.h>
 #include "sdcard.h"
 #include "files.h"
+#include "state.h"
 
 //#define VERBOSE 1
 
@@ -77,6 +78,12 @@ sdcard_path_is_set()
 	return strlen(sdcard_path) > 0;
 }
 
+char const *
+sdcard_get_path()
+{
+	return sdcard_path;
+}
+
 void
 sdcard_attach()
 {
@@ -394,3 +401,37 @@ sdcard_handle(uint8_t inbyte)
 	}
 	return outbyte;
 }
+
+// The contents of the card are not part of the state, only the
+// controller is.
+void
+sdcard_state()
+{
+	// a response can point into any of the static response buffers,
+	// so it is stored by value
+	static uint8_t restored_response[2 + 512 + 2];
+	int32_t length = response ? response_length : 0;
+	STATE_FIELD(length);
+	if (length < 0 || length > sizeof(restored_response)) {
+		// corrupt state, leave the rest of the chunk unread
+		return;
+	}
+	if (state_loading()) {
+		state_field(restored_response, length);
+		response = length ? restored_response : NULL;
+		response_length = length;
+	} else if (length) {
+		state_field((void *)response, length);
+	}
+	STATE_FIELD(response_counter);
+
+	STATE_FIELD(rxbuf);
+	STATE_FIELD(rxbuf_idx);
+	STATE_FIELD(lba);
+	STATE_FIELD(last_cmd);
+	STATE_FIELD(is_acmd);
+	STATE_FIELD(is_idle);
+	STATE_FIELD(is_initialized);
+	STATE_FIELD(ongoing_multiblock_read);
+	STATE_FIELD(selected);
+}
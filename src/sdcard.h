@@ -10,10 +10,12 @@
 extern bool sdcard_attached;
 void sdcard_set_path(char const *path);
 bool sdcard_path_is_set();
+char const *sdcard_get_path();
 void sdcard_attach();
 void sdcard_detach();
 
 void sdcard_select(bool select);
 uint8_t sdcard_handle(uint8_t inbyte);
+void sdcard_state(void);
 
 #endif
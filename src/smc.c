@@ -10,6 +10,7 @@
 #include "smc.h"
 #include "glue.h"
 #include "i2c.h"
+#include "state.h"
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
@@ -174,3 +175,14 @@ smc_write() {
 	i2c_data_pos = 0;
 }
 
+void
+smc_state()
+{
+	STATE_FIELD(default_read_op);
+	STATE_FIELD(default_read_state);
+	STATE_FIELD(activity_led);
+	STATE_FIELD(mse_count);
+	STATE_FIELD(i2c_data);
+	STATE_FIELD(i2c_data_pos);
+	STATE_FIELD(smc_requested_reset);
+}
@@ -15,6 +15,7 @@ extern void nmi6502();
 void smc_i2c_data(uint8_t v);
 uint8_t smc_read();
 void smc_write();
+void smc_state(void);
 
 extern bool smc_requested_reset;
 
@@ -0,0 +1,471 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "state.h"
+#include "glue.h"
+#include "memory.h"
+#include "video.h"
+#include "vera_psg.h"
+#include "vera_pcm.h"
+#include "vera_spi.h"
+#include "sdcard.h"
+#include "via.h"
+#include "ymglue.h"
+#include "i2c.h"
+#include "smc.h"
+#include "rtc.h"
+#include "audio.h"
+#include "timing.h"
+#include "scheduler.h"
+#include "rewind.h"
+#include "cpu/fake6502.h"
+
+// File layout, header numbers little endian:
+//
+// header: "X16STATE", u32 format version
+// chunk:  char id[4], u16 chunk version, u16 flags, u32 stored size,
+//         u32 size, followed by the (possibly zlib compressed) data
+//
+// Unknown chunks are skipped, so new subsystems can be added without
+// breaking older state files from the same format version.
+//
+// The chunk data is the subsystems' fields as they are laid out in
+// memory, padding included, so state files are specific to the host's
+// byte order and ABI.
+
+#define STATE_MAGIC "X16STATE"
+#define STATE_FORMAT_VERSION 1
+#define HEADER_SIZE 12
+#define CHUNK_HEADER_SIZE 16
+
+#define CHUNK_COMPRESSED 1
+
+extern uint32_t instructions;
+
+static void machine_state(void);
+static void cpu_state(void);
+
+static const struct {
+	char id[4];
+	uint16_t version;
+	void (*state)(void);
+} chunk_types[] = {
+	{ "MACH", 1, machine_state },
+	{ "CPU ", 1, cpu_state },
+	{ "MEM ", 1, memory_state },
+	{ "VERA", 1, video_state },
+	{ "PSG ", 1, psg_state },
+	{ "PCM ", 1, pcm_state },
+	{ "VIA ", 1, via_state },
+	{ "YM  ", 1, YM_state },
+	{ "I2C ", 1, i2c_state },
+	{ "SMC ", 1, smc_state },
+	{ "RTC ", 1, rtc_state },
+	{ "SPI ", 1, vera_spi_state },
+	{ "SD  ", 1, sdcard_state },
+};
+
+#define NUM_CHUNK_TYPES (sizeof(chunk_types) / sizeof(chunk_types[0]))
+
+// the chunk that is being written or read
+static uint8_t *chunk;
+static const uint8_t *chunk_in; // when loading
+static size_t chunk_size;
+static size_t chunk_capacity;
+static size_t chunk_pos;
+static bool loading;
+static bool overrun;
+static bool out_of_memory;
+static bool snapshot; // in-memory snapshot, see state_snapshot()
+
+static bool config_mismatch;
+
+void
+state_field(void *data, size_t size)
+{
+	if (loading) {
+		if (chunk_pos + size > chunk_size) {
+			overrun = true;
+			return;
+		}
+		memcpy(data, chunk_in + chunk_pos, size);
+	} else {
+		if (chunk_pos + size > chunk_capacity) {
+			size_t capacity = SDL_max(chunk_capacity * 2, chunk_pos + size);
+			uint8_t *grown = realloc(chunk, capacity);
+			if (!grown) {
+				out_of_memory = true;
+				return;
+			}
+			chunk = grown;
+			chunk_capacity = capacity;
+		}
+		memcpy(chunk + chunk_pos, data, size);
+		chunk_size = chunk_pos + size;
+	}
+	chunk_pos += size;
+}
+
+void
+state_memory(void *data, size_t size, uint8_t *dirty)
+{
+	if (!snapshot) {
+		state_field(data, size);
+	} else if (!loading) {
+		rewind_memory(data, size, dirty);
+	}
+	// when restoring a snapshot, the rewind buffer has already
+	// restored the memory
+}
+
+bool
+state_loading()
+{
+	return loading;
+}
+
+// Everything that has to match for a state to be restorable. It is
+// checked before any other chunk is applied.
+static void
+machine_state()
+{
+	struct {
+		uint32_t rom_crc;
+		uint16_t num_banks;
+		uint16_t num_ram_banks;
+		uint8_t mhz;
+		uint8_t is65c816;
+		uint8_t is_gen2;
+		uint8_t has_via2;
+		uint8_t has_cartridge;
+	} config, saved;
+
+	memset(&config, 0, sizeof(config));
+	config.rom_crc = crc32(0, ROM, ROM_SIZE);
+	config.num_banks = num_banks;
+	config.num_ram_banks = num_ram_banks;
+	config.mhz = MHZ;
+	config.is65c816 = regs.is65c816;
+	config.is_gen2 = is_gen2;
+	config.has_via2 = has_via2;
+	config.has_cartridge = CART != NULL;
+
+	saved = config;
+	STATE_FIELD(saved);
+	config_mismatch = memcmp(&saved, &config, sizeof(config)) != 0;
+}
+
+static void
+cpu_state()
+{
+	STATE_FIELD(regs);
+	STATE_FIELD(clockticks6502);
+	STATE_FIELD(instructions);
+	STATE_FIELD(waiting);
+	STATE_FIELD(instruction_counter);
+}
+
+static uint16_t
+get_le16(const uint8_t *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t
+get_le32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Saves the machine state. Must be called between two instructions,
+// with all devices synced to the CPU clock.
+bool
+state_save(const char *path, bool compress)
+{
+	SDL_RWops *f = SDL_RWFromFile(path, "wb");
+	if (!f) {
+		printf("Cannot write to %s!\n", path);
+		return false;
+	}
+
+	// pending audio is host state, flush it
+	audio_render();
+
+	bool ok = SDL_RWwrite(f, STATE_MAGIC, 8, 1) == 1;
+	ok &= SDL_WriteLE32(f, STATE_FORMAT_VERSION) == 1;
+
+	loading = false;
+	out_of_memory = false;
+	for (int i = 0; i < NUM_CHUNK_TYPES && ok; i++) {
+		chunk_pos = 0;
+		chunk_size = 0;
+		chunk_types[i].state();
+		if (out_of_memory) {
+			ok = false;
+			break;
+		}
+
+		const uint8_t *data = chunk;
+		uLongf stored_size = chunk_size;
+		uint16_t flags = 0;
+		uint8_t *packed = NULL;
+		if (compress && chunk_size) {
+			stored_size = compressBound(chunk_size);
+			packed = malloc(stored_size);
+			if (packed && compress2(packed, &stored_size, chunk, chunk_size, Z_BEST_SPEED) == Z_OK && stored_size < chunk_size) {
+				data = packed;
+				flags |= CHUNK_COMPRESSED;
+			} else {
+				stored_size = chunk_size;
+			}
+		}
+
+		ok &= SDL_RWwrite(f, chunk_types[i].id, 4, 1) == 1;
+		ok &= SDL_WriteLE16(f, chunk_types[i].version) == 1;
+		ok &= SDL_WriteLE16(f, flags) == 1;
+		ok &= SDL_WriteLE32(f, stored_size) == 1;
+		ok &= SDL_WriteLE32(f, chunk_size) == 1;
+		if (stored_size) {
+			ok &= SDL_RWwrite(f, data, stored_size, 1) == 1;
+		}
+		free(packed);
+	}
+
+	if (SDL_RWclose(f) < 0) {
+		ok = false;
+	}
+	if (out_of_memory) {
+		printf("Cannot save state to %s: out of memory\n", path);
+	} else if (!ok) {
+		printf("Cannot write to %s!\n", path);
+	}
+	return ok;
+}
+
+// Decompresses a chunk into a new buffer, which has to be exactly as
+// large as the header says
+static uint8_t *
+unpack_chunk(const uint8_t *data, uint16_t flags, uint32_t stored_size, uint32_t size)
+{
+	uint8_t *unpacked = malloc(size ? size : 1);
+	if (!unpacked) {
+		return NULL;
+	} else if (flags & CHUNK_COMPRESSED) {
+		uLongf unpacked_size = size;
+		if (uncompress(unpacked, &unpacked_size, data, stored_size) != Z_OK || unpacked_size != size) {
+			free(unpacked);
+			return NULL;
+		}
+	} else if (stored_size == size) {
+		memcpy(unpacked, data, size);
+	} else {
+		free(unpacked);
+		return NULL;
+	}
+	return unpacked;
+}
+
+// Hands a decompressed chunk to its subsystem, which has to use all of it
+static bool
+apply_chunk(int type, const uint8_t *data, size_t size)
+{
+	chunk_in = data;
+	chunk_size = size;
+	chunk_pos = 0;
+	overrun = false;
+	loading = true;
+	chunk_types[type].state();
+	loading = false;
+	return !overrun && chunk_pos == chunk_size;
+}
+
+// Serializes a chunk of the running machine into a new buffer. Returns
+// NULL if there is not enough memory.
+static uint8_t *
+save_chunk(int type, size_t *size)
+{
+	loading = false;
+	out_of_memory = false;
+	chunk_pos = 0;
+	chunk_size = 0;
+	chunk_types[type].state();
+
+	uint8_t *data = out_of_memory ? NULL : malloc(chunk_size ? chunk_size : 1);
+	if (!data) {
+		return NULL;
+	}
+	memcpy(data, chunk, chunk_size);
+	*size = chunk_size;
+	return data;
+}
+
+// Restores a state saved by state_save(). Like state_save(), it must be
+// called between two instructions. Every chunk is decompressed and
+// checked before the machine is touched. If one is still rejected by its
+// subsystem, the machine is put back the way it was, so a failed load
+// never leaves it half restored.
+bool
+state_load(const char *path)
+{
+	SDL_RWops *f = SDL_RWFromFile(path, "rb");
+	if (!f) {
+		printf("Cannot open %s!\n", path);
+		return false;
+	}
+	Sint64 file_size = SDL_RWsize(f);
+	uint8_t *file = file_size > 0 ? malloc(file_size) : NULL;
+	bool read_ok = file && SDL_RWread(f, file, file_size, 1) == 1;
+	SDL_RWclose(f);
+
+	struct {
+		const uint8_t *data;
+		uint16_t flags;
+		uint32_t stored_size;
+		uint32_t size;
+		uint8_t *unpacked;
+		uint8_t *backup;
+		size_t backup_size;
+	} chunks[NUM_CHUNK_TYPES];
+	memset(chunks, 0, sizeof(chunks));
+
+	char error[64] = "";
+	if (!read_ok) {
+		snprintf(error, sizeof(error), "read error");
+	} else if (file_size < HEADER_SIZE || memcmp(file, STATE_MAGIC, 8)) {
+		snprintf(error, sizeof(error), "not a state file");
+	} else if (get_le32(file + 8) != STATE_FORMAT_VERSION) {
+		snprintf(error, sizeof(error), "unsupported format version %u", get_le32(file + 8));
+	}
+
+	Sint64 pos = HEADER_SIZE;
+	while (!error[0] && pos < file_size) {
+		const uint8_t *header = file + pos;
+		if (file_size - pos < CHUNK_HEADER_SIZE || get_le32(header + 8) > file_size - pos - CHUNK_HEADER_SIZE) {
+			snprintf(error, sizeof(error), "file is truncated");
+			break;
+		}
+		for (int i = 0; i < NUM_CHUNK_TYPES; i++) {
+			if (!memcmp(header, chunk_types[i].id, 4)) {
+				if (get_le16(header + 4) != chunk_types[i].version) {
+					snprintf(error, sizeof(error), "unsupported version of chunk \"%.4s\"", chunk_types[i].id);
+				}
+				chunks[i].data = header + CHUNK_HEADER_SIZE;
+				chunks[i].flags = get_le16(header + 6);
+				chunks[i].stored_size = get_le32(header + 8);
+				chunks[i].size = get_le32(header + 12);
+			}
+		}
+		pos += CHUNK_HEADER_SIZE + get_le32(header + 8);
+	}
+	for (int i = 0; i < NUM_CHUNK_TYPES && !error[0]; i++) {
+		if (!chunks[i].data) {
+			snprintf(error, sizeof(error), "chunk \"%.4s\" is missing", chunk_types[i].id);
+		}
+	}
+	for (int i = 0; i < NUM_CHUNK_TYPES && !error[0]; i++) {
+		chunks[i].unpacked = unpack_chunk(chunks[i].data, chunks[i].flags, chunks[i].stored_size, chunks[i].size);
+		if (!chunks[i].unpacked) {
+			snprintf(error, sizeof(error), "chunk \"%.4s\" is corrupt", chunk_types[i].id);
+		}
+	}
+
+	// the machine configuration comes first and is only compared
+	if (!error[0]) {
+		if (!apply_chunk(0, chunks[0].unpacked, chunks[0].size)) {
+			snprintf(error, sizeof(error), "chunk \"%.4s\" is corrupt", chunk_types[0].id);
+		} else if (config_mismatch) {
+			snprintf(error, sizeof(error), "saved with a different machine configuration or ROM");
+		}
+	}
+
+	if (!error[0]) {
+		// pending audio belongs to the old state
+		audio_render();
+
+		for (int i = 1; i < NUM_CHUNK_TYPES && !error[0]; i++) {
+			chunks[i].backup = save_chunk(i, &chunks[i].backup_size);
+			if (!chunks[i].backup) {
+				snprintf(error, sizeof(error), "out of memory");
+			}
+		}
+		int applied = 1; // including a rejected one
+		for (int i = 1; i < NUM_CHUNK_TYPES && !error[0]; i++) {
+			applied = i + 1;
+			if (!apply_chunk(i, chunks[i].unpacked, chunks[i].size)) {
+				snprintf(error, sizeof(error), "chunk \"%.4s\" is corrupt", chunk_types[i].id);
+				break;
+			}
+		}
+		if (error[0]) {
+			for (int i = 1; i < applied; i++) {
+				apply_chunk(i, chunks[i].backup, chunks[i].backup_size);
+			}
+		} else {
+			timing_init();
+			rewind_reset();
+		}
+		scheduler_init();
+	}
+	for (int i = 0; i < NUM_CHUNK_TYPES; i++) {
+		free(chunks[i].unpacked);
+		free(chunks[i].backup);
+	}
+	free(file);
+
+	if (error[0]) {
+		printf("Cannot load state from %s: %s\n", path, error);
+		return false;
+	}
+	return true;
+}
+
+// Serializes all chunks but the machine configuration back to back into
+// a buffer that stays valid until the next call. Bulk memory is handed
+// to rewind_memory() instead. Like state_save(), it must be called
+// between two instructions. Returns NULL if there is not enough memory.
+const uint8_t *
+state_snapshot(size_t *size)
+{
+	audio_render();
+
+	loading = false;
+	out_of_memory = false;
+	snapshot = true;
+	chunk_pos = 0;
+	chunk_size = 0;
+	for (int i = 1; i < NUM_CHUNK_TYPES; i++) {
+		chunk_types[i].state();
+	}
+	snapshot = false;
+
+	*size = chunk_size;
+	return out_of_memory ? NULL : chunk;
+}
+
+// Restores the devices from a buffer returned by state_snapshot() after
+// the rewind buffer has restored the memory.
+void
+state_restore_snapshot(const uint8_t *data, size_t size)
+{
+	audio_render();
+
+	chunk_in = data;
+	chunk_size = size;
+	chunk_pos = 0;
+	overrun = false;
+
+	loading = true;
+	snapshot = true;
+	for (int i = 1; i < NUM_CHUNK_TYPES; i++) {
+		chunk_types[i].state();
+	}
+	snapshot = false;
+	loading = false;
+
+	scheduler_init();
+	timing_init();
+}
@@ -0,0 +1,37 @@
+// Commander X16 Emulator
+// All rights reserved. License: 2-clause BSD
+
+#ifndef STATE_H
+#define STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Machine save states
+//
+// A state file is a header followed by one chunk per subsystem. Every
+// subsystem has a single *_state() function that serializes its state
+// with state_field(): it copies the fields into the chunk while saving
+// and back out of it while loading, so both directions always agree on
+// the layout. Bump the chunk version when changing it.
+
+#define STATE_FIELD(x) state_field(&(x), sizeof(x))
+
+// Bulk memory (RAM, VRAM) is passed to state_memory() along with one
+// dirty flag per STATE_PAGE_SIZE bytes, which its writers have to set.
+// State files contain all of it, the in-memory snapshots of the rewind
+// buffer only the pages that have changed since the previous snapshot.
+#define STATE_PAGE_SIZE 256
+
+bool state_save(const char *path, bool compress);
+bool state_load(const char *path);
+
+const uint8_t *state_snapshot(size_t *size);
+void state_restore_snapshot(const uint8_t *data, size_t size);
+
+void state_field(void *data, size_t size);
+void state_memory(void *data, size_t size, uint8_t *dirty);
+bool state_loading(void);
+
+#endif
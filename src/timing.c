@@ -5,6 +5,9 @@
 #include "glue.h"
 #include "video.h"
 #include "cpu/fake6502.h"
+#include "bench.h"
+#include "timing.h"
+#include "audio.h"
 #include <SDL.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -17,6 +20,22 @@ int64_t cpu_ticks;
 int64_t last_perf_cpu_ticks;
 char window_title[255];
 
+enum warp_frames warp_frames = WARP_FRAMES_RATIO;
+int warp_frames_value = 64;
+
+// With WARP_FRAMES_AUTO, a frame is only rendered if the time spent on
+// rendering stays below 1/WARP_AUTO_RENDER_SHARE of the host time.
+#define WARP_AUTO_MAX_FPS 60
+#define WARP_AUTO_RENDER_SHARE 4
+
+static int warp_frame = -1;          // the frame the decision was made for
+static bool warp_frame_rendered;
+static uint64_t warp_last_render;     // host time of the last rendered frame
+static uint32_t warp_frames_skipped;  // since the last rendered one
+static uint64_t warp_frame_start;     // host time
+static double warp_skipped_frame_time; // running averages in host ticks
+static double warp_render_time;
+
 void
 timing_init() {
 	frames = 0;
@@ -27,6 +46,54 @@ timing_init() {
 	cpu_ticks = 0;
 }
 
+// Whether a frame is rendered in warp mode; the sprites are processed
+// either way for the collision IRQ. Called for every line, the decision
+// is made at the first one of each frame.
+bool
+timing_warp_render_frame(int frame)
+{
+	if (frame == warp_frame) {
+		return warp_frame_rendered;
+	}
+
+	// keep track of how long skipped frames take, and how much longer
+	// rendered ones take
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const uint64_t freq = SDL_GetPerformanceFrequency();
+	if (frame == warp_frame + 1) {
+		const double frame_time = now - warp_frame_start;
+		if (warp_frame_rendered) {
+			const double render_time = SDL_max(frame_time - warp_skipped_frame_time, 0);
+			warp_render_time += (render_time - warp_render_time) / 8;
+		} else {
+			warp_skipped_frame_time += (frame_time - warp_skipped_frame_time) / 8;
+		}
+	}
+	warp_frame = frame;
+	warp_frame_start = now;
+
+	switch (warp_frames) {
+		case WARP_FRAMES_RATIO:
+			warp_frame_rendered = warp_frames_value && !(frame % warp_frames_value);
+			break;
+		case WARP_FRAMES_FPS:
+			warp_frame_rendered = now - warp_last_render >= freq / warp_frames_value;
+			break;
+		case WARP_FRAMES_AUTO:
+			warp_frame_rendered = now - warp_last_render >= freq / WARP_AUTO_MAX_FPS &&
+				(warp_frames_skipped + 1) * warp_skipped_frame_time >= (WARP_AUTO_RENDER_SHARE - 1) * warp_render_time;
+			break;
+	}
+
+	if (warp_frame_rendered) {
+		warp_last_render = now;
+		warp_frames_skipped = 0;
+	} else {
+		warp_frames_skipped++;
+	}
+	return warp_frame_rendered;
+}
+
 void
 timing_update()
 {
@@ -35,7 +102,7 @@ timing_update()
 	clockticks6502_old = clockticks6502;
 	uint32_t sdlTicks = SDL_GetTicks() - sdlTicks_base;
 	int64_t diff_time = cpu_ticks / MHZ - sdlTicks * 1000LL;
-	if (!warp_mode && diff_time > 0) {
+	if (!warp_mode && !bench_enabled && diff_time > 0) {
 		if (diff_time >= 1000000) {
 			sleep(diff_time / 1000000);
 			diff_time %= 1000000;
@@ -67,6 +134,15 @@ timing_update()
 			printf("Rendering is behind %d frames.\n", -(int)frames_behind);
 		} else {
 		}
+
+		static uint32_t underruns_old, overruns_old;
+		uint32_t underruns, overruns;
+		audio_get_xruns(&underruns, &overruns);
+		if (underruns != underruns_old || overruns != overruns_old) {
+			printf("Audio underruns: %u, overruns: %u\n", underruns, overruns);
+			underruns_old = underruns;
+			overruns_old = overruns;
+		}
 	}
 }
 
@@ -1,7 +1,20 @@
 #ifndef TIMING_H
 #define TIMING_H
 
+#include <stdbool.h>
+
+// which frames are rendered in warp mode
+enum warp_frames {
+	WARP_FRAMES_RATIO, // one in warp_frames_value, none if 0
+	WARP_FRAMES_FPS,   // up to warp_frames_value per second
+	WARP_FRAMES_AUTO,  // as many as the host can afford, up to 60 per second
+};
+
+extern enum warp_frames warp_frames;
+extern int warp_frames_value;
+
 void timing_init();
 void timing_update();
+bool timing_warp_render_frame(int frame);
 
 #endif
@@ -3,6 +3,7 @@
 // All rights reserved. License: 2-clause BSD
 
 #include "vera_pcm.h"
+#include "state.h"
 #include <stdio.h>
 
 static uint8_t  fifo[4096];
@@ -180,3 +181,18 @@ pcm_render(int16_t *buf, unsigned num_samples)
 		*(buf++) = (int16_t)((int32_t)cur_r * volume_lut[ctrl & 0xF] / 64);
 	}
 }
+
+void
+pcm_state(void)
+{
+	STATE_FIELD(fifo);
+	STATE_FIELD(fifo_wridx);
+	STATE_FIELD(fifo_rdidx);
+	STATE_FIELD(fifo_cnt);
+	STATE_FIELD(ctrl);
+	STATE_FIELD(rate);
+	STATE_FIELD(loop);
+	STATE_FIELD(cur_l);
+	STATE_FIELD(cur_r);
+	STATE_FIELD(phase);
+}
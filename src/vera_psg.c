@@ -3,6 +3,7 @@
 // All rights reserved. License: 2-clause BSD
 
 #include "vera_psg.h"
+#include "state.h"
 
 #include <stdbool.h>
 #include <string.h>
@@ -38,11 +39,40 @@ static uint16_t volume_lut[64] = {
 
 static uint16_t noise_state;
 
+// The noise LFSR advances 16 times per sample, once for every channel. Being
+// linear, 16 steps at once are the XOR of the steps of its two state bytes.
+static uint16_t noise_step16_lo[256];
+static uint16_t noise_step16_hi[256];
+
+#define BLOCK_SAMPLES 256
+
+static uint16_t
+noise_step(uint16_t state)
+{
+	return (state << 1) | (((state >> 1) ^ (state >> 2) ^ (state >> 4) ^ (state >> 15)) & 1);
+}
+
+static void
+noise_init(void)
+{
+	for (int i = 0; i < 256; i++) {
+		uint16_t lo = i;
+		uint16_t hi = i << 8;
+		for (int j = 0; j < 16; j++) {
+			lo = noise_step(lo);
+			hi = noise_step(hi);
+		}
+		noise_step16_lo[i] = lo;
+		noise_step16_hi[i] = hi;
+	}
+}
+
 void
 psg_reset(void)
 {
 	memset(channels, 0, sizeof(channels));
 	noise_state = 1;
+	noise_init();
 }
 
 void
@@ -70,57 +100,137 @@ psg_writereg(uint8_t reg, uint8_t val)
 	}
 }
 
-static void
-render(int16_t *left, int16_t *right)
+// In FPGA implementation, noise values are generated every system clock and
+// the channel update is run sequentially. So, even if both two channels are
+// fetching a noise value in the same sample, they should have different values.
+// noise[] holds the LFSR state before and after each sample in its upper and
+// lower halves, which has the state each channel sees somewhere in between.
+static inline uint16_t
+noise_value(const uint32_t *noise, unsigned sample, int channel)
 {
-	int16_t l = 0;
-	int16_t r = 0;
-
-	for (int i = 0; i < 16; i++) {
-		// In FPGA implementation, noise values are generated every system clock and
-		// the channel update is run sequentially. So, even if both two channels are
-		// fetching a noise value in the same sample, they should have different values
-		noise_state = (noise_state << 1) | (((noise_state >> 1) ^ (noise_state >> 2) ^ (noise_state >> 4) ^ (noise_state >> 15)) & 1);
+	return (noise[sample] >> (16 - channel)) & 0x3F;
+}
 
-		struct channel *ch = &channels[i];
+static void
+render_channel(int i, const uint32_t *noise, int16_t *wave, unsigned num_samples)
+{
+	struct channel *ch = &channels[i];
+	const uint32_t phase = ch->phase;
+	const uint32_t freq = ch->freq;
 
-		uint32_t new_phase = (ch->left || ch->right) ? ((ch->phase + ch->freq) & 0x1FFFF) : 0;
-		if ((ch->phase & 0x10000) && !(new_phase & 0x10000)) {
-			ch->noiseval = (noise_state >> 1) & 0x3F;
-		}
-		ch->phase = new_phase;
-
-		uint32_t v = 0;
-		switch (ch->waveform) {
-			case WF_PULSE: v = ((ch->phase >> 10) > ch->pw) ? 0 : 0x3F; break;
-    		case WF_SAWTOOTH: v = (ch->phase >> 11) ^ ((ch->pw ^ 0x3f) & 0x3f); break;
-			case WF_TRIANGLE: v = ((ch->phase & 0x10000) ? (~(ch->phase >> 10) & 0x3F) : ((ch->phase >> 10) & 0x3F)) ^ ((ch->pw ^ 0x3f) & 0x3f); break;		
-			case WF_NOISE: v = ch->noiseval; break;
+	if (!ch->left && !ch->right) {
+		if (phase & 0x10000) {
+			ch->noiseval = noise_value(noise, 0, i);
 		}
-		int16_t sv = (v ^ 0x20);
-		if (sv & 0x20) {
-			sv |= 0xFFC0;
-		}
-
-		int16_t val = sv * ch->volume;
+		ch->phase = 0;
+		return;
+	}
 
-		if (ch->left) {
-			l += val >> 3;
-		}
-		if (ch->right) {
-			r += val >> 3;
+	// The phase only ever goes from the upper to the lower half by wrapping
+	// around, and then picks up a new noise value
+	const int32_t volume = ch->volume;
+	const uint32_t pwx = (ch->pw ^ 0x3f) & 0x3f;
+	if (ch->waveform == WF_NOISE && volume) {
+		uint32_t p = phase;
+		uint16_t noiseval = ch->noiseval;
+		for (unsigned n = 0; n < num_samples; n++) {
+			p += freq;
+			if (p & 0x20000) {
+				p &= 0x1FFFF;
+				noiseval = noise_value(noise, n, i);
+			}
+			wave[n] = ((int32_t)noiseval - 32) * volume >> 3;
 		}
+		ch->noiseval = noiseval;
+		ch->phase = p;
+		return;
+	}
+
+	const uint32_t end = phase + num_samples * freq;
+	const uint32_t wraps = end >> 17;
+	if (wraps) {
+		unsigned last = ((wraps << 17) - phase + freq - 1) / freq - 1;
+		ch->noiseval = noise_value(noise, last, i);
+	}
+	ch->phase = end & 0x1FFFF;
+	if (!volume) {
+		return;
 	}
 
-	*left  = l;
-	*right = r;
+	// The sample value v is 6 bits, centered around 32
+	switch (ch->waveform) {
+		case WF_PULSE:
+			for (unsigned n = 0; n < num_samples; n++) {
+				uint32_t p = (phase + (n + 1) * freq) & 0x1FFFF;
+				int32_t v = ((p >> 10) > ch->pw) ? 0 : 0x3F;
+				wave[n] = (v - 32) * volume >> 3;
+			}
+			break;
+		case WF_SAWTOOTH:
+			for (unsigned n = 0; n < num_samples; n++) {
+				uint32_t p = (phase + (n + 1) * freq) & 0x1FFFF;
+				int32_t v = (p >> 11) ^ pwx;
+				wave[n] = (v - 32) * volume >> 3;
+			}
+			break;
+		case WF_TRIANGLE:
+			for (unsigned n = 0; n < num_samples; n++) {
+				uint32_t p = (phase + (n + 1) * freq) & 0x1FFFF;
+				int32_t v = ((p >> 10) & 0x3F) ^ (((p >> 16) & 1) * 0x3F) ^ pwx;
+				wave[n] = (v - 32) * volume >> 3;
+			}
+			break;
+	}
 }
 
 void
 psg_render(int16_t *buf, unsigned num_samples)
 {
-	while (num_samples--) {
-		render(&buf[0], &buf[1]);
-		buf += 2;
+	while (num_samples) {
+		const unsigned n = num_samples < BLOCK_SAMPLES ? num_samples : BLOCK_SAMPLES;
+		uint32_t noise[BLOCK_SAMPLES];
+		int16_t wave[BLOCK_SAMPLES];
+		int16_t l[BLOCK_SAMPLES] = {0};
+		int16_t r[BLOCK_SAMPLES] = {0};
+
+		for (unsigned j = 0; j < n; j++) {
+			uint16_t next = noise_step16_lo[noise_state & 0xFF] ^ noise_step16_hi[noise_state >> 8];
+			noise[j] = ((uint32_t)noise_state << 16) | next;
+			noise_state = next;
+		}
+
+		// Silent channels only need their phase and noise value brought up to date
+		for (int i = 0; i < 16; i++) {
+			const struct channel *ch = &channels[i];
+			const bool audible = (ch->left || ch->right) && ch->volume;
+			render_channel(i, noise, wave, n);
+			if (!audible) {
+				continue;
+			}
+			if (ch->left) {
+				for (unsigned j = 0; j < n; j++) {
+					l[j] += wave[j];
+				}
+			}
+			if (ch->right) {
+				for (unsigned j = 0; j < n; j++) {
+					r[j] += wave[j];
+				}
+			}
+		}
+
+		for (unsigned j = 0; j < n; j++) {
+			buf[j * 2] = l[j];
+			buf[j * 2 + 1] = r[j];
+		}
+		buf += n * 2;
+		num_samples -= n;
 	}
 }
+
+void
+psg_state(void)
+{
+	STATE_FIELD(channels);
+	STATE_FIELD(noise_state);
+}
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "sdcard.h"
+#include "state.h"
 
 #define SPI_CLOCK_RATE_MHZ 12.5f
 
@@ -79,3 +80,14 @@ vera_spi_write(uint8_t reg, uint8_t value)
 			break;
 	}
 }
+
+void
+vera_spi_state()
+{
+	STATE_FIELD(ss);
+	STATE_FIELD(busy);
+	STATE_FIELD(autotx);
+	STATE_FIELD(sending_byte);
+	STATE_FIELD(received_byte);
+	STATE_FIELD(outcounter);
+}
@@ -8,3 +8,4 @@ void vera_spi_init();
 void vera_spi_step(int mhz, int clocks);
 uint8_t vera_spi_read(uint8_t address);
 void vera_spi_write(uint8_t address, uint8_t value);
+void vera_spi_state(void);
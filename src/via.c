@@ -6,6 +6,7 @@
 #include "i2c.h"
 #include "memory.h"
 #include "serial.h"
+#include "state.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -175,7 +176,7 @@ via_step(via_t *via, unsigned clocks)
 				// special, -1 state
 				cnt = 0xffff;
 				via->timer1_m1 = true;
-				tclk_s = 1;
+				tclk_s = tclk;
 			} else {
 				reload = (((uint32_t)via->registers[7] << 8) | via->registers[6]);
 				tclk_s = cnt + reload + 2;
@@ -208,6 +209,22 @@ via_step(via_t *via, unsigned clocks)
 	via->registers[13] = ifr;
 }
 
+// number of clocks until a timer can raise an enabled interrupt
+static uint32_t
+via_next_event(via_t *via)
+{
+	uint32_t next = UINT32_MAX;
+	uint8_t ier = via->registers[14];
+	if ((ier & 0x40) && via->timer_running[0]) {
+		next = via->timer1_m1 ? 1 : via->timer_count[0] + 1;
+	}
+	if ((ier & 0x20) && via->timer_running[1] && !(via->registers[11] & 0x20)) {
+		uint32_t t2 = via->timer_count[1] + 1;
+		if (t2 < next) next = t2;
+	}
+	return next;
+}
+
 //
 // VIA#1
 //
@@ -236,7 +253,7 @@ void
 via1_init()
 {
 	via_init(&via[0]);
-	i2c_port.clk_in = 1;
+	i2c_set_lines(1, i2c_port.data_in);
 	serial_port.in.atn = 0;
 	serial_port.in.clk = 0;
 	serial_port.in.data = 0;
@@ -272,7 +289,6 @@ via1_read(uint8_t reg, bool debug)
 			
 		case 1: // PA
 		case 15:
-			i2c_step();
 			if (!debug) via_clear_pra_irqs(&via[0]);
 			if (via[0].registers[11] & 1) {
 				// CA1 is currently not connected to anything (?)
@@ -302,11 +318,10 @@ via1_write(uint8_t reg, uint8_t value)
 		serial_port.in.data = (pb & SERIAL_DATAIN_MASK) == 0;
 
 	} else if (reg == 1 || reg == 3) {
-		i2c_step();
 		// PA
 		const uint8_t pa = via[0].registers[1] | ~via[0].registers[3];
-		i2c_port.data_in = pa & I2C_DATA_MASK;										//Sets data_in = 1 if the corresponding DDR bit is 0 (input), simulates a pull-up
-		i2c_port.clk_in = (pa & I2C_CLK_MASK) >> 1;									//Sets clk_in = 1 if pin is an input, simulates a pull-up
+		i2c_set_lines((pa & I2C_CLK_MASK) >> 1,										//Sets clk_in = 1 if pin is an input, simulates a pull-up
+			pa & I2C_DATA_MASK);													//Sets data_in = 1 if the corresponding DDR bit is 0 (input), simulates a pull-up
 		joystick_set_latch(via[0].registers[1] & JOY_LATCH_MASK);
 		joystick_set_clock(via[0].registers[1] & JOY_CLK_MASK);
 	}
@@ -324,6 +339,12 @@ via1_irq()
 	return (via[0].registers[13] & via[0].registers[14]) != 0;
 }
 
+uint32_t
+via1_next_event(void)
+{
+	return via_next_event(&via[0]);
+}
+
 //
 // VIA#2
 //
@@ -360,3 +381,19 @@ via2_irq()
 {
 	return (via[1].registers[13] & via[1].registers[14]) != 0;
 }
+
+uint32_t
+via2_next_event(void)
+{
+	return via_next_event(&via[1]);
+}
+
+//
+// both VIAs
+//
+
+void
+via_state()
+{
+	STATE_FIELD(via);
+}
@@ -13,11 +13,15 @@ uint8_t via1_read(uint8_t reg, bool debug);
 void via1_write(uint8_t reg, uint8_t value);
 void via1_step(unsigned clocks);
 bool via1_irq();
+uint32_t via1_next_event(void);
 
 void via2_init();
 uint8_t via2_read(uint8_t reg, bool debug);
 void via2_write(uint8_t reg, uint8_t value);
 void via2_step(unsigned clocks);
 bool via2_irq();
+uint32_t via2_next_event(void);
+
+void via_state(void);
 
 #endif
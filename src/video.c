@@ -19,6 +19,9 @@
 #include "audio.h"
 #include "logging.h"
 #include "utils.h"
+#include "state.h"
+#include "rewind.h"
+#include "timing.h"
 
 #include <limits.h>
 #include <stdint.h>
@@ -30,6 +33,11 @@
 #include "emscripten.h"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VIDEO_SSE2
+#endif
+
 #ifndef __EMSCRIPTEN__
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
@@ -68,6 +76,13 @@
 #define TITLE_SAFE_X 0.067
 #define TITLE_SAFE_Y 0.05
 
+// The title safe area as the first pixel inside and the first one outside
+// of it again, everything else is dimmed as NTSC overscan
+#define TITLE_SAFE_LEFT   ((int)ceil(SCREEN_WIDTH * TITLE_SAFE_X))
+#define TITLE_SAFE_RIGHT  ((int)floor(SCREEN_WIDTH * (1 - TITLE_SAFE_X)) + 1)
+#define TITLE_SAFE_TOP    ((int)ceil(SCREEN_HEIGHT * TITLE_SAFE_Y))
+#define TITLE_SAFE_BOTTOM ((int)floor(SCREEN_HEIGHT * (1 - TITLE_SAFE_Y)) + 1)
+
 // visible area we're drawing
 #define SCREEN_WIDTH 640
 #define SCREEN_HEIGHT 480
@@ -96,6 +111,13 @@ bool no_keyboard_capture = false;
 bool kernal_mouse_enabled = false;
 
 static uint8_t video_ram[0x20000];
+static uint8_t video_ram_dirty[sizeof(video_ram) / STATE_PAGE_SIZE];
+
+// for -line-cache: the line cache clock at the last write to each block
+#define VRAM_BLOCK_SHIFT 9
+#define NUM_VRAM_BLOCKS (sizeof(video_ram) >> VRAM_BLOCK_SHIFT)
+static uint32_t vram_block_written[NUM_VRAM_BLOCKS];
+static uint32_t line_cache_clock = 1;
 static uint8_t palette[256 * 2];
 static uint8_t sprite_data[128][8];
 
@@ -126,6 +148,8 @@ static bool layer_line_enable[2];
 static bool old_layer_line_enable[2];
 static bool old_sprite_line_enable;
 static bool sprite_line_enable;
+static bool layer_line_empty[2] = { true, true };
+static bool sprite_line_empty = true;
 
 ////////////////////////////////////////////////////////////
 // FX registers
@@ -190,6 +214,12 @@ float ntsc_half_cnt;
 uint16_t ntsc_scan_pos_y;
 int frame_count = 0;
 
+// Without a window, only the scan position, the IRQs and the sprite
+// collisions are emulated. Lines are composed into the framebuffer only
+// while a frame capture is pending (see video_request_capture()), which
+// the MCP server requests from its own thread.
+static SDL_atomic_t capture_frames;
+
 static uint8_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT * 4];
 #ifndef __EMSCRIPTEN__
 static uint8_t png_buffer[SCREEN_WIDTH * SCREEN_HEIGHT * 3];
@@ -203,9 +233,17 @@ static const uint16_t default_palette[] = {
 };
 
 uint8_t video_space_read(uint32_t address);
-static void video_space_read_range(uint8_t* dest, uint32_t address, uint32_t size);
+static void video_space_read_range(const uint8_t *vram, uint8_t* dest, uint32_t address, uint32_t size);
 
 static void refresh_palette();
+static void render_threads_start(int count);
+static void render_threads_stop(void);
+static void render_wait(void);
+static void render_vram_reset(void);
+static void line_cache_reset(void);
+static bool present_thread_start(float screen_x_scale);
+static void present_thread_stop(void);
+static void present_frame(void);
 
 void
 mousegrab_toggle() {
@@ -298,9 +336,13 @@ video_reset()
 	refresh_palette();
 
 	// fill video RAM with random data
+	render_wait();
 	for (int i = 0; i < 128 * 1024; i++) {
 		video_ram[i] = rand();
 	}
+	memset(video_ram_dirty, 1, sizeof(video_ram_dirty));
+	render_vram_reset();
+	line_cache_reset();
 
 	sprite_line_collisions = 0;
 
@@ -327,16 +369,26 @@ video_init(int window_scale, float screen_x_scale, char *quality, bool fullscree
 
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, quality);
 	SDL_SetHint(SDL_HINT_GRAB_KEYBOARD, "1"); // Grabs keyboard shortcuts from the system during window grab
-	SDL_CreateWindowAndRenderer(SCREEN_WIDTH * window_scale * screen_x_scale, SCREEN_HEIGHT * window_scale, window_flags, &window, &renderer);
+	if (present_thread && !debugger_enabled) {
+		// the renderer is created by the presentation thread
+		window = SDL_CreateWindow(NULL, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH * window_scale * screen_x_scale, SCREEN_HEIGHT * window_scale, window_flags);
+		if (window && !present_thread_start(screen_x_scale)) {
+			renderer = SDL_CreateRenderer(window, -1, 0);
+		}
+	} else {
+		SDL_CreateWindowAndRenderer(SCREEN_WIDTH * window_scale * screen_x_scale, SCREEN_HEIGHT * window_scale, window_flags, &window, &renderer);
+	}
 #ifndef __MORPHOS__
 	SDL_SetWindowResizable(window, true);
 #endif
-	SDL_RenderSetLogicalSize(renderer, SCREEN_WIDTH * screen_x_scale, SCREEN_HEIGHT);
+	if (renderer) {
+		SDL_RenderSetLogicalSize(renderer, SCREEN_WIDTH * screen_x_scale, SCREEN_HEIGHT);
 
-	sdlTexture = SDL_CreateTexture(renderer,
-									SDL_PIXELFORMAT_RGB888,
-									SDL_TEXTUREACCESS_STREAMING,
-									SCREEN_WIDTH, SCREEN_HEIGHT);
+		sdlTexture = SDL_CreateTexture(renderer,
+										SDL_PIXELFORMAT_RGB888,
+										SDL_TEXTUREACCESS_STREAMING,
+										SCREEN_WIDTH, SCREEN_HEIGHT);
+	}
 
 	SDL_SetWindowTitle(window, WINDOW_TITLE);
 	SDL_SetWindowIcon(window, CommanderX16Icon());
@@ -382,6 +434,10 @@ video_init(int window_scale, float screen_x_scale, char *quality, bool fullscree
 	if (grab_mouse && !mouse_grabbed)
 		mousegrab_toggle();
 
+	if (render_threads && !enable_midline) {
+		render_threads_start(render_threads);
+	}
+
 	return true;
 }
 
@@ -560,6 +616,8 @@ struct video_sprite_properties
 bool
 video_take_screenshot(void)
 {
+	render_wait();
+
 	char base_path[PATH_MAX];
 	char full_dir_path[PATH_MAX];
 	char date_dir[PATH_MAX];
@@ -646,11 +704,45 @@ get_last_screenshot_filename(void)
 
 struct video_sprite_properties sprite_properties[128];
 
+// For every line a sprite can be rendered on, the visible sprites that
+// intersect it, in priority order. Kept up to date by
+// refresh_sprite_properties(), so render_sprite_line() does not have to
+// look at all sprites.
+#define SPRITE_INDEX_LINES (SCREEN_HEIGHT + 1)
+static uint8_t sprite_line_list[SPRITE_INDEX_LINES][NUM_SPRITES];
+static uint8_t sprite_line_count[SPRITE_INDEX_LINES];
+
+static void
+sprite_index_update(const uint8_t sprite, const int16_t sprite_y, const uint8_t sprite_height, const bool add)
+{
+	const int first = sprite_y > 0 ? sprite_y : 0;
+	const int end = sprite_y + sprite_height < SPRITE_INDEX_LINES ? sprite_y + sprite_height : SPRITE_INDEX_LINES;
+	for (int y = first; y < end; y++) {
+		uint8_t *list = sprite_line_list[y];
+		int n = 0;
+		while (n < sprite_line_count[y] && list[n] < sprite) {
+			n++;
+		}
+		if (add) {
+			memmove(&list[n + 1], &list[n], sprite_line_count[y] - n);
+			list[n] = sprite;
+			sprite_line_count[y]++;
+		} else {
+			memmove(&list[n], &list[n + 1], sprite_line_count[y] - n - 1);
+			sprite_line_count[y]--;
+		}
+	}
+}
+
 static void
 refresh_sprite_properties(const uint16_t sprite)
 {
 	struct video_sprite_properties* props = &sprite_properties[sprite];
 
+	const int8_t old_zdepth = props->sprite_zdepth;
+	const int16_t old_y = props->sprite_y;
+	const uint8_t old_height = props->sprite_height;
+
 	props->sprite_zdepth = (sprite_data[sprite][6] >> 2) & 3;
 	props->sprite_collision_mask = sprite_data[sprite][6] & 0xf0;
 
@@ -676,6 +768,15 @@ refresh_sprite_properties(const uint16_t sprite)
 	props->sprite_address = sprite_data[sprite][0] << 5 | (sprite_data[sprite][1] & 0xf) << 13;
 
 	props->palette_offset = (sprite_data[sprite][7] & 0x0f) << 4;
+
+	if (props->sprite_zdepth != old_zdepth || props->sprite_y != old_y || props->sprite_height != old_height) {
+		if (old_zdepth != 0) {
+			sprite_index_update(sprite, old_y, old_height, false);
+		}
+		if (props->sprite_zdepth != 0) {
+			sprite_index_update(sprite, props->sprite_y, props->sprite_height, true);
+		}
+	}
 }
 
 struct video_palette
@@ -685,9 +786,12 @@ struct video_palette
 };
 
 struct video_palette video_palette;
+static uint32_t palette_version;
 
 static void
 refresh_palette() {
+	render_wait();
+
 	const uint8_t out_mode = reg_composer[0] & 3;
 	const bool chroma_disable = ((reg_composer[0] & 0x07) == 6);
 	for (int i = 0; i < 256; ++i) {
@@ -713,6 +817,7 @@ refresh_palette() {
 		video_palette.entries[i] = (uint32_t)(r << 16) | ((uint32_t)g << 8) | ((uint32_t)b);
 	}
 	video_palette.dirty = false;
+	palette_version++;
 }
 
 static void
@@ -735,22 +840,21 @@ render_sprite_line(const uint16_t y)
 	memset(sprite_line_col, 0, SCREEN_WIDTH);
 	memset(sprite_line_z, 0, SCREEN_WIDTH);
 	memset(sprite_line_mask, 0, SCREEN_WIDTH);
+	sprite_line_empty = true;
 
 	uint16_t sprite_budget = 800 + 1;
-	for (int i = 0; i < NUM_SPRITES; i++) {
-		// one clock per lookup
-		sprite_budget--; if (sprite_budget == 0) break;
+	int prev_i = -1;
+	for (int n = 0; n < sprite_line_count[y]; n++) {
+		const int i = sprite_line_list[y][n];
+
+		// one clock per lookup, including the skipped sprites, each of
+		// which could end the line when the budget drops to exactly 0
+		const uint16_t lookups = i - prev_i;
+		prev_i = i;
+		if (sprite_budget != 0 && sprite_budget <= lookups) break;
+		sprite_budget -= lookups;
 		const struct video_sprite_properties *props = &sprite_properties[i];
 
-		if (props->sprite_zdepth == 0) {
-			continue;
-		}
-
-		// check whether this line falls within the sprite
-		if (y < props->sprite_y || y >= props->sprite_y + props->sprite_height) {
-			continue;
-		}
-
 		const uint16_t eff_sy = props->vflip ? ((props->sprite_height - 1) - (y - props->sprite_y)) : (y - props->sprite_y);
 
 		int16_t       eff_sx      = (props->hflip ? (props->sprite_width - 1) : 0);
@@ -798,42 +902,181 @@ render_sprite_line(const uint16_t y)
 					}
 					sprite_line_col[line_x] = col_index;
 					sprite_line_z[line_x] = props->sprite_zdepth;
+					sprite_line_empty = false;
 				}
 			}
 		}
 	}
 }
 
+////////////////////////////////////////////////////////////
+// Pixel kernels for the layer renderers
+////////////////////////////////////////////////////////////
+
+// Unpacks pixels of the given color depth (0-3) into one color index per
+// byte, most significant bits first
 static void
-render_layer_line_text(uint8_t layer, uint16_t y)
+expand_pixels(uint8_t *dst, const uint8_t *src, int bytes, uint8_t color_depth)
 {
-	const struct video_layer_properties *props = &prev_layer_properties[1][layer];
-	const struct video_layer_properties *props0 = &prev_layer_properties[0][layer];
+	int i = 0;
+#ifdef VIDEO_SSE2
+	// 16 pixels per step
+	switch (color_depth) {
+		case 0: {
+			const __m128i bits = _mm_setr_epi8(
+				(char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+				(char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+			for (; i + 2 <= bytes; i += 2) {
+				__m128i v = _mm_cvtsi32_si128(src[i] | src[i + 1] << 8);
+				v = _mm_unpacklo_epi8(v, v);
+				v = _mm_unpacklo_epi16(v, v);
+				v = _mm_unpacklo_epi32(v, v);
+				v = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+				_mm_storeu_si128((__m128i *)dst, _mm_and_si128(v, _mm_set1_epi8(1)));
+				dst += 16;
+			}
+			break;
+		}
+		case 1:
+			for (; i + 4 <= bytes; i += 4) {
+				uint32_t word;
+				memcpy(&word, src + i, 4);
+				const __m128i v = _mm_cvtsi32_si128(word);
+				const __m128i mask = _mm_set1_epi8(3);
+				const __m128i p0 = _mm_and_si128(_mm_srli_epi16(v, 6), mask);
+				const __m128i p1 = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+				const __m128i p2 = _mm_and_si128(_mm_srli_epi16(v, 2), mask);
+				const __m128i p3 = _mm_and_si128(v, mask);
+				const __m128i p01 = _mm_unpacklo_epi8(p0, p1);
+				const __m128i p23 = _mm_unpacklo_epi8(p2, p3);
+				_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(p01, p23));
+				dst += 16;
+			}
+			break;
+		case 2:
+			for (; i + 8 <= bytes; i += 8) {
+				const __m128i v = _mm_loadl_epi64((const __m128i *)(src + i));
+				const __m128i mask = _mm_set1_epi8(0x0f);
+				const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+				const __m128i lo = _mm_and_si128(v, mask);
+				_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(hi, lo));
+				dst += 16;
+			}
+			break;
+	}
+#endif
+	if (color_depth == 3) {
+		memcpy(dst, src + i, bytes - i);
+		return;
+	}
+	const uint8_t bits_per_pixel = 1 << color_depth;
+	const uint8_t mask = (1 << bits_per_pixel) - 1;
+	for (; i < bytes; i++) {
+		for (int shift = 8 - bits_per_pixel; shift >= 0; shift -= bits_per_pixel) {
+			*dst++ = (src[i] >> shift) & mask;
+		}
+	}
+}
 
-	const uint8_t max_pixels_per_byte = (8 >> props->color_depth) - 1;
+// Applies a palette offset (and the T256C flag) to the color indices
+// 1-15. Their upper bits are clear, so adding the offset is an OR.
+static void
+apply_palette_offset(uint8_t *pixels, int count, uint8_t bits)
+{
+	if (!bits) {
+		return;
+	}
+	int i = 0;
+#ifdef VIDEO_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i high = _mm_set1_epi8((char)0xf0);
+	const __m128i add = _mm_set1_epi8((char)bits);
+	for (; i + 16 <= count; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(pixels + i));
+		const __m128i low = _mm_cmpeq_epi8(_mm_and_si128(v, high), zero);
+		const __m128i mask = _mm_andnot_si128(_mm_cmpeq_epi8(v, zero), low);
+		_mm_storeu_si128((__m128i *)(pixels + i), _mm_or_si128(v, _mm_and_si128(mask, add)));
+	}
+#endif
+	for (; i < count; i++) {
+		if (pixels[i] > 0 && pixels[i] < 16) {
+			pixels[i] |= bits;
+		}
+	}
+}
+
+// Turns the 0/1 pixels of a text character into its colors
+static void
+apply_text_colors(uint8_t *pixels, int count, uint8_t fg_color, uint8_t bg_color)
+{
+	int i = 0;
+#ifdef VIDEO_SSE2
+	const __m128i fg = _mm_set1_epi8((char)fg_color);
+	const __m128i bg = _mm_set1_epi8((char)bg_color);
+	for (; i + 16 <= count; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(pixels + i));
+		const __m128i is_bg = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+		_mm_storeu_si128((__m128i *)(pixels + i), _mm_or_si128(_mm_and_si128(is_bg, bg), _mm_andnot_si128(is_bg, fg)));
+	}
+#endif
+	for (; i < count; i++) {
+		pixels[i] = pixels[i] ? fg_color : bg_color;
+	}
+}
+
+static void
+reverse_pixels(uint8_t *pixels, int count)
+{
+#ifdef VIDEO_SSE2
+	if (count == 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)pixels);
+		v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i *)pixels, v);
+		return;
+	}
+#endif
+	for (int i = 0; i < count / 2; i++) {
+		const uint8_t tmp = pixels[i];
+		pixels[i] = pixels[count - 1 - i];
+		pixels[count - 1 - i] = tmp;
+	}
+}
+
+// The layer renderers below work one tile row at a time: the row is
+// unpacked into color indices with the kernels above, and the part of it
+// that is visible is copied into the line.
+
+#define MAX_TILE_WIDTH 16
+
+static void
+render_layer_line_text(const uint8_t *vram, const struct video_layer_properties *props, const struct video_layer_properties *props0, uint8_t *line, uint16_t y)
+{
 	const int     eff_y               = calc_layer_eff_y(props0, y);
 	const int     yy                  = eff_y & props->tileh_max;
 
 	// additional bytes to reach the correct line of the tile
 	const uint32_t y_add = (yy << props->tilew_log2) >> 3;
+	const int      tilew = SDL_min(props->tilew, MAX_TILE_WIDTH);
+	const uint16_t row_bytes = tilew >> 3;
 
 	const uint32_t map_addr_begin = calc_layer_map_addr_base2(props, props->min_eff_x, eff_y);
 	const uint32_t map_addr_end   = calc_layer_map_addr_base2(props, props->max_eff_x, eff_y);
 	const int      size           = (map_addr_end - map_addr_begin) + 2;
 
 	uint8_t tile_bytes[512]; // max 256 tiles, 2 bytes each.
-	video_space_read_range(tile_bytes, map_addr_begin, size);
+	video_space_read_range(vram, tile_bytes, map_addr_begin, size);
 
-	uint32_t tile_start;
+	uint8_t row[MAX_TILE_WIDTH / 8];
+	uint8_t pixels[MAX_TILE_WIDTH];
 
-	uint8_t  fg_color;
-	uint8_t  bg_color;
-	uint8_t  s;
-	uint8_t  color_shift;
-
-	{
-		const int eff_x = calc_layer_eff_x(props, 0);
-		const int xx    = eff_x & props->tilew_max;
+	// Render tile line.
+	for (int x = 0; x < SCREEN_WIDTH;) {
+		// Scrolling
+		const int eff_x = calc_layer_eff_x(props, x);
+		const int xx = eff_x & props->tilew_max;
 
 		// extract all information from the map
 		const uint32_t map_addr = calc_layer_map_addr_base2(props, eff_x, eff_y) - map_addr_begin;
@@ -841,6 +1084,8 @@ render_layer_line_text(uint8_t layer, uint16_t y)
 		const uint8_t tile_index = tile_bytes[map_addr];
 		const uint8_t byte1      = tile_bytes[map_addr + 1];
 
+		uint8_t fg_color;
+		uint8_t bg_color;
 		if (!props->text_mode_256c) {
 			fg_color = byte1 & 15;
 			bg_color = byte1 >> 4;
@@ -850,54 +1095,15 @@ render_layer_line_text(uint8_t layer, uint16_t y)
 		}
 
 		// offset within tilemap of the current tile
-		tile_start = tile_index << props->tile_size_log2;
+		const uint32_t tile_start = tile_index << props->tile_size_log2;
 
-		// additional bytes to reach the correct column of the tile
-		const uint16_t x_add       = xx >> 3;
-		const uint32_t tile_offset = tile_start + y_add + x_add;
+		video_space_read_range(vram, row, (props->tile_base + tile_start + y_add) & 0x1FFFF, row_bytes);
+		expand_pixels(pixels, row, row_bytes, 0);
+		apply_text_colors(pixels, tilew, fg_color, bg_color);
 
-		s           = video_space_read(props->tile_base + tile_offset);
-		color_shift = max_pixels_per_byte - (xx & 0x7);
-	}
-
-	// Render tile line.
-	for (int x = 0; x < SCREEN_WIDTH; x++) {
-		// Scrolling
-		const int eff_x = calc_layer_eff_x(props, x);
-		const int xx = eff_x & props->tilew_max;
-
-		if ((eff_x & 0x7) == 0) {
-			if ((eff_x & props->tilew_max) == 0) {
-				// extract all information from the map
-				const uint32_t map_addr = calc_layer_map_addr_base2(props, eff_x, eff_y) - map_addr_begin;
-
-				const uint8_t tile_index = tile_bytes[map_addr];
-				const uint8_t byte1      = tile_bytes[map_addr + 1];
-
-				if (!props->text_mode_256c) {
-					fg_color = byte1 & 15;
-					bg_color = byte1 >> 4;
-				} else {
-					fg_color = byte1;
-					bg_color = 0;
-				}
-
-				// offset within tilemap of the current tile
-				tile_start = tile_index << props->tile_size_log2;
-			}
-
-			// additional bytes to reach the correct column of the tile
-			const uint16_t x_add       = xx >> 3;
-			const uint32_t tile_offset = tile_start + y_add + x_add;
-
-			s           = video_space_read(props->tile_base + tile_offset);
-			color_shift = max_pixels_per_byte;
-		}
-
-		// convert tile byte to indexed color
-		const uint8_t col_index = (s >> color_shift) & 1;
-		--color_shift;
-		layer_line[layer][x] = col_index ? fg_color : bg_color;
+		const int count = SDL_min(tilew - xx, SCREEN_WIDTH - x);
+		memcpy(line + x, pixels + xx, count);
+		x += count;
 	}
 }
 
@@ -971,10 +1177,14 @@ capture_text_buffer(uint8_t *buffer, size_t buf_size, int32_t layer, uint32_t *o
 }
 
 static void
-render_layer_line_tile(uint8_t layer, uint16_t y)
+render_layer_line_tile(const uint8_t *vram, const struct video_layer_properties *props, const struct video_layer_properties *props0, uint8_t *line, uint16_t y)
 {
-	const struct video_layer_properties *props = &prev_layer_properties[1][layer];
-	const struct video_layer_properties *props0 = &prev_layer_properties[0][layer];
+	if (!props->tilew) {
+		// the layer registers were never written, so every pixel is
+		// masked to color 0
+		memset(line, 0, SCREEN_WIDTH);
+		return;
+	}
 
 	const uint8_t max_pixels_per_byte = (8 >> props->color_depth) - 1;
 	const int     eff_y               = calc_layer_eff_y(props0, y);
@@ -982,22 +1192,21 @@ render_layer_line_tile(uint8_t layer, uint16_t y)
 	const uint8_t yy_flip             = yy ^ props->tileh_max;
 	const uint32_t y_add              = (yy << ((props->tilew_log2 + props->color_depth - 3) & 31));
 	const uint32_t y_add_flip         = (yy_flip << ((props->tilew_log2 + props->color_depth - 3) & 31));
+	const int      tilew              = SDL_min(props->tilew, MAX_TILE_WIDTH);
+	const uint16_t row_bytes          = (tilew << props->color_depth) >> 3;
+	const uint8_t  t256c              = props->text_mode_256c ? 0x80 : 0;
 
 	const uint32_t map_addr_begin = calc_layer_map_addr_base2(props, props->min_eff_x, eff_y);
 	const uint32_t map_addr_end   = calc_layer_map_addr_base2(props, props->max_eff_x, eff_y);
 	const int      size           = (map_addr_end - map_addr_begin) + 2;
 
 	uint8_t tile_bytes[512]; // max 256 tiles, 2 bytes each.
-	video_space_read_range(tile_bytes, map_addr_begin, size);
+	video_space_read_range(vram, tile_bytes, map_addr_begin, size);
 
-	uint8_t  palette_offset;
-	bool     vflip;
-	bool     hflip;
-	uint32_t tile_start;
-	uint8_t  s;
-	uint8_t  color_shift;
-	int8_t   color_shift_incr;
+	int x = 0;
 
+	// When the line does not start on a byte boundary, the pixels up to the
+	// next one are taken from the start of the first byte.
 	{
 		const int eff_x = calc_layer_eff_x(props, 0);
 
@@ -1008,18 +1217,19 @@ render_layer_line_tile(uint8_t layer, uint16_t y)
 		const uint8_t byte1 = tile_bytes[map_addr + 1];
 
 		// Tile Flipping
-		vflip = (byte1 >> 3) & 1;
-		hflip = (byte1 >> 2) & 1;
+		const bool vflip = (byte1 >> 3) & 1;
+		const bool hflip = (byte1 >> 2) & 1;
 
-		palette_offset = byte1 & 0xf0;
+		const uint8_t palette_offset = byte1 & 0xf0;
 
 		// offset within tilemap of the current tile
 		const uint16_t tile_index = byte0 | ((byte1 & 3) << 8);
-		tile_start                = tile_index << props->tile_size_log2;
+		const uint32_t tile_start = tile_index << props->tile_size_log2;
 
-		color_shift_incr = hflip ? props->bits_per_pixel : -props->bits_per_pixel;
+		const int8_t color_shift_incr = hflip ? props->bits_per_pixel : -props->bits_per_pixel;
 
 		int xx = eff_x & props->tilew_max;
+		uint8_t color_shift;
 		if (hflip) {
 			xx          = xx ^ (props->tilew_max);
 			color_shift = 0;
@@ -1028,102 +1238,79 @@ render_layer_line_tile(uint8_t layer, uint16_t y)
 		}
 
 		// additional bytes to reach the correct column of the tile
-		uint16_t x_add       = (xx << props->color_depth) >> 3;
-		uint32_t tile_offset = tile_start + (vflip ? y_add_flip : y_add) + x_add;
+		const uint16_t x_add       = (xx << props->color_depth) >> 3;
+		const uint32_t tile_offset = tile_start + (vflip ? y_add_flip : y_add) + x_add;
+
+		const uint8_t s = vram[(props->tile_base + tile_offset) & 0x1FFFF];
+
+		const int head = (-eff_x) & max_pixels_per_byte;
+		for (; x < head; x++) {
+			// convert tile byte to indexed color
+			uint8_t col_index = (s >> color_shift) & props->color_mask;
+			color_shift += color_shift_incr;
 
-		s = video_space_read(props->tile_base + tile_offset);
+			// Apply Palette Offset
+			if (col_index > 0 && col_index < 16) {
+				col_index += palette_offset;
+				col_index |= t256c;
+			}
+			line[x] = col_index;
+		}
 	}
 
+	uint8_t row[MAX_TILE_WIDTH];
+	uint8_t pixels[MAX_TILE_WIDTH];
 
 	// Render tile line.
-	for (int x = 0; x < SCREEN_WIDTH; x++) {
+	while (x < SCREEN_WIDTH) {
 		const int eff_x = calc_layer_eff_x(props, x);
+		const int xx = eff_x & props->tilew_max;
 
-		if ((eff_x & max_pixels_per_byte) == 0) {
-			if ((eff_x & props->tilew_max) == 0) {
-				// extract all information from the map
-				const uint32_t map_addr = calc_layer_map_addr_base2(props, eff_x, eff_y) - map_addr_begin;
-
-				const uint8_t byte0 = tile_bytes[map_addr];
-				const uint8_t byte1 = tile_bytes[map_addr + 1];
-
-				// Tile Flipping
-				vflip = (byte1 >> 3) & 1;
-				hflip = (byte1 >> 2) & 1;
-
-				palette_offset = byte1 & 0xf0;
+		// extract all information from the map
+		const uint32_t map_addr = calc_layer_map_addr_base2(props, eff_x, eff_y) - map_addr_begin;
 
-				// offset within tilemap of the current tile
-				const uint16_t tile_index = byte0 | ((byte1 & 3) << 8);
-				tile_start                = tile_index << props->tile_size_log2;
+		const uint8_t byte0 = tile_bytes[map_addr];
+		const uint8_t byte1 = tile_bytes[map_addr + 1];
 
-				color_shift_incr = hflip ? props->bits_per_pixel : -props->bits_per_pixel;
-			}
+		// Tile Flipping
+		const bool vflip = (byte1 >> 3) & 1;
+		const bool hflip = (byte1 >> 2) & 1;
 
-			int xx = eff_x & props->tilew_max;
-			if (hflip) {
-				xx = xx ^ (props->tilew_max);
-				color_shift = 0;
-			} else {
-				color_shift = props->first_color_pos;
-			}
+		const uint8_t palette_offset = byte1 & 0xf0;
 
-			// additional bytes to reach the correct column of the tile
-			const uint16_t x_add       = (xx << props->color_depth) >> 3;
-			const uint32_t tile_offset = tile_start + (vflip ? y_add_flip : y_add) + x_add;
+		// offset within tilemap of the current tile
+		const uint16_t tile_index = byte0 | ((byte1 & 3) << 8);
+		const uint32_t tile_start = tile_index << props->tile_size_log2;
 
-			s = video_space_read(props->tile_base + tile_offset);
+		video_space_read_range(vram, row, (props->tile_base + tile_start + (vflip ? y_add_flip : y_add)) & 0x1FFFF, row_bytes);
+		expand_pixels(pixels, row, row_bytes, props->color_depth);
+		apply_palette_offset(pixels, tilew, palette_offset | t256c);
+		if (hflip) {
+			reverse_pixels(pixels, tilew);
 		}
 
-		// convert tile byte to indexed color
-		uint8_t col_index = (s >> color_shift) & props->color_mask;
-		color_shift += color_shift_incr;
-
-		// Apply Palette Offset
-		if (col_index > 0 && col_index < 16) {
-			col_index += palette_offset;
-			if (props->text_mode_256c) {
-				col_index |= 0x80;
-			}
-		}
-		layer_line[layer][x] = col_index;
+		const int count = SDL_min(tilew - xx, SCREEN_WIDTH - x);
+		memcpy(line + x, pixels + xx, count);
+		x += count;
 	}
 }
 
-
 static void
-render_layer_line_bitmap(uint8_t layer, uint16_t y)
+render_layer_line_bitmap(const uint8_t *vram, const struct video_layer_properties *props, uint8_t palette_offset, uint8_t *line, uint16_t y)
 {
-	const struct video_layer_properties *props = &prev_layer_properties[1][layer];
-//	const struct video_layer_properties *props0 = &prev_layer_properties[0][layer];
-
 	int yy = y % props->tileh;
 	// additional bytes to reach the correct line of the tile
 	uint32_t y_add = (yy * props->tilew * props->bits_per_pixel) >> 3;
+	const uint16_t row_bytes = (props->tilew * props->bits_per_pixel) >> 3;
 
-	// Render tile line.
-	for (int x = 0; x < SCREEN_WIDTH; x++) {
-		int xx = x % props->tilew;
-
-		// extract all information from the map
-		uint8_t palette_offset = reg_layer[layer][4] & 0xf;
+	uint8_t row[SCREEN_WIDTH];
+	video_space_read_range(vram, row, (props->tile_base + y_add) & 0x1FFFF, row_bytes);
+	expand_pixels(line, row, row_bytes, props->color_depth);
+	apply_palette_offset(line, props->tilew, (palette_offset << 4) | (props->text_mode_256c ? 0x80 : 0));
 
-		// additional bytes to reach the correct column of the tile
-		uint16_t x_add = (xx * props->bits_per_pixel) >> 3;
-		uint32_t tile_offset = y_add + x_add;
-		uint8_t s = video_space_read(props->tile_base + tile_offset);
-
-		// convert tile byte to indexed color
-		uint8_t col_index = (s >> (props->first_color_pos - ((xx & props->color_fields_max) << props->color_depth))) & props->color_mask;
-
-		// Apply Palette Offset
-		if (col_index > 0 && col_index < 16) {
-			col_index += palette_offset << 4;
-			if (props->text_mode_256c) {
-				col_index |= 0x80;
-			}
-		}
-		layer_line[layer][x] = col_index;
+	// a 320 pixel wide bitmap repeats
+	for (int x = props->tilew; x < SCREEN_WIDTH; x += props->tilew) {
+		memcpy(line + x, line, SDL_min(props->tilew, SCREEN_WIDTH - x));
 	}
 }
 
@@ -1147,6 +1334,535 @@ static uint8_t calculate_line_col_index(uint8_t spr_zindex, uint8_t spr_col_inde
 	return col_index;
 }
 
+static void
+render_layer_line(const uint8_t *vram, const struct video_layer_properties *props, const struct video_layer_properties *props0, uint8_t bitmap_palette_offset, uint8_t *line, uint16_t y)
+{
+	if (props->text_mode) {
+		render_layer_line_text(vram, props, props0, line, y);
+	} else if (props->bitmap_mode) {
+		render_layer_line_bitmap(vram, props, bitmap_palette_offset, line, y);
+	} else {
+		render_layer_line_tile(vram, props, props0, line, y);
+	}
+}
+
+// Resolves the priority of the sprite and layer pixels from begin to end,
+// like calculate_line_col_index()
+static void
+compose_pixels(uint8_t *dst, int begin, int end, const uint8_t *spr_col, const uint8_t *spr_z, const uint8_t *l1, const uint8_t *l2)
+{
+	int x = begin;
+#ifdef VIDEO_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	// the first of two colors that is not 0
+#define FIRST_COLOR(a, b) _mm_or_si128(a, _mm_and_si128(_mm_cmpeq_epi8(a, zero), b))
+	for (; x + 16 <= end; x += 16) {
+		const __m128i z = _mm_loadu_si128((const __m128i *)(spr_z + x));
+		const __m128i spr = _mm_loadu_si128((const __m128i *)(spr_col + x));
+		const __m128i c1 = _mm_loadu_si128((const __m128i *)(l1 + x));
+		const __m128i c2 = _mm_loadu_si128((const __m128i *)(l2 + x));
+
+		const __m128i col0 = FIRST_COLOR(c2, c1);
+		const __m128i col1 = FIRST_COLOR(c2, FIRST_COLOR(c1, spr));
+		const __m128i col2 = FIRST_COLOR(c2, FIRST_COLOR(spr, c1));
+		const __m128i col3 = FIRST_COLOR(spr, col0);
+
+		__m128i col = _mm_and_si128(_mm_cmpeq_epi8(z, zero), col0);
+		col = _mm_or_si128(col, _mm_and_si128(_mm_cmpeq_epi8(z, _mm_set1_epi8(1)), col1));
+		col = _mm_or_si128(col, _mm_and_si128(_mm_cmpeq_epi8(z, _mm_set1_epi8(2)), col2));
+		col = _mm_or_si128(col, _mm_and_si128(_mm_cmpeq_epi8(z, _mm_set1_epi8(3)), col3));
+		_mm_storeu_si128((__m128i *)(dst + x), col);
+	}
+#undef FIRST_COLOR
+#endif
+	for (; x < end; x++) {
+		dst[x] = calculate_line_col_index(spr_z[x], spr_col[x], l1[x], l2[x]);
+	}
+}
+
+// Divides the RGB elements by 4
+static void
+dim_pixels(uint32_t *pixels, int count)
+{
+	int i = 0;
+#ifdef VIDEO_SSE2
+	const __m128i mask = _mm_set1_epi32(0x00fcfcfc);
+	for (; i + 4 <= count; i += 4) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(pixels + i));
+		_mm_storeu_si128((__m128i *)(pixels + i), _mm_srli_epi32(_mm_and_si128(v, mask), 2));
+	}
+#endif
+	for (; i < count; i++) {
+		pixels[i] = (pixels[i] & 0x00fcfcfc) >> 2;
+	}
+}
+
+// Composes the pixels from x_begin to x_end of a line out of the layer
+// and sprite lines and writes them into the framebuffer
+static void
+compose_line(const uint8_t *composer, uint16_t y, uint16_t x_begin, uint16_t x_end, uint32_t *eff_x_fp, const uint8_t *spr_col, const uint8_t *spr_z, uint8_t layers[NUM_LAYERS][SCREEN_WIDTH], uint8_t *col_line)
+{
+	uint8_t out_mode = composer[0] & 3;
+
+	uint8_t border_color = composer[3];
+	uint16_t hstart = composer[4] << 2;
+	uint16_t hstop = composer[5] << 2;
+	uint16_t vstart = composer[6] << 1;
+	uint16_t vstop = composer[7] << 1;
+
+	// If video output is enabled, calculate color indices for line.
+	if (out_mode != 0) {
+		// Add border after if required.
+		if (y < vstart || y >= vstop) {
+			uint32_t border_fill = border_color;
+			border_fill = border_fill | (border_fill << 8);
+			border_fill = border_fill | (border_fill << 16);
+			memset(col_line, border_fill, SCREEN_WIDTH);
+		} else {
+			hstart = hstart < 640 ? hstart : 640;
+			hstop = hstop < 640 ? hstop : 640;
+
+			for (uint16_t x = x_begin; x < hstart && x < x_end; ++x) {
+				col_line[x] = border_color;
+			}
+
+			const uint32_t scale = composer[1];
+			const uint16_t begin = MAX(hstart, x_begin);
+			const uint16_t end = hstop < x_end ? hstop : x_end;
+			if (begin < end) {
+				// the pixels the (possibly scaled) span is taken from
+				const uint32_t step = scale << 9;
+				const uint32_t first = *eff_x_fp >> 16;
+				const uint32_t last = (*eff_x_fp + (end - begin - 1) * step) >> 16;
+
+				uint8_t composed[SCREEN_WIDTH];
+				if (first < SCREEN_WIDTH) {
+					compose_pixels(composed, first, last < SCREEN_WIDTH ? last + 1 : SCREEN_WIDTH, spr_col, spr_z, layers[0], layers[1]);
+				}
+
+				if (step == 1 << 16) {
+					uint16_t x = begin;
+					if (first < SCREEN_WIDTH) {
+						const int count = SDL_min(end - begin, SCREEN_WIDTH - (int)first);
+						memcpy(col_line + x, composed + first, count);
+						x += count;
+					}
+					memset(col_line + x, 0, end - x);
+					*eff_x_fp += (end - begin) << 16;
+				} else {
+					for (uint16_t x = begin; x < end; ++x) {
+						uint16_t eff_x = *eff_x_fp >> 16;
+						col_line[x] = (eff_x < SCREEN_WIDTH) ? composed[eff_x] : 0;
+						*eff_x_fp += step;
+					}
+				}
+			}
+			for (uint16_t x = hstop; x < x_end; ++x) {
+				col_line[x] = border_color;
+			}
+		}
+	}
+
+	// Look up all color indices.
+	uint32_t* framebuffer4 = ((uint32_t*)framebuffer) + (y * SCREEN_WIDTH);
+	for (uint16_t x = x_begin; x < x_end; x++) {
+		framebuffer4[x] = video_palette.entries[col_line[x]];
+	}
+
+	// NTSC overscan
+	if (out_mode == 2 && x_begin < x_end) {
+		if (y < TITLE_SAFE_TOP || y >= TITLE_SAFE_BOTTOM) {
+			dim_pixels(framebuffer4 + x_begin, x_end - x_begin);
+		} else {
+			if (x_begin < TITLE_SAFE_LEFT) {
+				dim_pixels(framebuffer4 + x_begin, SDL_min(x_end, TITLE_SAFE_LEFT) - x_begin);
+			}
+			if (x_end > TITLE_SAFE_RIGHT) {
+				const int x = SDL_max(x_begin, TITLE_SAFE_RIGHT);
+				dim_pixels(framebuffer4 + x, x_end - x);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Parallel scanline rendering (-render-threads)
+////////////////////////////////////////////////////////////
+
+// Without mid-line effects, a line that is rendered in one go only
+// depends on the registers at its start and on the contents of video RAM
+// and the palette. The emulation thread still renders the sprites, which
+// feed the collision IRQ, and hands everything else to the render
+// threads together with a copy of the registers. Palette changes wait
+// until the queued lines are done.
+//
+// Video RAM writes don't wait: the render threads read their own copy,
+// render_vram, and the emulation thread only notes which pages it wrote.
+// When it queues the next line, it copies those pages into a log and
+// attaches them to the job. The thread that takes the job waits for all
+// earlier lines to finish and applies the log before rendering it, so
+// every line sees video RAM exactly as it was when it was queued.
+
+#define RENDER_QUEUE_SIZE 64
+#define RENDER_PAGE_SHIFT 8
+#define RENDER_PAGE_SIZE (1 << RENDER_PAGE_SHIFT)
+#define RENDER_PAGES (sizeof(video_ram) / RENDER_PAGE_SIZE)
+
+struct render_job {
+	uint16_t y;
+	uint16_t eff_y;
+	uint8_t composer[8];
+	uint8_t bitmap_palette_offset[NUM_LAYERS];
+	struct video_layer_properties props[2][NUM_LAYERS];
+	uint8_t layer_line[NUM_LAYERS][SCREEN_WIDTH];
+	uint8_t sprite_col[SCREEN_WIDTH];
+	uint8_t sprite_z[SCREEN_WIDTH];
+	uint32_t log_begin; // video RAM pages to apply before rendering
+	uint32_t log_end;
+	bool busy;
+};
+
+static struct render_job render_queue[RENDER_QUEUE_SIZE];
+static SDL_Thread *render_thread_handles[MAX_RENDER_THREADS];
+static int num_render_threads;
+static SDL_mutex *render_mutex;
+static SDL_cond *render_work;  // signaled when a line has been queued
+static SDL_cond *render_done;  // signaled when a line has been rendered
+static uint32_t render_queued;
+static uint32_t render_taken;
+static uint32_t render_finished;
+static bool render_quit;
+static bool render_threads_running;
+static bool render_pending; // only touched by the emulation thread
+static bool render_syncing; // a thread is applying a job's log
+
+static uint8_t render_vram[sizeof(video_ram)];
+static uint8_t render_log[RENDER_PAGES][RENDER_PAGE_SIZE];
+static uint16_t render_log_page[RENDER_PAGES];
+static uint32_t render_log_head; // only touched by the emulation thread
+static uint32_t render_log_tail;
+static uint16_t render_dirty_pages[RENDER_PAGES];
+static bool render_page_dirty[RENDER_PAGES];
+static int render_num_dirty;
+
+static void
+render_job_line(struct render_job *job, uint8_t *col_line)
+{
+	for (uint8_t layer = 0; layer < NUM_LAYERS; layer++) {
+		if (job->composer[0] & (0x10 << layer)) {
+			render_layer_line(render_vram, &job->props[1][layer], &job->props[0][layer], job->bitmap_palette_offset[layer], job->layer_line[layer], job->eff_y);
+		}
+	}
+
+	uint32_t eff_x_fp = 0;
+	compose_line(job->composer, job->y, 0, SCREEN_WIDTH, &eff_x_fp, job->sprite_col, job->sprite_z, job->layer_line, col_line);
+}
+
+static int
+render_thread(void *data)
+{
+	uint8_t col_line[SCREEN_WIDTH];
+	memset(col_line, 0, sizeof(col_line));
+
+	SDL_LockMutex(render_mutex);
+	for (;;) {
+		while ((render_taken == render_queued || render_syncing) && !render_quit) {
+			SDL_CondWait(render_work, render_mutex);
+		}
+		if (render_quit) {
+			break;
+		}
+		const uint32_t index = render_taken++;
+		struct render_job *job = &render_queue[index % RENDER_QUEUE_SIZE];
+		if (job->log_begin != job->log_end) {
+			// the earlier lines still need the old contents
+			render_syncing = true;
+			while (render_finished != index) {
+				SDL_CondWait(render_done, render_mutex);
+			}
+			for (uint32_t i = job->log_begin; i != job->log_end; i++) {
+				const uint32_t slot = i % RENDER_PAGES;
+				memcpy(&render_vram[render_log_page[slot] * RENDER_PAGE_SIZE], render_log[slot], RENDER_PAGE_SIZE);
+			}
+			render_log_tail = job->log_end;
+			render_syncing = false;
+			SDL_CondBroadcast(render_work);
+		}
+		SDL_UnlockMutex(render_mutex);
+
+		render_job_line(job, col_line);
+
+		SDL_LockMutex(render_mutex);
+		job->busy = false;
+		render_finished++;
+		SDL_CondBroadcast(render_done);
+	}
+	SDL_UnlockMutex(render_mutex);
+	return 0;
+}
+
+static void
+render_threads_start(int count)
+{
+	render_mutex = SDL_CreateMutex();
+	render_work = SDL_CreateCond();
+	render_done = SDL_CreateCond();
+	for (num_render_threads = 0; num_render_threads < count; num_render_threads++) {
+		SDL_Thread *thread = SDL_CreateThread(render_thread, "render", NULL);
+		if (!thread) {
+			break;
+		}
+		render_thread_handles[num_render_threads] = thread;
+	}
+	render_threads_running = num_render_threads > 0;
+}
+
+static void
+render_threads_stop()
+{
+	if (!render_mutex) {
+		return;
+	}
+	SDL_LockMutex(render_mutex);
+	render_quit = true;
+	SDL_CondBroadcast(render_work);
+	SDL_UnlockMutex(render_mutex);
+	for (int i = 0; i < num_render_threads; i++) {
+		SDL_WaitThread(render_thread_handles[i], NULL);
+	}
+	render_threads_running = false;
+	render_pending = false;
+	SDL_DestroyCond(render_done);
+	SDL_DestroyCond(render_work);
+	SDL_DestroyMutex(render_mutex);
+	render_mutex = NULL;
+}
+
+// Waits until all queued lines have been rendered. Must be called before
+// anything the render threads read is changed, and before the
+// framebuffer is used.
+static void
+render_wait()
+{
+	if (!render_pending) {
+		return;
+	}
+	SDL_LockMutex(render_mutex);
+	while (render_finished != render_queued) {
+		SDL_CondWait(render_done, render_mutex);
+	}
+	SDL_UnlockMutex(render_mutex);
+	render_pending = false;
+}
+
+void
+video_render_wait()
+{
+	render_wait();
+}
+
+// Notes a write to video RAM for the render threads
+static inline void
+render_vram_written(uint32_t address)
+{
+	const uint32_t page = (address & 0x1FFFF) >> RENDER_PAGE_SHIFT;
+	if (!render_page_dirty[page]) {
+		render_page_dirty[page] = true;
+		render_dirty_pages[render_num_dirty++] = page;
+	}
+}
+
+// Brings the render threads' copy of video RAM up to date after all of
+// it has been replaced
+static void
+render_vram_reset()
+{
+	render_wait();
+	memcpy(render_vram, video_ram, sizeof(video_ram));
+	memset(render_page_dirty, 0, sizeof(render_page_dirty));
+	render_num_dirty = 0;
+}
+
+// Hands the pages written since the last queued line to a job
+static void
+render_log_pages(struct render_job *job)
+{
+	job->log_begin = job->log_end = render_log_head;
+	if (!render_num_dirty) {
+		return;
+	}
+
+	SDL_LockMutex(render_mutex);
+	bool idle = render_finished == render_queued;
+	const uint32_t space = RENDER_PAGES - (render_log_head - render_log_tail);
+	SDL_UnlockMutex(render_mutex);
+	if (!idle && render_num_dirty > space) {
+		render_wait();
+		idle = true;
+	}
+
+	for (int i = 0; i < render_num_dirty; i++) {
+		const uint16_t page = render_dirty_pages[i];
+		if (idle) {
+			// no thread is reading it
+			memcpy(&render_vram[page * RENDER_PAGE_SIZE], &video_ram[page * RENDER_PAGE_SIZE], RENDER_PAGE_SIZE);
+		} else {
+			const uint32_t slot = render_log_head++ % RENDER_PAGES;
+			render_log_page[slot] = page;
+			memcpy(render_log[slot], &video_ram[page * RENDER_PAGE_SIZE], RENDER_PAGE_SIZE);
+		}
+		render_page_dirty[page] = false;
+	}
+	render_num_dirty = 0;
+	job->log_end = render_log_head;
+}
+
+static void
+render_queue_line(uint16_t y, uint16_t eff_y)
+{
+	struct render_job *job = &render_queue[render_queued % RENDER_QUEUE_SIZE];
+
+	SDL_LockMutex(render_mutex);
+	while (job->busy) {
+		SDL_CondWait(render_done, render_mutex);
+	}
+	SDL_UnlockMutex(render_mutex);
+
+	job->y = y;
+	job->eff_y = eff_y;
+	memcpy(job->composer, reg_composer, sizeof(job->composer));
+	memcpy(job->props, prev_layer_properties, sizeof(job->props));
+	for (uint8_t layer = 0; layer < NUM_LAYERS; layer++) {
+		job->bitmap_palette_offset[layer] = reg_layer[layer][4] & 0xf;
+		if (!layer_line_enable[layer]) {
+			// keeps whatever was left when the layer got disabled
+			memcpy(job->layer_line[layer], layer_line[layer], SCREEN_WIDTH);
+		}
+	}
+	memcpy(job->sprite_col, sprite_line_col, SCREEN_WIDTH);
+	memcpy(job->sprite_z, sprite_line_z, SCREEN_WIDTH);
+	render_log_pages(job);
+
+	SDL_LockMutex(render_mutex);
+	job->busy = true;
+	render_queued++;
+	SDL_CondSignal(render_work);
+	SDL_UnlockMutex(render_mutex);
+	render_pending = true;
+}
+
+////////////////////////////////////////////////////////////
+// Skipping unchanged scanlines (-line-cache)
+////////////////////////////////////////////////////////////
+
+// A line that is rendered in one go is a function of the registers at its
+// start, the palette, the sprites on it and the video RAM its layers read.
+// All of these but the video RAM are kept per line as a fingerprint. For
+// the video RAM, every write stamps its block with the current clock,
+// which advances with every line that is rendered, so a line has to be
+// rendered again if any block it reads has a later stamp than the line.
+// If nothing changed, the framebuffer still holds the line from the last
+// frame.
+
+struct line_fingerprint {
+	bool valid;
+	uint16_t eff_y;
+	uint8_t composer[8];
+	uint8_t bitmap_palette_offset[NUM_LAYERS];
+	struct video_layer_properties props[2][NUM_LAYERS];
+	uint32_t palette_version;
+};
+
+static struct line_fingerprint line_fingerprints[SCREEN_HEIGHT];
+static uint32_t line_rendered[SCREEN_HEIGHT]; // clock when rendered
+
+static void
+line_cache_reset()
+{
+	memset(line_fingerprints, 0, sizeof(line_fingerprints));
+	memset(line_rendered, 0, sizeof(line_rendered));
+	memset(vram_block_written, 0, sizeof(vram_block_written));
+	line_cache_clock = 1;
+}
+
+static bool
+vram_written_since(uint32_t address, uint32_t size, uint32_t clock)
+{
+	const uint32_t first = (address & 0x1FFFF) >> VRAM_BLOCK_SHIFT;
+	const uint32_t count = SDL_min((((address & 0x1FFFF) + size - 1) >> VRAM_BLOCK_SHIFT) - first + 1, NUM_VRAM_BLOCKS);
+
+	bool written = false;
+	for (uint32_t i = 0; i < count; i++) {
+		written |= vram_block_written[(first + i) % NUM_VRAM_BLOCKS] > clock;
+	}
+	return written;
+}
+
+// Whether the video RAM a layer line is rendered from has been written
+// since the clock. Tiles may come from anywhere in the tile data.
+static bool
+layer_line_written_since(const struct video_layer_properties *props, const struct video_layer_properties *props0, uint16_t y, uint32_t clock)
+{
+	if (props->bitmap_mode) {
+		const uint32_t row_bytes = (props->tilew * props->bits_per_pixel) >> 3;
+		return vram_written_since(props->tile_base + (y % props->tileh) * row_bytes, row_bytes, clock);
+	}
+	if (!props->tilew) {
+		return false;
+	}
+
+	const int      eff_y          = calc_layer_eff_y(props0, y);
+	const uint32_t map_addr_begin = calc_layer_map_addr_base2(props, props->min_eff_x, eff_y);
+	const uint32_t map_addr_end   = calc_layer_map_addr_base2(props, props->max_eff_x, eff_y);
+	const uint32_t num_tiles      = props->text_mode ? 256 : 1024;
+
+	return vram_written_since(map_addr_begin, (map_addr_end - map_addr_begin) + 2, clock) ||
+		vram_written_since(props->tile_base, num_tiles << props->tile_size_log2, clock);
+}
+
+// Returns whether the framebuffer already holds the line. Otherwise it is
+// recorded as rendered now, and has to be rendered.
+static bool
+line_cache_lookup(uint16_t y, uint16_t eff_y)
+{
+	struct line_fingerprint fp;
+	memset(&fp, 0, sizeof(fp));
+
+	// stale pixels of a disabled layer or of the sprites are not
+	// part of the fingerprint, so such lines are always rendered
+	fp.valid = sprite_line_empty;
+	fp.eff_y = eff_y;
+	memcpy(fp.composer, reg_composer, sizeof(fp.composer));
+	fp.composer[0] &= 0x7f; // the interlace field changes every frame
+	for (uint8_t layer = 0; layer < NUM_LAYERS; layer++) {
+		if (layer_line_enable[layer]) {
+			fp.bitmap_palette_offset[layer] = reg_layer[layer][4] & 0xf;
+			memcpy(&fp.props[0][layer], &prev_layer_properties[0][layer], sizeof(fp.props[0][layer]));
+			memcpy(&fp.props[1][layer], &prev_layer_properties[1][layer], sizeof(fp.props[1][layer]));
+		} else if (!layer_line_empty[layer]) {
+			fp.valid = false;
+		}
+	}
+	fp.palette_version = palette_version;
+
+	bool hit = fp.valid && !memcmp(&fp, &line_fingerprints[y], sizeof(fp));
+	for (uint8_t layer = 0; layer < NUM_LAYERS && hit; layer++) {
+		if (layer_line_enable[layer] && layer_line_written_since(&fp.props[1][layer], &fp.props[0][layer], eff_y, line_rendered[y])) {
+			hit = false;
+		}
+	}
+	if (hit) {
+		return true;
+	}
+
+	line_fingerprints[y] = fp;
+	line_rendered[y] = line_cache_clock;
+	if (++line_cache_clock == 0) {
+		line_cache_reset();
+	}
+	return false;
+}
+
 static void
 render_line(uint16_t y, float scan_pos_x)
 {
@@ -1217,13 +1933,6 @@ render_line(uint16_t y, float scan_pos_x)
 		eff_x_fp = 0;
 	}
 
-	uint8_t out_mode = reg_composer[0] & 3;
-
-	uint8_t border_color = reg_composer[3];
-	uint16_t hstart = reg_composer[4] << 2;
-	uint16_t hstop = reg_composer[5] << 2;
-	uint16_t vstop = reg_composer[7] << 1;
-
 	uint16_t eff_y = (eff_y_fp >> 16);
 	if (eff_y >= 480) eff_y = 480 - (y & 1);
 
@@ -1237,6 +1946,9 @@ render_line(uint16_t y, float scan_pos_x)
 			for (uint16_t i = s_pos_x_p; i < SCREEN_WIDTH; i++) {
 				layer_line[layer][i] = 0;
 			}
+			if (s_pos_x_p == 0) {
+				layer_line_empty[layer] = true;
+			}
 		}
 		if (s_pos_x_p == 0)
 			old_layer_line_enable[layer] = layer_line_enable[layer];
@@ -1249,6 +1961,9 @@ render_line(uint16_t y, float scan_pos_x)
 			sprite_line_z[i] = 0;
 			sprite_line_mask[i] = 0;
 		}
+		if (s_pos_x_p == 0) {
+			sprite_line_empty = true;
+		}
 	}
 
 	if (s_pos_x_p == 0)
@@ -1260,86 +1975,44 @@ render_line(uint16_t y, float scan_pos_x)
 		render_sprite_line(eff_y);
 	}
 
-	if (warp_mode && (frame_count & 63)) {
+	const bool capturing = SDL_AtomicGet(&capture_frames) != 0;
+
+	if (warp_mode && !capturing && !timing_warp_render_frame(frame_count)) {
 		// sprites were needed for the collision IRQ, but we can skip
 		// everything else if we're in warp mode, most of the time
 		return;
 	}
 
-	if (layer_line_enable[0]) {
-		if (prev_layer_properties[1][0].text_mode) {
-			render_layer_line_text(0, eff_y);
-		} else if (prev_layer_properties[1][0].bitmap_mode) {
-			render_layer_line_bitmap(0, eff_y);
-		} else {
-			render_layer_line_tile(0, eff_y);
-		}
-	}
-	if (layer_line_enable[1]) {
-		if (prev_layer_properties[1][1].text_mode) {
-			render_layer_line_text(1, eff_y);
-		} else if (prev_layer_properties[1][1].bitmap_mode) {
-			render_layer_line_bitmap(1, eff_y);
-		} else {
-			render_layer_line_tile(1, eff_y);
-		}
+	if (headless && !capturing) {
+		return;
 	}
 
-	// If video output is enabled, calculate color indices for line.
-	if (out_mode != 0) {
-		// Add border after if required.
-		if (y < vstart || y >= vstop) {
-			uint32_t border_fill = border_color;
-			border_fill = border_fill | (border_fill << 8);
-			border_fill = border_fill | (border_fill << 16);
-			memset(col_line, border_fill, SCREEN_WIDTH);
-		} else {
-			hstart = hstart < 640 ? hstart : 640;
-			hstop = hstop < 640 ? hstop : 640;
-
-			for (uint16_t x = s_pos_x_p; x < hstart && x < s_pos_x; ++x) {
-				col_line[x] = border_color;
-			}
-
-			const uint32_t scale = reg_composer[1];
-			for (uint16_t x = MAX(hstart, s_pos_x_p); x < hstop && x < s_pos_x; ++x) {
-				uint16_t eff_x = eff_x_fp >> 16;
-				col_line[x] = (eff_x < SCREEN_WIDTH) ? calculate_line_col_index(sprite_line_z[eff_x], sprite_line_col[eff_x], layer_line[0][eff_x], layer_line[1][eff_x]) : 0;
-				eff_x_fp += (scale << 9);
-			}
-			for (uint16_t x = hstop; x < s_pos_x; ++x) {
-				col_line[x] = border_color;
-			}
+	if (line_cache) {
+		if (s_pos_x_p != 0 || s_pos_x != SCREEN_WIDTH) {
+			// split lines are always rendered
+			line_fingerprints[y].valid = false;
+		} else if (line_cache_lookup(y, eff_y)) {
+			s_pos_x_p = s_pos_x;
+			return;
 		}
 	}
 
-	// Look up all color indices.
-	uint32_t* framebuffer4_begin = ((uint32_t*)framebuffer) + (y * SCREEN_WIDTH) + s_pos_x_p;
-	{
-		uint32_t* framebuffer4 = framebuffer4_begin;
-		for (uint16_t x = s_pos_x_p; x < s_pos_x; x++) {
-			*framebuffer4++ = video_palette.entries[col_line[x]];
-		}
+	if (render_threads_running && s_pos_x_p == 0 && s_pos_x == SCREEN_WIDTH) {
+		// the whole line at once, so it can be left to the render threads
+		render_queue_line(y, eff_y);
+		s_pos_x_p = s_pos_x;
+		return;
 	}
 
-	// NTSC overscan
-	if (out_mode == 2) {
-		uint32_t* framebuffer4 = framebuffer4_begin;
-		for (uint16_t x = s_pos_x_p; x < s_pos_x; x++)
-		{
-			if (x < SCREEN_WIDTH * TITLE_SAFE_X ||
-				x > SCREEN_WIDTH * (1 - TITLE_SAFE_X) ||
-				y < SCREEN_HEIGHT * TITLE_SAFE_Y ||
-				y > SCREEN_HEIGHT * (1 - TITLE_SAFE_Y)) {
-
-				// Divide RGB elements by 4.
-				*framebuffer4 &= 0x00fcfcfc;
-				*framebuffer4 >>= 2;
-			}
-			framebuffer4++;
+	for (uint8_t layer = 0; layer < NUM_LAYERS; layer++) {
+		if (layer_line_enable[layer]) {
+			render_layer_line(video_ram, &prev_layer_properties[1][layer], &prev_layer_properties[0][layer], reg_layer[layer][4] & 0xf, layer_line[layer], eff_y);
+			layer_line_empty[layer] = false;
 		}
 	}
 
+	compose_line(reg_composer, y, s_pos_x_p, s_pos_x, &eff_x_fp, sprite_line_col, sprite_line_z, layer_line, col_line);
+
 	s_pos_x_p = s_pos_x;
 }
 
@@ -1367,20 +2040,22 @@ video_step(float mhz, float steps, bool midline)
 	bool new_frame = false;
 	vga_scan_pos_x += PIXEL_FREQ * steps / mhz;
 	if (vga_scan_pos_x > VGA_SCAN_WIDTH) {
-		vga_scan_pos_x -= VGA_SCAN_WIDTH;
-		if (!ntsc_mode) {
-			render_line(vga_scan_pos_y - VGA_Y_OFFSET, VGA_SCAN_WIDTH);
-		}
-		vga_scan_pos_y++;
-		if (vga_scan_pos_y == SCAN_HEIGHT) {
-			vga_scan_pos_y = 0;
+		while (vga_scan_pos_x > VGA_SCAN_WIDTH) {
+			vga_scan_pos_x -= VGA_SCAN_WIDTH;
 			if (!ntsc_mode) {
-				new_frame = true;
-				frame_count++;
-	}
-		}
-		if (!ntsc_mode) {
-			update_isr_and_coll(vga_scan_pos_y - VGA_Y_OFFSET, irq_line);
+				render_line(vga_scan_pos_y - VGA_Y_OFFSET, VGA_SCAN_WIDTH);
+			}
+			vga_scan_pos_y++;
+			if (vga_scan_pos_y == SCAN_HEIGHT) {
+				vga_scan_pos_y = 0;
+				if (!ntsc_mode) {
+					new_frame = true;
+					frame_count++;
+				}
+			}
+			if (!ntsc_mode) {
+				update_isr_and_coll(vga_scan_pos_y - VGA_Y_OFFSET, irq_line);
+			}
 		}
 	} else if (midline) {
 		if (!ntsc_mode) {
@@ -1389,42 +2064,44 @@ video_step(float mhz, float steps, bool midline)
 	}
 	ntsc_half_cnt += PIXEL_FREQ * steps / mhz;
 	if (ntsc_half_cnt > NTSC_HALF_SCAN_WIDTH) {
-		ntsc_half_cnt -= NTSC_HALF_SCAN_WIDTH;
-		if (ntsc_mode) {
-			if (ntsc_scan_pos_y < SCAN_HEIGHT) {
-				y = ntsc_scan_pos_y - NTSC_Y_OFFSET_LOW;
-				if ((y & 1) == 0) {
-					render_line(y, NTSC_HALF_SCAN_WIDTH);
+		while (ntsc_half_cnt > NTSC_HALF_SCAN_WIDTH) {
+			ntsc_half_cnt -= NTSC_HALF_SCAN_WIDTH;
+			if (ntsc_mode) {
+				if (ntsc_scan_pos_y < SCAN_HEIGHT) {
+					y = ntsc_scan_pos_y - NTSC_Y_OFFSET_LOW;
+					if ((y & 1) == 0) {
+						render_line(y, NTSC_HALF_SCAN_WIDTH);
+					}
+				} else {
+					y = ntsc_scan_pos_y - NTSC_Y_OFFSET_HIGH;
+					if ((y & 1) == 0) {
+						render_line(y | 1, NTSC_HALF_SCAN_WIDTH);
+					}
 				}
-			} else {
-				y = ntsc_scan_pos_y - NTSC_Y_OFFSET_HIGH;
-				if ((y & 1) == 0) {
-					render_line(y | 1, NTSC_HALF_SCAN_WIDTH);
+			}
+			ntsc_scan_pos_y++;
+			if (ntsc_scan_pos_y == SCAN_HEIGHT) {
+				reg_composer[0] |= 0x80;
+				if (ntsc_mode) {
+					new_frame = true;
+					frame_count++;
 				}
 			}
-		}
-		ntsc_scan_pos_y++;
-		if (ntsc_scan_pos_y == SCAN_HEIGHT) {
-			reg_composer[0] |= 0x80;
-			if (ntsc_mode) {
-				new_frame = true;
-				frame_count++;
+			if (ntsc_scan_pos_y == SCAN_HEIGHT*2) {
+				reg_composer[0] &= ~0x80;
+				ntsc_scan_pos_y = 0;
+				if (ntsc_mode) {
+					new_frame = true;
+					frame_count++;
+				}
 			}
-		}
-		if (ntsc_scan_pos_y == SCAN_HEIGHT*2) {
-			reg_composer[0] &= ~0x80;
-			ntsc_scan_pos_y = 0;
 			if (ntsc_mode) {
-				new_frame = true;
-				frame_count++;
-			}
-		}
-		if (ntsc_mode) {
-			// this is correct enough for even screen heights
-			if (ntsc_scan_pos_y < SCAN_HEIGHT) {
-				update_isr_and_coll(ntsc_scan_pos_y - NTSC_Y_OFFSET_LOW, irq_line & ~1);
-			} else {
-				update_isr_and_coll(ntsc_scan_pos_y - NTSC_Y_OFFSET_HIGH, irq_line & ~1);
+				// this is correct enough for even screen heights
+				if (ntsc_scan_pos_y < SCAN_HEIGHT) {
+					update_isr_and_coll(ntsc_scan_pos_y - NTSC_Y_OFFSET_LOW, irq_line & ~1);
+				} else {
+					update_isr_and_coll(ntsc_scan_pos_y - NTSC_Y_OFFSET_HIGH, irq_line & ~1);
+				}
 			}
 		}
 	} else if (midline) {
@@ -1443,9 +2120,80 @@ video_step(float mhz, float steps, bool midline)
 		}
 	}
 
+	if (new_frame) {
+		// the frame is about to be presented
+		render_wait();
+	}
+	// other threads only ever add to capture_frames, so it can't drop
+	// to zero between the check and the decrement
+	if (new_frame && SDL_AtomicGet(&capture_frames)) {
+		SDL_AtomicAdd(&capture_frames, -1);
+	}
 	return new_frame;
 }
 
+// number of CPU clocks until the next scanline boundary, where the
+// line/VSYNC/sprite collision interrupts can be raised
+uint32_t
+video_next_event(float mhz)
+{
+	float pixels = VGA_SCAN_WIDTH - vga_scan_pos_x;
+	float ntsc_pixels = NTSC_HALF_SCAN_WIDTH - ntsc_half_cnt;
+	if (ntsc_pixels < pixels) {
+		pixels = ntsc_pixels;
+	}
+	if (pixels <= 0) {
+		return 1;
+	}
+	return (uint32_t)(pixels * mhz / PIXEL_FREQ) + 1;
+}
+
+// number of CPU clocks until the next scanline boundary at which the
+// interrupt output can change or a frame is completed, for skipping ahead
+// while the CPU is waiting for an interrupt
+uint32_t
+video_next_irq_event(float mhz)
+{
+	if ((reg_composer[0] & 2) || (ien & 8)) {
+		// NTSC fields and the PCM FIFO are only tracked line by line
+		return video_next_event(mhz);
+	}
+
+	// scanline boundaries to go until the frame ends...
+	unsigned lines = SCAN_HEIGHT - vga_scan_pos_y;
+	// ...or the VSYNC/sprite collision interrupt is raised...
+	if (ien & 5) {
+		unsigned vsync = SCREEN_HEIGHT + VGA_Y_OFFSET;
+		lines = SDL_min(lines, (vsync - vga_scan_pos_y - 1 + SCAN_HEIGHT) % SCAN_HEIGHT + 1);
+	}
+	// ...or the line interrupt is raised
+	if ((ien & 2) && irq_line + VGA_Y_OFFSET < SCAN_HEIGHT) {
+		unsigned line = irq_line + VGA_Y_OFFSET;
+		lines = SDL_min(lines, (line - vga_scan_pos_y - 1 + SCAN_HEIGHT) % SCAN_HEIGHT + 1);
+	}
+
+	float pixels = (lines - 1) * VGA_SCAN_WIDTH + VGA_SCAN_WIDTH - vga_scan_pos_x;
+	if (pixels <= 0) {
+		return 1;
+	}
+	return (uint32_t)(pixels * mhz / PIXEL_FREQ) + 1;
+}
+
+// In headless mode, render the rest of the current frame and the next
+// complete one into the framebuffer. Concurrent requests add up, so none
+// of them is lost.
+void
+video_request_capture()
+{
+	SDL_AtomicAdd(&capture_frames, 2);
+}
+
+bool
+video_capture_pending()
+{
+	return SDL_AtomicGet(&capture_frames) != 0;
+}
+
 bool
 video_get_irq_out()
 {
@@ -1467,6 +2215,216 @@ video_save(SDL_RWops *f)
 	SDL_RWwrite(f, &sprite_data[0], sizeof(uint8_t), sizeof(sprite_data));
 }
 
+void
+video_state()
+{
+	render_wait();
+	state_memory(video_ram, sizeof(video_ram), video_ram_dirty);
+	STATE_FIELD(palette);
+	STATE_FIELD(sprite_data);
+	STATE_FIELD(reg_layer);
+	STATE_FIELD(reg_composer);
+	STATE_FIELD(prev_reg_composer);
+
+	STATE_FIELD(io_addr);
+	STATE_FIELD(io_rddata);
+	STATE_FIELD(io_inc);
+	STATE_FIELD(io_addrsel);
+	STATE_FIELD(io_dcsel);
+	STATE_FIELD(ien);
+	STATE_FIELD(isr);
+	STATE_FIELD(irq_line);
+
+	STATE_FIELD(fx_addr1_mode);
+	STATE_FIELD(fx_x_pixel_increment);
+	STATE_FIELD(fx_y_pixel_increment);
+	STATE_FIELD(fx_x_pixel_position);
+	STATE_FIELD(fx_y_pixel_position);
+	STATE_FIELD(fx_poly_fill_length);
+	STATE_FIELD(fx_affine_tile_base);
+	STATE_FIELD(fx_affine_map_base);
+	STATE_FIELD(fx_affine_map_size);
+	STATE_FIELD(fx_4bit_mode);
+	STATE_FIELD(fx_16bit_hop);
+	STATE_FIELD(fx_cache_byte_cycling);
+	STATE_FIELD(fx_cache_fill);
+	STATE_FIELD(fx_cache_write);
+	STATE_FIELD(fx_trans_writes);
+	STATE_FIELD(fx_2bit_poly);
+	STATE_FIELD(fx_2bit_poking);
+	STATE_FIELD(fx_cache_increment_mode);
+	STATE_FIELD(fx_cache_nibble_index);
+	STATE_FIELD(fx_cache_byte_index);
+	STATE_FIELD(fx_multiplier);
+	STATE_FIELD(fx_subtract);
+	STATE_FIELD(fx_affine_clip);
+	STATE_FIELD(fx_16bit_hop_align);
+	STATE_FIELD(fx_nibble_bit);
+	STATE_FIELD(fx_nibble_incr);
+	STATE_FIELD(fx_cache);
+	STATE_FIELD(fx_mult_accumulator);
+
+	STATE_FIELD(sprite_line_collisions);
+	STATE_FIELD(vga_scan_pos_x);
+	STATE_FIELD(vga_scan_pos_y);
+	STATE_FIELD(ntsc_half_cnt);
+	STATE_FIELD(ntsc_scan_pos_y);
+	STATE_FIELD(frame_count);
+
+	if (state_loading()) {
+		// rebuild everything that is derived from the registers
+		for (int layer = 0; layer < NUM_LAYERS; layer++) {
+			refresh_layer_properties(layer);
+		}
+		memcpy(prev_layer_properties[0], layer_properties, sizeof(layer_properties));
+		memcpy(prev_layer_properties[1], layer_properties, sizeof(layer_properties));
+		for (int sprite = 0; sprite < 128; sprite++) {
+			refresh_sprite_properties(sprite);
+		}
+		refresh_palette();
+		render_vram_reset();
+		line_cache_reset();
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Presentation thread (-present-thread)
+////////////////////////////////////////////////////////////
+
+// The texture upload and SDL_RenderPresent(), which can wait for vsync or
+// the compositor, are done by a thread of their own that owns the
+// renderer. Finished frames are handed over through three buffers: the
+// emulation thread fills one, the presentation thread shows another, and
+// the third holds the latest finished frame. The two threads exchange
+// their buffer with that one atomically, so neither ever waits for the
+// other; if frames come in faster than they can be shown, the older ones
+// are dropped. Events are still polled by the emulation thread, since SDL
+// only delivers them to the thread that initialized the video subsystem.
+
+#define PRESENT_NEW 4 // flag in present_ready: not shown yet
+
+static uint8_t present_buffers[3][SCREEN_WIDTH * SCREEN_HEIGHT * 4];
+static SDL_atomic_t present_ready; // the latest finished frame
+static int present_write;          // only touched by the emulation thread
+static int present_read;           // only touched by the presentation thread
+static float present_x_scale;
+static SDL_Thread *present_thread_handle;
+static SDL_mutex *present_mutex;
+static SDL_cond *present_wakeup;
+static bool present_started;
+static bool present_quit;
+static bool present_thread_running;
+
+static int
+present_thread_main(void *data)
+{
+	renderer = SDL_CreateRenderer(window, -1, 0);
+	if (renderer) {
+		SDL_RenderSetLogicalSize(renderer, SCREEN_WIDTH * present_x_scale, SCREEN_HEIGHT);
+		sdlTexture = SDL_CreateTexture(renderer,
+										SDL_PIXELFORMAT_RGB888,
+										SDL_TEXTUREACCESS_STREAMING,
+										SCREEN_WIDTH, SCREEN_HEIGHT);
+	}
+
+	SDL_LockMutex(present_mutex);
+	present_thread_running = renderer != NULL;
+	present_started = true;
+	SDL_CondSignal(present_wakeup);
+	while (present_thread_running && !present_quit) {
+		if (!(SDL_AtomicGet(&present_ready) & PRESENT_NEW)) {
+			SDL_CondWait(present_wakeup, present_mutex);
+			continue;
+		}
+		SDL_UnlockMutex(present_mutex);
+
+		SDL_MemoryBarrierRelease();
+		present_read = SDL_AtomicSet(&present_ready, present_read) & ~PRESENT_NEW;
+		SDL_MemoryBarrierAcquire();
+		SDL_UpdateTexture(sdlTexture, NULL, present_buffers[present_read], SCREEN_WIDTH * 4);
+		SDL_RenderClear(renderer);
+		SDL_RenderCopy(renderer, sdlTexture, NULL, NULL);
+		SDL_RenderPresent(renderer);
+
+		SDL_LockMutex(present_mutex);
+	}
+	SDL_UnlockMutex(present_mutex);
+
+	if (renderer) {
+		SDL_DestroyTexture(sdlTexture);
+		SDL_DestroyRenderer(renderer);
+		sdlTexture = NULL;
+		renderer = NULL;
+	}
+	return 0;
+}
+
+// Returns false if the renderer could not be set up on a thread of its
+// own, so it has to be done by the caller.
+static bool
+present_thread_start(float screen_x_scale)
+{
+	present_x_scale = screen_x_scale;
+	present_write = 0;
+	SDL_AtomicSet(&present_ready, 1);
+	present_read = 2;
+	present_started = false;
+	present_quit = false;
+
+	present_mutex = SDL_CreateMutex();
+	present_wakeup = SDL_CreateCond();
+	SDL_LockMutex(present_mutex);
+	present_thread_handle = SDL_CreateThread(present_thread_main, "present", NULL);
+	// wait until the renderer has been created
+	while (present_thread_handle && !present_started) {
+		SDL_CondWait(present_wakeup, present_mutex);
+	}
+	SDL_UnlockMutex(present_mutex);
+
+	if (!present_thread_running) {
+		present_thread_stop();
+		return false;
+	}
+	return true;
+}
+
+static void
+present_thread_stop()
+{
+	if (!present_mutex) {
+		return;
+	}
+	SDL_LockMutex(present_mutex);
+	present_quit = true;
+	SDL_CondSignal(present_wakeup);
+	SDL_UnlockMutex(present_mutex);
+	if (present_thread_handle) {
+		SDL_WaitThread(present_thread_handle, NULL);
+		present_thread_handle = NULL;
+	}
+	present_thread_running = false;
+	SDL_DestroyCond(present_wakeup);
+	SDL_DestroyMutex(present_mutex);
+	present_mutex = NULL;
+}
+
+// Hands the framebuffer to the presentation thread
+static void
+present_frame()
+{
+	memcpy(present_buffers[present_write], framebuffer, sizeof(framebuffer));
+	// SDL_AtomicSet() alone only orders like an acquire: the release makes
+	// the frame visible before its index, the acquire keeps the presenter's
+	// last reads of the buffer we get back ahead of overwriting it.
+	SDL_MemoryBarrierRelease();
+	present_write = SDL_AtomicSet(&present_ready, present_write | PRESENT_NEW) & ~PRESENT_NEW;
+	SDL_MemoryBarrierAcquire();
+
+	SDL_LockMutex(present_mutex);
+	SDL_CondSignal(present_wakeup);
+	SDL_UnlockMutex(present_mutex);
+}
+
 bool
 video_update()
 {
@@ -1489,9 +2447,17 @@ video_update()
 			framebuffer[(y * SCREEN_WIDTH + x) * 4 + 2] = r;
 			framebuffer[(y * SCREEN_WIDTH + x) * 4 + 3] = 0x00;
 		}
+		if (activity_led) {
+			// the LED is part of the framebuffer now
+			line_fingerprints[y].valid = false;
+		}
 	}
 
-	SDL_UpdateTexture(sdlTexture, NULL, framebuffer, SCREEN_WIDTH * 4);
+	if (present_thread_running) {
+		present_frame();
+	} else {
+		SDL_UpdateTexture(sdlTexture, NULL, framebuffer, SCREEN_WIDTH * 4);
+	}
 
 	if (record_gif > RECORD_GIF_PAUSED) {
 		if(!GifWriteFrame(&gif_writer, framebuffer, SCREEN_WIDTH, SCREEN_HEIGHT, 2, 8, false)) {
@@ -1505,17 +2471,19 @@ video_update()
 		}
 	}
 
-	SDL_RenderClear(renderer);
-	SDL_RenderCopy(renderer, sdlTexture, NULL, NULL);
+	if (!present_thread_running) {
+		SDL_RenderClear(renderer);
+		SDL_RenderCopy(renderer, sdlTexture, NULL, NULL);
+
+		if (debugger_enabled && showDebugOnRender != 0) {
+			DEBUGRenderDisplay(SCREEN_WIDTH, SCREEN_HEIGHT);
+			SDL_RenderPresent(renderer);
+			return true;
+		}
 
-	if (debugger_enabled && showDebugOnRender != 0) {
-		DEBUGRenderDisplay(SCREEN_WIDTH, SCREEN_HEIGHT);
 		SDL_RenderPresent(renderer);
-		return true;
 	}
 
-	SDL_RenderPresent(renderer);
-
 	SDL_Event event;
 	while (SDL_PollEvent(&event)) {
 		if (event.type == SDL_QUIT) {
@@ -1549,6 +2517,15 @@ video_update()
 				} else if (event.key.keysym.sym == SDLK_d) {
 					sdcard_detach();
 					consumed = true;
+				} else if (event.key.keysym.sym == SDLK_F5) {
+					machine_save_state(NULL);
+					consumed = true;
+				} else if (event.key.keysym.sym == SDLK_F9) {
+					machine_load_state(NULL);
+					consumed = true;
+				} else if (event.key.keysym.sym == SDLK_z) {
+					machine_rewind(REWIND_HOTKEY_FRAMES);
+					consumed = true;
 #ifndef __EMSCRIPTEN__
 				} else if (event.key.keysym.sym == SDLK_p) {
 					if (video_take_screenshot()) {
@@ -1582,6 +2559,9 @@ video_update()
 					exit(0);
 				}
 			}
+			if (debugger_enabled && event.key.keysym.scancode == DBGSCANKEY_BRK) {
+				DEBUGBreakToDebugger();
+			}
 			if (!consumed) {
 				if (event.key.keysym.scancode == LSHORTCUT_KEY || event.key.keysym.scancode == RSHORTCUT_KEY) {
 					cmd_down = true;
@@ -1675,6 +2655,8 @@ video_update()
 void
 video_end()
 {
+	render_threads_stop();
+
 	if (debugger_enabled) {
 		DEBUGFreeUI();
 	}
@@ -1684,9 +2666,13 @@ video_end()
 		record_gif = RECORD_GIF_DISABLED;
 	}
 
+	present_thread_stop();
+
 	is_fullscreen = false;
 	SDL_SetWindowFullscreen(window, 0);
-	SDL_DestroyRenderer(renderer);
+	if (renderer) {
+		SDL_DestroyRenderer(renderer);
+	}
 	SDL_DestroyWindow(window);
 }
 
@@ -1830,14 +2816,15 @@ video_space_read(uint32_t address)
 	return video_ram[address & 0x1FFFF];
 }
 
+// Reads from video RAM, or from the render threads' copy of it
 static void
-video_space_read_range(uint8_t* dest, uint32_t address, uint32_t size)
+video_space_read_range(const uint8_t *vram, uint8_t* dest, uint32_t address, uint32_t size)
 {
 	if (address >= ADDR_VRAM_START && (address+size) <= ADDR_VRAM_END) {
-		memcpy(dest, &video_ram[address], size);
+		memcpy(dest, &vram[address], size);
 	} else {
 		for(int i = 0; i < size; ++i) {
-			*dest++ = video_space_read(address + i);
+			*dest++ = vram[(address + i) & 0x1FFFF];
 		}
 	}
 }
@@ -1845,7 +2832,10 @@ video_space_read_range(uint8_t* dest, uint32_t address, uint32_t size)
 void
 video_space_write(uint32_t address, uint8_t value)
 {
+	render_vram_written(address);
 	video_ram[address & 0x1FFFF] = value;
+	video_ram_dirty[(address & 0x1FFFF) / STATE_PAGE_SIZE] = 1;
+	vram_block_written[(address & 0x1FFFF) >> VRAM_BLOCK_SHIFT] = line_cache_clock;
 
 	if (address >= ADDR_PSG_START && address < ADDR_PSG_END) {
 		audio_render();
@@ -1863,6 +2853,7 @@ video_space_write(uint32_t address, uint8_t value)
 void
 fx_video_space_write(uint32_t address, bool nibble, uint8_t value)
 {
+	render_vram_written(address);
 	if (fx_4bit_mode) {
 		if (nibble) {
 			if (!fx_trans_writes || (value & 0x0f) > 0) {
@@ -1876,6 +2867,8 @@ fx_video_space_write(uint32_t address, bool nibble, uint8_t value)
 	} else {
 		if (!fx_trans_writes || value > 0) video_ram[address & 0x1FFFF] = value;
 	}
+	video_ram_dirty[(address & 0x1FFFF) / STATE_PAGE_SIZE] = 1;
+	vram_block_written[(address & 0x1FFFF) >> VRAM_BLOCK_SHIFT] = line_cache_clock;
 	if (address >= ADDR_PSG_START && address < ADDR_PSG_END) {
 		audio_render();
 		psg_writereg(address & 0x3f, value);
@@ -1891,6 +2884,7 @@ fx_video_space_write(uint32_t address, bool nibble, uint8_t value)
 void
 fx_vram_cache_write(uint32_t address, uint8_t value, uint8_t mask)
 {
+	render_vram_written(address);
 	if (!fx_trans_writes || value > 0) {
 		switch (mask) {
 			case 0:
@@ -1906,6 +2900,8 @@ fx_vram_cache_write(uint32_t address, uint8_t value, uint8_t mask)
 				// Do nothing
 				break;
 		}
+		video_ram_dirty[(address & 0x1FFFF) / STATE_PAGE_SIZE] = 1;
+		vram_block_written[(address & 0x1FFFF) >> VRAM_BLOCK_SHIFT] = line_cache_clock;
 	}
 }
 
@@ -2021,6 +3017,9 @@ uint8_t video_read(uint8_t reg, bool debugOn) {
 			uint32_t address = get_and_inc_address(reg - 3, false);
 
 			uint8_t value = io_rddata[reg - 3];
+			if (debugWatchVRAM & WATCH_READ) {
+				DEBUGWatchAccess(WATCH_VRAM, address, WATCH_READ, value);
+			}
 
 			if (reg == 4 && fx_addr1_mode == 3)
 				fx_affine_prefetch();
@@ -2158,6 +3157,12 @@ void video_write(uint8_t reg, uint8_t value) {
 		case 0x04: {
 			if (fx_2bit_poking && fx_addr1_mode) {
 				fx_2bit_poking = false;
+				if (debugWatchVRAM & WATCH_WRITE) {
+					DEBUGWatchAccess(WATCH_VRAM, io_addr[1] & 0x1FFFF, WATCH_WRITE, value);
+				}
+				render_vram_written(io_addr[1]);
+				video_ram_dirty[(io_addr[1] & 0x1FFFF) / STATE_PAGE_SIZE] = 1;
+				vram_block_written[(io_addr[1] & 0x1FFFF) >> VRAM_BLOCK_SHIFT] = line_cache_clock;
 				uint8_t mask = value >> 6;
 				switch (mask) {
 					case 0x00:
@@ -2180,6 +3185,9 @@ void video_write(uint8_t reg, uint8_t value) {
 				video_step(MHZ, 0, true); // potential midline raster effect
 			bool nibble = fx_nibble_bit[reg - 3];
 			uint32_t address = get_and_inc_address(reg - 3, true);
+			if (debugWatchVRAM & WATCH_WRITE) {
+				DEBUGWatchAccess(WATCH_VRAM, address, WATCH_WRITE, value);
+			}
 			if (log_video) {
 				printf("WRITE video_space[$%X] = $%02X\n", address, value);
 			}
@@ -2283,7 +3291,9 @@ void video_write(uint8_t reg, uint8_t value) {
 				// progressive mode on, clear the framebuffer
 				if (((reg_composer[0] & 0x8) == 0 && (value & 0x8)) ||
 					((reg_composer[0] & 0x3) == 1 && (value & 0x3) > 1 && (value & 0x8))) {
+					render_wait();
 					memset(framebuffer, 0x00, SCREEN_WIDTH * SCREEN_HEIGHT * 4);
+					line_cache_reset();
 				}
 
 				// interlace field bit is read-only
@@ -12,16 +12,22 @@
 #include "glue.h"
 #include "x16_buffer.h"
 
+#define MAX_RENDER_THREADS 16
+
 bool video_init(int window_scale, float screen_x_scale, char *quality, bool fullscreen, float opacity);
 void video_reset(void);
 bool video_step(float mhz, float steps, bool midline);
+uint32_t video_next_event(float mhz);
+uint32_t video_next_irq_event(float mhz);
 bool video_update(void);
 void video_end(void);
 bool video_get_irq_out(void);
 void video_save(SDL_RWops *f);
+void video_state(void);
 uint8_t video_read(uint8_t reg, bool debugOn);
 void video_write(uint8_t reg, uint8_t value);
 void video_update_title(const char* window_title);
+void video_render_wait(void);
 
 uint8_t via1_read(uint8_t reg, bool debug);
 void via1_write(uint8_t reg, uint8_t value);
@@ -41,6 +47,8 @@ uint8_t video_get_dc_value(uint8_t reg);
 // Screenshot functionality for MCP
 bool video_take_screenshot(void);
 const char* get_last_screenshot_filename(void);
+void video_request_capture(void);
+bool video_capture_pending(void);
 bool capture_text_buffer(uint8_t *buffer, size_t buf_size, int32_t layer, uint32_t *out_width, uint32_t *out_height, int32_t *out_layer);
 
 #endif
@@ -92,6 +92,10 @@ wav_begin(const char *path, int32_t sample_rate)
 		wav_header.fmt.bytes_per_sec   = sample_rate * sizeof(int16_t) * wav_header.fmt.channels;
 		wav_header.fmt.block_align     = sizeof(int16_t) * wav_header.fmt.channels;
 		wav_header.fmt.bits_per_sample = (sizeof(int16_t)) << 3;
+		// The sizes are filled in by wav_end(). Until then, and for good
+		// if the file is a pipe, they say to read up to the end.
+		wav_header.riff.size           = UINT32_MAX;
+		wav_header.data.size           = UINT32_MAX;
 
 		const size_t written = SDL_RWwrite(wav_file, &wav_header, sizeof(file_header), 1);
 		if (written == 0) {
@@ -106,8 +110,9 @@ wav_end()
 {
 	if (wav_file != NULL) {
 		wav_update_sizes();
-		SDL_RWseek(wav_file, 0, RW_SEEK_SET);
-		SDL_RWwrite(wav_file, &wav_header, sizeof(file_header), 1);
+		if (SDL_RWseek(wav_file, 0, RW_SEEK_SET) == 0) {
+			SDL_RWwrite(wav_file, &wav_header, sizeof(file_header), 1);
+		}
 		SDL_RWclose(wav_file);
 		wav_file = NULL;
 	}
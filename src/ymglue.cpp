@@ -1,6 +1,41 @@
 #include "ymglue.h"
 #include "ymfm_opm.h"
+#include "ymfm_fm.ipp" // for fm_engine_base::clock()
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+
+extern "C" {
+#include "state.h"
+}
+
+// The YM2151 with a cheaper way to run it while all operators are silent
+class ym2151_chip : public ymfm::ym2151 {
+	public:
+		ym2151_chip(ymfm::ymfm_interface &intf):
+			ymfm::ym2151(intf)
+		{ }
+
+		// all operators released and fully attenuated
+		bool silent() const {
+			for (uint32_t i = 0; i < fm_engine::OPERATORS; i++) {
+				auto *op = m_fm.debug_operator(i);
+				if (op->debug_eg_state() != ymfm::EG_RELEASE || op->debug_eg_attenuation() != 0x3ff) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Advance the envelope counter, LFO and noise generator as generate()
+		// would, but leave out the operators: silent ones don't change, and
+		// their phase is reset on key on anyway. The output is silence.
+		void generate_silence(uint32_t numsamples) {
+			for (uint32_t samp = 0; samp < numsamples; samp++) {
+				m_fm.clock(0);
+			}
+		}
+};
 
 class ym2151_interface : public ymfm::ymfm_interface {
 	public:
@@ -8,7 +43,8 @@ class ym2151_interface : public ymfm::ymfm_interface {
 			m_chip(*this),
 			m_timers{0, 0},
 			m_busy_timer{ 0 },
-			m_irq_status{ false }
+			m_irq_status{ false },
+			m_modified{ true }
 		{ }
 		~ym2151_interface() { }
 
@@ -44,6 +80,8 @@ class ym2151_interface : public ymfm::ymfm_interface {
 					m_timers[i] = std::max(0, m_timers[i] - (64 * cycles));
 					if (m_timers[i] <= 0) {
 						m_engine->engine_timer_expired(i);
+						// in CSM mode, this keys on all channels
+						m_modified = true;
 					}
 				}
 			}	
@@ -53,26 +91,34 @@ class ym2151_interface : public ymfm::ymfm_interface {
 			if (!ymfm_is_busy()) {
 				m_chip.write_address(addr);
 				m_chip.write_data(value);
+				m_modified = true;
 			} else {
 				printf("YM2151 write received while busy.\n");
 			}
 		}
 
 		void generate(int16_t* output, uint32_t numsamples) {
-			int s = 0;
-			int ls, rs;
+			if (numsamples == 0) {
+				return;
+			}
 			update_clocks(numsamples);
-			for (uint32_t i = 0; i < numsamples; i++) {
-				m_chip.generate(&opm_out);
-				ls = opm_out.data[0];
-				rs = opm_out.data[1];
-				if (ls < -32768) ls = -32768;
-				if (ls > 32767) ls = 32767;
-				if (rs < -32768) rs = -32768;
-				if (rs > 32767) rs = 32767;
-				output[s++] = ls;
-				output[s++] = rs;
+			// Writes only take effect on the next sample, so the chip can't
+			// be treated as silent before it has generated one
+			if (!m_modified && m_chip.silent()) {
+				m_chip.generate_silence(numsamples);
+				memset(output, 0, numsamples * 2 * sizeof(int16_t));
+				return;
+			}
+			while (numsamples > 0) {
+				uint32_t n = std::min(numsamples, (uint32_t)GENERATE_BLOCK);
+				m_chip.generate(opm_out, n);
+				for (uint32_t i = 0; i < n; i++) {
+					*output++ = std::clamp(opm_out[i].data[0], -32768, 32767);
+					*output++ = std::clamp(opm_out[i].data[1], -32768, 32767);
+				}
+				numsamples -= n;
 			}
+			m_modified = false;
 		}
 
 		uint8_t read_status() {
@@ -83,13 +129,53 @@ class ym2151_interface : public ymfm::ymfm_interface {
 			return m_irq_status;
 		}
 
+		// number of samples to generate until one of the timers expires
+		uint32_t samples_until_timer() {
+			uint32_t next = UINT32_MAX;
+			for (int i = 0; i < 2; ++i) {
+				if (m_timers[i] > 0) {
+					next = std::min(next, (uint32_t)(m_timers[i] + 63) / 64);
+				}
+			}
+			return next;
+		}
+
+		// the chip is serialized by ymfm, the timers are ours
+		void state() {
+			std::vector<uint8_t> buffer;
+			uint32_t size = 0;
+			if (!state_loading()) {
+				ymfm::ymfm_saved_state saved(buffer, true);
+				m_chip.save_restore(saved);
+				size = buffer.size();
+			}
+			STATE_FIELD(size);
+			if (size > 0x10000) {
+				// corrupt state, leave the rest of the chunk unread
+				return;
+			}
+			buffer.resize(size);
+			state_field(buffer.data(), size);
+			if (state_loading()) {
+				ymfm::ymfm_saved_state saved(buffer, false);
+				m_chip.save_restore(saved);
+			}
+			STATE_FIELD(m_timers);
+			STATE_FIELD(m_busy_timer);
+			STATE_FIELD(m_irq_status);
+			m_modified = true;
+		}
+
 	private:
-		ymfm::ym2151 m_chip;
+		static constexpr int GENERATE_BLOCK = 64;
+
+		ym2151_chip m_chip;
 		int32_t m_timers[2];
 		int32_t m_busy_timer;
 		bool m_irq_status;
+		bool m_modified; // registers written since the last generated sample
 
-		ymfm::ym2151::output_data opm_out;
+		ymfm::ym2151::output_data opm_out[GENERATE_BLOCK];
 };
 
 namespace {
@@ -128,4 +214,15 @@ extern "C" {
 		else
 			return false;
 	}
+
+	uint32_t YM_samples_until_timer() {
+		if (initialized)
+			return opm_iface.samples_until_timer();
+		else
+			return UINT32_MAX;
+	}
+
+	void YM_state() {
+		opm_iface.state();
+	}
 }
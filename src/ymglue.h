@@ -12,6 +12,8 @@ extern "C" {
 	void YM_stream_update(uint16_t* output, uint32_t numsamples);
 	void YM_write_reg(uint8_t reg, uint8_t val);
 	bool YM_irq(void);
+	uint32_t YM_samples_until_timer(void);
+	void YM_state(void);
 
 #ifdef __cplusplus
 }